@@ -0,0 +1,226 @@
+#include "arcitem.h"
+
+#include <QPainter>
+#include <QPainterPathStroker>
+#include <QtMath>
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+// Punto de la circunferencia en el angulo deg (y de escena hacia abajo)
+QPointF pointAt(const QPointF &center, double radius, double deg)
+{
+    const double rad = qDegreesToRadians(deg);
+    return QPointF(center.x() + std::cos(rad) * radius, center.y() - std::sin(rad) * radius);
+}
+}
+
+QPointF arcPointAt(const ArcPrimitive &arc, double deg)
+{
+    return pointAt(arc.center, arc.radius, deg);
+}
+
+namespace {
+bool onSweep(const ArcPrimitive &arc, const QPointF &p)
+{
+    const QPointF v = p - arc.center;
+    return ArcItem::sweepContains(qRadiansToDegrees(std::atan2(-v.y(), v.x())), arc.startDeg, arc.spanDeg);
+}
+}
+
+int intersectSegmentArc(const QLineF &segment, const ArcPrimitive &arc, QPointF out[2])
+{
+    // |p1 + t*d - c|^2 = r^2, con t en [0, 1]
+    const QPointF d = segment.p2() - segment.p1();
+    const QPointF f = segment.p1() - arc.center;
+    const double a = QPointF::dotProduct(d, d);
+    const double b = 2.0 * QPointF::dotProduct(f, d);
+    const double c = QPointF::dotProduct(f, f) - arc.radius * arc.radius;
+    const double disc = b * b - 4.0 * a * c;
+    if (a <= 0.0 || arc.radius <= 0.0 || disc < 0.0) {
+        return 0;
+    }
+
+    const double sq = std::sqrt(disc);
+    const double roots[2] = {(-b - sq) / (2.0 * a), (-b + sq) / (2.0 * a)};
+    int count = 0;
+    for (int i = 0; i < (sq > 0.0 ? 2 : 1); ++i) {
+        if (roots[i] < 0.0 || roots[i] > 1.0) {
+            continue;
+        }
+        const QPointF p = segment.p1() + d * roots[i];
+        if (onSweep(arc, p)) {
+            out[count++] = p;
+        }
+    }
+    return count;
+}
+
+int intersectArcs(const ArcPrimitive &a, const ArcPrimitive &b, QPointF out[2])
+{
+    const QPointF delta = b.center - a.center;
+    const double dist = std::hypot(delta.x(), delta.y());
+    if (a.radius <= 0.0 || b.radius <= 0.0 || dist <= 1e-9
+        || dist > a.radius + b.radius || dist < std::fabs(a.radius - b.radius)) {
+        return 0;
+    }
+
+    // Distancia desde a.center a la cuerda comun y semicuerda
+    const double along = (dist * dist + a.radius * a.radius - b.radius * b.radius) / (2.0 * dist);
+    const double half = std::sqrt(std::max(0.0, a.radius * a.radius - along * along));
+    const QPointF u = delta / dist;
+    const QPointF base = a.center + u * along;
+    const QPointF normal(-u.y(), u.x());
+    const QPointF candidates[2] = {base + normal * half, base - normal * half};
+
+    int count = 0;
+    for (int i = 0; i < (half > 0.0 ? 2 : 1); ++i) {
+        if (onSweep(a, candidates[i]) && onSweep(b, candidates[i])) {
+            out[count++] = candidates[i];
+        }
+    }
+    return count;
+}
+
+bool ArcItem::sweepContains(double deg, double startDeg, double spanDeg)
+{
+    if (std::fabs(spanDeg) >= 360.0) {
+        return true;
+    }
+    double rel = std::fmod(spanDeg >= 0.0 ? deg - startDeg : startDeg - deg, 360.0);
+    if (rel < 0.0) {
+        rel += 360.0;
+    }
+    return rel <= std::fabs(spanDeg);
+}
+
+ArcItem::ArcItem(QGraphicsItem *parent)
+    : QGraphicsItem(parent)
+{
+}
+
+void ArcItem::setArc(const QPointF &center, double radius, double startDeg, double spanDeg)
+{
+    if (center == m_center && radius == m_radius && startDeg == m_startDeg && spanDeg == m_spanDeg) {
+        return;
+    }
+    prepareGeometryChange();
+    m_center = center;
+    m_radius = radius;
+    m_startDeg = startDeg;
+    m_spanDeg = spanDeg;
+    m_shapeValid = false;
+    updateBounds();
+}
+
+void ArcItem::setPen(const QPen &pen)
+{
+    if (pen == m_pen) {
+        return;
+    }
+    if (pen.widthF() != m_pen.widthF()) {
+        prepareGeometryChange();
+        m_pen = pen;
+        m_shapeValid = false;
+        updateBounds();
+        return;
+    }
+    m_pen = pen;
+    update();
+}
+
+void ArcItem::updateBounds()
+{
+    if (m_radius <= 0.0) {
+        m_bounds = QRectF();
+        return;
+    }
+
+    // Extremos del arco y los puntos cardinales que quedan dentro del barrido
+    const QPointF first = pointAt(m_center, m_radius, m_startDeg);
+    QRectF box(first, QSizeF(0.0, 0.0));
+    auto include = [&box](const QPointF &p) {
+        box.setLeft(std::min(box.left(), p.x()));
+        box.setRight(std::max(box.right(), p.x()));
+        box.setTop(std::min(box.top(), p.y()));
+        box.setBottom(std::max(box.bottom(), p.y()));
+    };
+    include(pointAt(m_center, m_radius, m_startDeg + std::clamp(m_spanDeg, -360.0, 360.0)));
+    for (int cardinal = 0; cardinal < 360; cardinal += 90) {
+        if (sweepContains(cardinal, m_startDeg, m_spanDeg)) {
+            include(pointAt(m_center, m_radius, cardinal));
+        }
+    }
+
+    const double half = m_pen.widthF() / 2.0 + 1.0;
+    m_bounds = box.adjusted(-half, -half, half, half);
+}
+
+QRectF ArcItem::boundingRect() const
+{
+    return m_bounds;
+}
+
+QPainterPath ArcItem::shape() const
+{
+    if (!m_shapeValid) {
+        m_shape = QPainterPath();
+        if (m_radius > 0.0) {
+            const QRectF box(m_center.x() - m_radius, m_center.y() - m_radius, m_radius * 2.0, m_radius * 2.0);
+            QPainterPath path;
+            path.arcMoveTo(box, m_startDeg);
+            path.arcTo(box, m_startDeg, std::clamp(m_spanDeg, -360.0, 360.0));
+            QPainterPathStroker stroker(m_pen);
+            m_shape = stroker.createStroke(path);
+        }
+        m_shapeValid = true;
+    }
+    return m_shape;
+}
+
+bool ArcItem::hitLocal(const QPointF &pos, double tolerance) const
+{
+    if (m_radius <= 0.0) {
+        return false;
+    }
+
+    const QPointF v = pos - m_center;
+    const double dist = std::hypot(v.x(), v.y());
+    if (std::fabs(dist - m_radius) <= tolerance
+        && sweepContains(qRadiansToDegrees(std::atan2(-v.y(), v.x())), m_startDeg, m_spanDeg)) {
+        return true;
+    }
+
+    // Fuera del barrido solo cuentan los extremos (remates redondeados)
+    const QPointF a = pointAt(m_center, m_radius, m_startDeg) - pos;
+    const QPointF b = pointAt(m_center, m_radius, m_startDeg + m_spanDeg) - pos;
+    const double tol2 = tolerance * tolerance;
+    return QPointF::dotProduct(a, a) <= tol2 || QPointF::dotProduct(b, b) <= tol2;
+}
+
+bool ArcItem::hitTest(const QPointF &scenePos, double tolerance) const
+{
+    return hitLocal(mapFromScene(scenePos), tolerance);
+}
+
+bool ArcItem::contains(const QPointF &point) const
+{
+    return m_bounds.contains(point) && hitLocal(point, m_pen.widthF() / 2.0);
+}
+
+void ArcItem::paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget)
+{
+    Q_UNUSED(option);
+    Q_UNUSED(widget);
+
+    if (m_radius <= 0.0) {
+        return;
+    }
+    const QRectF box(m_center.x() - m_radius, m_center.y() - m_radius, m_radius * 2.0, m_radius * 2.0);
+    painter->setPen(m_pen);
+    painter->setBrush(Qt::NoBrush);
+    painter->drawArc(box,
+                     qRound(m_startDeg * 16.0),
+                     qRound(std::clamp(m_spanDeg, -360.0, 360.0) * 16.0));
+}
@@ -0,0 +1,74 @@
+#ifndef ARCITEM_H
+#define ARCITEM_H
+
+#include <QGraphicsItem>
+#include <QLineF>
+#include <QPainterPath>
+#include <QPen>
+#include <QPointF>
+#include <QRectF>
+
+// Arco en forma analitica, en coordenadas de escena
+struct ArcPrimitive {
+    QPointF center;
+    double radius = 0.0;
+    double startDeg = 0.0;
+    double spanDeg = 0.0;
+};
+
+// Punto del arco en el angulo deg
+QPointF arcPointAt(const ArcPrimitive &arc, double deg);
+// Cortes (0, 1 o 2) del segmento con el trazo del arco; se escriben en out
+int intersectSegmentArc(const QLineF &segment, const ArcPrimitive &arc, QPointF out[2]);
+// Cortes (0, 1 o 2) entre los trazos de dos arcos; circunferencias coincidentes no cuentan
+int intersectArcs(const ArcPrimitive &a, const ArcPrimitive &b, QPointF out[2]);
+
+// Arco de circunferencia definido por centro, radio y angulos (grados, convenio de Qt: 0 = este,
+// positivo en sentido antihorario). Se pinta con drawArc y el impacto se calcula analiticamente,
+// sin construir un QPainterPath en cada cambio de geometria.
+class ArcItem : public QGraphicsItem
+{
+public:
+    enum { Type = UserType + 1 };
+
+    explicit ArcItem(QGraphicsItem *parent = nullptr);
+
+    void setArc(const QPointF &center, double radius, double startDeg, double spanDeg);
+    void setArc(const ArcPrimitive &arc) { setArc(arc.center, arc.radius, arc.startDeg, arc.spanDeg); }
+    ArcPrimitive arc() const { return {m_center, m_radius, m_startDeg, m_spanDeg}; }
+    QPointF center() const { return m_center; }
+    double radius() const { return m_radius; }
+    double startDeg() const { return m_startDeg; }
+    double spanDeg() const { return m_spanDeg; }
+
+    void setPen(const QPen &pen);
+    QPen pen() const { return m_pen; }
+
+    // deg cae dentro del barrido [startDeg, startDeg + spanDeg] (span puede ser negativo)
+    static bool sweepContains(double deg, double startDeg, double spanDeg);
+
+    // Distancia del punto (coordenadas de escena) a la linea central del arco <= tolerance
+    bool hitTest(const QPointF &scenePos, double tolerance) const;
+
+    int type() const override { return Type; }
+    QRectF boundingRect() const override;
+    QPainterPath shape() const override;
+    bool contains(const QPointF &point) const override;
+    void paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget) override;
+
+private:
+    bool hitLocal(const QPointF &pos, double tolerance) const;
+    void updateBounds();
+
+    QPointF m_center;
+    double m_radius = 0.0;
+    double m_startDeg = 0.0;
+    double m_spanDeg = 0.0;
+    QPen m_pen;
+    QRectF m_bounds;
+    // shape() solo se pide en consultas de colision; se construye al primer uso
+    mutable QPainterPath m_shape;
+    mutable bool m_shapeValid = false;
+};
+
+#endif // ARCITEM_H
@@ -0,0 +1,796 @@
+#include "boardfile.h"
+#include "boardjournal.h"
+#include "chartcatalogue.h"
+#include "chartexporter.h"
+#include "charttiles.h"
+#include "chartview.h"
+#include "dibujos.h"
+#include "intersectionengine.h"
+#include "mainwindow.h"
+#include "navigationdao.h"
+#include "tilecache.h"
+#include "undostack.h"
+#include "vectorexport.h"
+
+#include <QApplication>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QGraphicsItem>
+#include <QGraphicsScene>
+#include <QGraphicsView>
+#include <QImageReader>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMouseEvent>
+#include <QStringList>
+#include <QTemporaryDir>
+#include <QXmlStreamReader>
+#include <QRandomGenerator>
+#include <QtEndian>
+#include <QtTest>
+
+#include <algorithm>
+#include <memory>
+
+namespace {
+constexpr int kSessionsPerUser = 20;
+
+QString benchNick(int index)
+{
+    return QStringLiteral("alumno%1").arg(index, 6, 10, QLatin1Char('0'));
+}
+
+void populate(NavigationDAO &dao, int users, int firstIndex = 0)
+{
+    const QDateTime base(QDate(2020, 1, 1), QTime(9, 0));
+    dao.beginTransaction();
+    for (int i = 0; i < users; ++i) {
+        User user(benchNick(firstIndex + i),
+                  QStringLiteral("alumno%1@escuela.es").arg(firstIndex + i),
+                  QStringLiteral("Passw0rd!"),
+                  QImage(),
+                  QDate(2000, 1, 1));
+        dao.saveUser(user);
+        for (int s = 0; s < kSessionsPerUser; ++s) {
+            dao.addSession(user.nickName(), Session(base.addDays(s * 7), s % 10, 10 - s % 10));
+        }
+    }
+    dao.commitTransaction();
+}
+
+// Envia press/move/release con el boton derecho, como haria el usuario en el viewport
+void dragRight(Dibujos &dibujos, QGraphicsView &view, const QPointF &from, const QPointF &to)
+{
+    QWidget *viewport = view.viewport();
+    QMouseEvent press(QEvent::MouseButtonPress, from, viewport->mapToGlobal(from),
+                      Qt::RightButton, Qt::RightButton, Qt::NoModifier);
+    dibujos.handleEvent(viewport, &press);
+    QMouseEvent move(QEvent::MouseMove, to, viewport->mapToGlobal(to),
+                     Qt::NoButton, Qt::RightButton, Qt::NoModifier);
+    dibujos.handleEvent(viewport, &move);
+    QMouseEvent release(QEvent::MouseButtonRelease, to, viewport->mapToGlobal(to),
+                        Qt::RightButton, Qt::NoButton, Qt::NoModifier);
+    dibujos.handleEvent(viewport, &release);
+}
+
+void clickRight(Dibujos &dibujos, QGraphicsView &view, const QPointF &at)
+{
+    QWidget *viewport = view.viewport();
+    QMouseEvent press(QEvent::MouseButtonPress, at, viewport->mapToGlobal(at),
+                      Qt::RightButton, Qt::RightButton, Qt::NoModifier);
+    dibujos.handleEvent(viewport, &press);
+    QMouseEvent release(QEvent::MouseButtonRelease, at, viewport->mapToGlobal(at),
+                        Qt::RightButton, Qt::NoButton, Qt::NoModifier);
+    dibujos.handleEvent(viewport, &release);
+}
+
+struct DrawingFixture {
+    DrawingFixture()
+    {
+        scene.setSceneRect(0.0, 0.0, 8700.0, 5800.0);
+        view.setScene(&scene);
+        view.resize(1280, 800);
+        dibujos = std::make_unique<Dibujos>(&scene, &view);
+    }
+
+    QGraphicsScene scene;
+    QGraphicsView view;
+    std::unique_ptr<Dibujos> dibujos;
+};
+
+// Lineas de posicion pseudoaleatorias (semilla fija) dentro de la carta
+QVector<QLineF> randomLines(int count)
+{
+    QRandomGenerator rng(1234);
+    QVector<QLineF> lines;
+    lines.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        const QPointF a(321.0 + rng.bounded(8000.0), 437.0 + rng.bounded(4800.0));
+        const QPointF b = a + QPointF(rng.bounded(1600.0) - 800.0, rng.bounded(1600.0) - 800.0);
+        lines.append(QLineF(a, b));
+    }
+    return lines;
+}
+}
+
+class ProyectoBench : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+
+    void daoLoadUsers_data();
+    void daoLoadUsers();
+    void daoInsertUser_data();
+    void daoInsertUser();
+
+    void screenToGeo();
+    void formatDMS();
+
+    void drawAndEraseLine_data();
+    void drawAndEraseLine();
+    void drawAndErasePoint_data();
+    void drawAndErasePoint();
+
+    void intersectionsFull_data();
+    void intersectionsFull();
+    void intersectionsIncremental_data();
+    void intersectionsIncremental();
+
+    void boardLoad_data();
+    void boardLoad();
+    void boardJournalRecover();
+    void undoRedo_data();
+    void undoRedo();
+    void exportPng_data();
+    void exportPng();
+    void exportSvg_data();
+    void exportSvg();
+    void chartTiles_data();
+    void chartTiles();
+    void tileCacheFling_data();
+    void tileCacheFling();
+    void zoomAnimation();
+    void panScroll_data();
+    void panScroll();
+
+    void buildMainWindow();
+
+private:
+    QTemporaryDir m_tmp;
+};
+
+void ProyectoBench::initTestCase()
+{
+    QVERIFY(m_tmp.isValid());
+}
+
+void ProyectoBench::daoLoadUsers_data()
+{
+    QTest::addColumn<int>("users");
+    QTest::newRow("10 usuarios") << 10;
+    QTest::newRow("100 usuarios") << 100;
+    QTest::newRow("1000 usuarios") << 1000;
+}
+
+void ProyectoBench::daoLoadUsers()
+{
+    QFETCH(int, users);
+    NavigationDAO dao(m_tmp.filePath(QStringLiteral("load-%1.sqlite").arg(users)));
+    populate(dao, users);
+
+    QBENCHMARK {
+        const auto loaded = dao.loadUsers();
+        QCOMPARE(loaded.size(), users);
+    }
+}
+
+void ProyectoBench::daoInsertUser_data()
+{
+    daoLoadUsers_data();
+}
+
+void ProyectoBench::daoInsertUser()
+{
+    QFETCH(int, users);
+    NavigationDAO dao(m_tmp.filePath(QStringLiteral("insert-%1.sqlite").arg(users)));
+    populate(dao, users);
+
+    int next = users;
+    QBENCHMARK {
+        User user(benchNick(next++), QStringLiteral("nuevo@escuela.es"),
+                  QStringLiteral("Passw0rd!"), QImage(), QDate(2000, 1, 1));
+        dao.saveUser(user);
+    }
+}
+
+void ProyectoBench::screenToGeo()
+{
+    DrawingFixture fx;
+    double acc = 0.0;
+    QBENCHMARK {
+        for (int i = 0; i < 1000; ++i) {
+            const auto [lat, lon] = fx.dibujos->screenToGeo(321.0 + i * 8.0, 437.0 + i * 4.8);
+            acc += lat + lon;
+        }
+    }
+    QVERIFY(acc != 0.0);
+}
+
+void ProyectoBench::formatDMS()
+{
+    DrawingFixture fx;
+    qsizetype acc = 0;
+    QBENCHMARK {
+        for (int i = 0; i < 1000; ++i) {
+            acc += fx.dibujos->formatDMS(35.6 + i * 0.0006, true).size();
+            acc += fx.dibujos->formatDMS(-6.4 + i * 0.0015, false).size();
+        }
+    }
+    QVERIFY(acc > 0);
+}
+
+void ProyectoBench::drawAndEraseLine_data()
+{
+    QTest::addColumn<int>("existing");
+    QTest::newRow("pizarra vacia") << 0;
+    QTest::newRow("100 lineas") << 100;
+    QTest::newRow("1000 lineas") << 1000;
+}
+
+void ProyectoBench::drawAndEraseLine()
+{
+    QFETCH(int, existing);
+    DrawingFixture fx;
+    fx.dibujos->setDrawLineMode(true);
+    for (int i = 0; i < existing; ++i) {
+        const double y = 20.0 + (i % 700);
+        dragRight(*fx.dibujos, fx.view, QPointF(10.0, y), QPointF(600.0, y + 30.0));
+    }
+
+    const QPointF from(100.0, 100.0);
+    const QPointF to(900.0, 500.0);
+    const QPointF mid = fx.view.mapToScene(((from + to) / 2.0).toPoint());
+    QBENCHMARK {
+        dragRight(*fx.dibujos, fx.view, from, to);
+        bool erased = false;
+        const auto hits = fx.scene.items(mid, Qt::IntersectsItemShape, Qt::DescendingOrder,
+                                         fx.view.transform());
+        for (QGraphicsItem *item : hits) {
+            if (fx.dibujos->eraseLineItem(item)) {
+                erased = true;
+                break;
+            }
+        }
+        QVERIFY(erased);
+    }
+}
+
+void ProyectoBench::drawAndErasePoint_data()
+{
+    QTest::addColumn<int>("existing");
+    QTest::newRow("pizarra vacia") << 0;
+    QTest::newRow("100 puntos") << 100;
+    QTest::newRow("1000 puntos") << 1000;
+}
+
+void ProyectoBench::drawAndErasePoint()
+{
+    QFETCH(int, existing);
+    DrawingFixture fx;
+    fx.dibujos->setDrawPointMode(true);
+    for (int i = 0; i < existing; ++i) {
+        clickRight(*fx.dibujos, fx.view, QPointF(10.0 + (i % 40) * 30.0, 600.0 + (i / 40) * 2.0));
+    }
+
+    const QPointF at(640.0, 300.0);
+    const QPointF sceneAt = fx.view.mapToScene(at.toPoint());
+    QBENCHMARK {
+        clickRight(*fx.dibujos, fx.view, at);
+        bool erased = false;
+        const auto hits = fx.scene.items(sceneAt, Qt::IntersectsItemShape, Qt::DescendingOrder,
+                                         fx.view.transform());
+        for (QGraphicsItem *item : hits) {
+            if (fx.dibujos->erasePointItem(item)) {
+                erased = true;
+                break;
+            }
+        }
+        QVERIFY(erased);
+    }
+}
+
+void ProyectoBench::intersectionsFull_data()
+{
+    QTest::addColumn<int>("lines");
+    QTest::newRow("100 lineas") << 100;
+    QTest::newRow("500 lineas") << 500;
+    QTest::newRow("2000 lineas") << 2000;
+}
+
+void ProyectoBench::intersectionsFull()
+{
+    QFETCH(int, lines);
+    const QVector<QLineF> segments = randomLines(lines);
+    const GeoReference geo = ChartCatalogue::instance().defaultGeoReference();
+    qsizetype acc = 0;
+    QBENCHMARK {
+        IntersectionEngine engine(geo);
+        for (const QLineF &segment : segments) {
+            engine.addSegment(segment);
+        }
+        acc += engine.intersections().size();
+    }
+    QVERIFY(acc > 0);
+}
+
+void ProyectoBench::intersectionsIncremental_data()
+{
+    intersectionsFull_data();
+}
+
+void ProyectoBench::intersectionsIncremental()
+{
+    QFETCH(int, lines);
+    const GeoReference geo = ChartCatalogue::instance().defaultGeoReference();
+    IntersectionEngine engine(geo);
+    for (const QLineF &segment : randomLines(lines)) {
+        engine.addSegment(segment);
+    }
+    engine.addArc({QPointF(4000.0, 2800.0), 1200.0, 0.0, 270.0});
+    engine.intersections();
+
+    const QLineF added(QPointF(400.0, 500.0), QPointF(8300.0, 5200.0));
+    QBENCHMARK {
+        const IntersectionEngine::Id id = engine.addSegment(added);
+        QVERIFY(!engine.intersections().isEmpty());
+        engine.remove(id);
+    }
+}
+
+void ProyectoBench::boardLoad_data()
+{
+    QTest::addColumn<int>("primitives");
+    QTest::newRow("200 primitivas") << 200;
+    QTest::newRow("2000 primitivas") << 2000;
+}
+
+void ProyectoBench::boardLoad()
+{
+    QFETCH(int, primitives);
+    BoardData board;
+    for (const QLineF &line : randomLines(primitives)) {
+        board.lines.append({0, line, qRgb(200, 0, 0), 8.0f});
+        board.points.append({0, line.p1(), qRgb(0, 0, 200)});
+        if (board.arcs.size() < primitives / 10) {
+            board.arcs.append({0, {line.p2(), 300.0, 0.0, 120.0}, qRgb(200, 0, 0), 8.0f});
+        }
+    }
+    const QString path = m_tmp.filePath(QStringLiteral("board-%1.pihm").arg(primitives));
+    QVERIFY(BoardFile::save(path, board));
+
+    DrawingFixture fx;
+    QBENCHMARK {
+        BoardData loaded;
+        QVERIFY(BoardFile::load(path, &loaded));
+        fx.dibujos->importBoard(loaded);
+    }
+    QCOMPARE(fx.dibujos->pointCoordinates().size(), primitives);
+}
+
+// Recuperacion del diario: instantanea mas cambios, ultimo cambio a medias, Clear, diario de una
+// generacion anterior a la instantanea y carta de la pizarra
+void ProyectoBench::boardJournalRecover()
+{
+    const QString dir = m_tmp.filePath(QStringLiteral("journal"));
+    const QString journalPath = QDir(dir).filePath(QStringLiteral("board.journal"));
+
+    BoardData initial;
+    initial.chartId = QStringLiteral("carta-estrecho");
+    initial.points.append({1, QPointF(100.0, 200.0), qRgb(0, 0, 200)});
+    initial.lines.append({2, QLineF(0.0, 0.0, 500.0, 500.0), qRgb(200, 0, 0), 8.0f});
+
+    BoardOp addPoint;
+    addPoint.type = BoardOp::Type::AddPoint;
+    addPoint.point = {3, QPointF(300.0, 400.0), qRgb(0, 200, 0)};
+    BoardOp eraseLine;
+    eraseLine.type = BoardOp::Type::EraseLine;
+    eraseLine.line = initial.lines.first();
+    {
+        BoardJournal journal(dir);
+        journal.start(initial);
+        journal.append(addPoint);
+        journal.append(eraseLine);
+        journal.stop();
+    }
+
+    // Un cambio cortado al escribirse: la cabecera promete mas bytes de los que hay
+    {
+        QFile file(journalPath);
+        QVERIFY(file.open(QIODevice::WriteOnly | QIODevice::Append));
+        const QByteArray payload = BoardFile::encodeOp(addPoint);
+        QByteArray frame(6, Qt::Uninitialized);
+        qToLittleEndian(static_cast<quint32>(payload.size()), frame.data());
+        qToLittleEndian(qChecksum(QByteArrayView(payload)), frame.data() + 4);
+        file.write(frame + payload.left(payload.size() / 2));
+    }
+    QFile oldJournalFile(journalPath);
+    QVERIFY(oldJournalFile.open(QIODevice::ReadOnly));
+    const QByteArray oldJournal = oldJournalFile.readAll();
+    oldJournalFile.close();
+
+    BoardData recovered;
+    {
+        BoardJournal journal(dir);
+        QVERIFY(journal.recover(&recovered));
+        QCOMPARE(recovered.chartId, initial.chartId);
+        QCOMPARE(recovered.points.size(), 2);
+        QCOMPARE(recovered.points.at(1).id, addPoint.point.id);
+        QCOMPARE(recovered.lines.size(), 0);
+
+        // Arrancar escribe una instantanea de la generacion siguiente; despues se vacia la pizarra
+        journal.start(recovered);
+        BoardOp clear;
+        clear.type = BoardOp::Type::Clear;
+        journal.append(clear);
+        BoardOp addLine;
+        addLine.type = BoardOp::Type::AddLine;
+        addLine.line = {4, QLineF(10.0, 10.0, 20.0, 20.0), qRgb(200, 0, 0), 4.0f};
+        journal.append(addLine);
+        journal.stop();
+    }
+    {
+        BoardJournal journal(dir);
+        BoardData cleared;
+        QVERIFY(journal.recover(&cleared));
+        QCOMPARE(cleared.chartId, initial.chartId);
+        QCOMPARE(cleared.points.size(), 0);
+        QCOMPARE(cleared.lines.size(), 1);
+        QCOMPARE(cleared.lines.first().id, 4u);
+    }
+
+    // El diario de la generacion anterior ya esta en la instantanea: no se vuelve a aplicar
+    {
+        QFile file(journalPath);
+        QVERIFY(file.open(QIODevice::WriteOnly | QIODevice::Truncate));
+        file.write(oldJournal);
+    }
+    {
+        BoardJournal journal(dir);
+        BoardData fromSnapshot;
+        QVERIFY(journal.recover(&fromSnapshot));
+        QCOMPARE(fromSnapshot.chartId, initial.chartId);
+        QCOMPARE(fromSnapshot.points.size(), recovered.points.size());
+        QCOMPARE(fromSnapshot.lines.size(), 0);
+    }
+}
+
+void ProyectoBench::undoRedo_data()
+{
+    QTest::addColumn<int>("steps");
+    QTest::newRow("100 pasos") << 100;
+    QTest::newRow("5000 pasos") << 5000;
+}
+
+// Deshacer y rehacer el ultimo paso con un historial largo detras (con sus cambios en la escena)
+void ProyectoBench::undoRedo()
+{
+    QFETCH(int, steps);
+    DrawingFixture fx;
+    UndoStack history;
+    quint32 id = 1;
+    for (const QLineF &line : randomLines(steps)) {
+        BoardOp op;
+        op.type = BoardOp::Type::AddLine;
+        op.line = {id++, line, qRgb(200, 0, 0), 8.0f};
+        fx.dibujos->applyOp(op);
+        history.record(op, {UndoStack::inverseOf(op)});
+    }
+
+    QBENCHMARK {
+        for (const BoardOp &op : history.undo()) {
+            QVERIFY(fx.dibujos->applyOp(op));
+        }
+        for (const BoardOp &op : history.redo()) {
+            QVERIFY(fx.dibujos->applyOp(op));
+        }
+    }
+    QVERIFY(history.canUndo() && !history.canRedo());
+}
+
+void ProyectoBench::exportPng_data()
+{
+    QTest::addColumn<double>("dpi");
+    QTest::newRow("75 ppp") << 75.0;
+    QTest::newRow("300 ppp") << 300.0;
+}
+
+// Carta completa con 500 lineas, por bandas en paralelo y escrita como PNG en streaming
+void ProyectoBench::exportPng()
+{
+    QFETCH(double, dpi);
+    const QString chartPath = QStringLiteral(":/images/carta_nautica.jpg");
+    const QSize chartSize = QImageReader(chartPath).size();
+    QVERIFY(chartSize.isValid());
+
+    BoardData board;
+    for (const QLineF &line : randomLines(500)) {
+        board.lines.append({0, line, qRgb(200, 0, 0), 8.0f});
+    }
+    ChartExporter exporter(chartPath, QRectF(QPointF(), QSizeF(chartSize)), board);
+    ChartExporter::Options options;
+    options.dpi = dpi;
+    const QString path = m_tmp.filePath(QStringLiteral("carta-%1.png").arg(dpi));
+
+    QBENCHMARK {
+        QVERIFY(exporter.exportTo(path, options));
+    }
+    QCOMPARE(QImageReader(path).size(), exporter.outputSize(options));
+}
+
+void ProyectoBench::exportSvg_data()
+{
+    boardLoad_data();
+}
+
+// Pizarra densa a SVG: la carta reducida se incrusta una vez y el resto sale de los arrays
+void ProyectoBench::exportSvg()
+{
+    QFETCH(int, primitives);
+    const QString chartPath = QStringLiteral(":/images/carta_nautica.jpg");
+    const QRectF chartRect(QPointF(), QSizeF(QImageReader(chartPath).size()));
+
+    BoardData board;
+    for (const QLineF &line : randomLines(primitives)) {
+        board.lines.append({0, line, qRgb(200, 0, 0), 8.0f});
+        board.points.append({0, line.p1(), qRgb(0, 0, 200)});
+        if (board.arcs.size() < primitives / 10) {
+            board.arcs.append({0, {line.p2(), 300.0, 0.0, 120.0}, qRgb(200, 0, 0), 8.0f});
+        }
+    }
+    const QString path = m_tmp.filePath(QStringLiteral("pizarra-%1.svg").arg(primitives));
+
+    QBENCHMARK {
+        QVERIFY(VectorExport::writeSvg(path, chartPath, chartRect, board, VectorExport::Options()));
+    }
+}
+
+void ProyectoBench::chartTiles_data()
+{
+    QTest::addColumn<double>("scale");
+    QTest::newRow("zoom 1.0") << 1.0;
+    QTest::newRow("zoom 0.2") << 0.2;
+    QTest::newRow("zoom 0.09") << 0.09;
+}
+
+// Teselas de una vista de 1920x1080 en el centro de la carta, con la cache vacia: lo que cuesta
+// abrir una carta del catalogo y pintar el primer fotograma
+void ProyectoBench::chartTiles()
+{
+    QFETCH(double, scale);
+    ChartCatalogue &catalogue = ChartCatalogue::instance();
+    const ChartInfo *info = catalogue.find(catalogue.defaultId());
+    QVERIFY(info);
+
+    QBENCHMARK {
+        ChartTiles chart(*info);
+        QVERIFY(!chart.isNull());
+        const int level = chart.levelForScale(scale);
+        const QSizeF viewSize = QSizeF(1920.0, 1080.0) / scale;
+        const QRectF visible = QRectF(chart.sceneRect().center() - QPointF(viewSize.width(), viewSize.height()) / 2.0,
+                                      viewSize).intersected(chart.sceneRect());
+        const double side = double(ChartTiles::kTileSize << level);
+        for (int row = int(visible.top() / side); row <= std::min(chart.rows(level) - 1, int(visible.bottom() / side)); ++row) {
+            for (int column = int(visible.left() / side);
+                 column <= std::min(chart.columns(level) - 1, int(visible.right() / side)); ++column) {
+                QVERIFY(!chart.decodeTile(level, column, row).isNull());
+            }
+        }
+    }
+}
+
+void ProyectoBench::tileCacheFling_data()
+{
+    QTest::addColumn<int>("budgetMb");
+    QTest::newRow("16 MB") << 16;
+    QTest::newRow("128 MB") << 128;
+}
+
+// Barrido rapido de lado a lado de la carta a zoom 1.0, 120 px por paso: se piden las teselas
+// visibles y una pantalla por delante; lo que se queda atras sin empezar se cancela
+void ProyectoBench::tileCacheFling()
+{
+    QFETCH(int, budgetMb);
+    ChartCatalogue &catalogue = ChartCatalogue::instance();
+    const std::shared_ptr<ChartTiles> chart = catalogue.open(catalogue.defaultId());
+    QVERIFY(chart && !chart->isNull());
+    const QSizeF viewSize(1920.0, 1080.0);
+    const double side = ChartTiles::kTileSize;
+
+    QBENCHMARK {
+        TileCache cache;
+        cache.setBudget(qint64(budgetMb) * 1024 * 1024);
+        cache.setChart(chart);
+        const auto requestArea = [&](const QRectF &area, bool visible) {
+            const QRectF clipped = area.intersected(chart->sceneRect());
+            for (int row = int(clipped.top() / side); row <= std::min(chart->rows(0) - 1, int(clipped.bottom() / side)); ++row) {
+                for (int column = int(clipped.left() / side);
+                     column <= std::min(chart->columns(0) - 1, int(clipped.right() / side)); ++column) {
+                    cache.request(0, column, row, visible);
+                }
+            }
+        };
+        const double y = chart->sceneRect().center().y() - viewSize.height() / 2.0;
+        for (double x = 0.0; x + viewSize.width() <= chart->size().width(); x += 120.0) {
+            cache.beginPass();
+            requestArea(QRectF(QPointF(x, y), viewSize), true);
+            requestArea(QRectF(QPointF(x + viewSize.width(), y), viewSize), false);
+            cache.endPass();
+            QCoreApplication::processEvents();
+        }
+        QTRY_COMPARE_WITH_TIMEOUT(cache.pendingCount(), 0, 30000);
+        QVERIFY(cache.usedBytes() <= cache.budget());
+    }
+}
+
+// Zoom animado entre 0.2 y 0.4 en una vista de 1280x720, anclado en el centro: cada iteracion
+// son los fotogramas de la animacion mas el repintado nitido al asentarse
+void ProyectoBench::zoomAnimation()
+{
+    ChartCatalogue &catalogue = ChartCatalogue::instance();
+    QGraphicsScene scene;
+    ChartView view;
+    view.setScene(&scene);
+    view.resize(1280, 720);
+    view.setChart(catalogue.open(catalogue.defaultId()));
+    QVERIFY(!view.chartRect().isEmpty());
+    scene.setSceneRect(view.chartRect());
+    view.setZoom(0.2);
+    view.show();
+    QVERIFY(QTest::qWaitForWindowExposed(&view));
+
+    int frames = 0;
+    connect(&view, &ChartView::framePainted, &view, [&frames] { ++frames; });
+    bool zoomIn = true;
+    QBENCHMARK {
+        view.zoomTo(zoomIn ? 0.4 : 0.2, view.viewport()->rect().center());
+        zoomIn = !zoomIn;
+        QTRY_VERIFY_WITH_TIMEOUT(!view.isZoomAnimating(), 5000);
+        QCoreApplication::processEvents();
+    }
+    QVERIFY(frames > 1);
+}
+
+void ProyectoBench::panScroll_data()
+{
+    QTest::addColumn<bool>("blit");
+    QTest::newRow("franjas expuestas") << true;
+    QTest::newRow("viewport completo") << false;
+}
+
+// Un paso de arrastre (12 px) y su pintado en una vista de 1280x720 a zoom 0.5, con las teselas ya
+// decodificadas: desplazando lo pintado frente a repintar todo el viewport en cada paso
+void ProyectoBench::panScroll()
+{
+    QFETCH(bool, blit);
+    ChartCatalogue &catalogue = ChartCatalogue::instance();
+    QGraphicsScene scene;
+    ChartView view;
+    view.setScene(&scene);
+    view.resize(1280, 720);
+    view.setChart(catalogue.open(catalogue.defaultId()));
+    QVERIFY(!view.chartRect().isEmpty());
+    scene.setSceneRect(view.chartRect());
+    if (!blit) {
+        view.setViewportUpdateMode(QGraphicsView::FullViewportUpdate);
+        view.setCacheMode(QGraphicsView::CacheNone);
+    }
+    view.setZoom(0.5);
+    view.centerOn(view.chartRect().center());
+    view.show();
+    QVERIFY(QTest::qWaitForWindowExposed(&view));
+    QTRY_COMPARE_WITH_TIMEOUT(view.tileCache()->pendingCount(), 0, 10000);
+
+    int step = 0;
+    QBENCHMARK {
+        // Ida y vuelta para no salir de la zona con teselas
+        view.panBy(QPoint((step / 40) % 2 == 0 ? 12 : -12, 0), quint64(step) * 16);
+        ++step;
+        view.endPan();
+        QCoreApplication::processEvents();
+    }
+}
+
+void ProyectoBench::buildMainWindow()
+{
+    QBENCHMARK {
+        MainWindow w;
+        Q_UNUSED(w);
+    }
+}
+
+namespace {
+// QtTest no tiene salida JSON: convertimos su informe XML a un JSON estable entre versiones.
+bool writeJsonReport(const QString &xmlPath, const QString &jsonPath)
+{
+    QFile xmlFile(xmlPath);
+    if (!xmlFile.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    QJsonArray results;
+    QString currentFunction;
+    QXmlStreamReader xml(&xmlFile);
+    while (!xml.atEnd()) {
+        if (!xml.readNextStartElement()) {
+            continue;
+        }
+        if (xml.name() == QLatin1String("TestFunction")) {
+            currentFunction = xml.attributes().value(QLatin1String("name")).toString();
+        } else if (xml.name() == QLatin1String("BenchmarkResult")) {
+            const auto attrs = xml.attributes();
+            QJsonObject entry;
+            entry.insert(QStringLiteral("benchmark"), currentFunction);
+            entry.insert(QStringLiteral("tag"), attrs.value(QLatin1String("tag")).toString());
+            entry.insert(QStringLiteral("metric"), attrs.value(QLatin1String("metric")).toString());
+            entry.insert(QStringLiteral("valuePerIteration"),
+                         attrs.value(QLatin1String("value")).toDouble());
+            entry.insert(QStringLiteral("iterations"),
+                         attrs.value(QLatin1String("iterations")).toInt());
+            results.append(entry);
+        }
+    }
+    if (xml.hasError()) {
+        return false;
+    }
+
+    QJsonObject root;
+    root.insert(QStringLiteral("suite"), QStringLiteral("proyecto_IHM_bench"));
+    root.insert(QStringLiteral("qtVersion"), QString::fromLatin1(qVersion()));
+    root.insert(QStringLiteral("timestamp"),
+                QDateTime::currentDateTimeUtc().toString(Qt::ISODate));
+    root.insert(QStringLiteral("results"), results);
+
+    QFile jsonFile(jsonPath);
+    if (!jsonFile.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        return false;
+    }
+    jsonFile.write(QJsonDocument(root).toJson(QJsonDocument::Indented));
+    return true;
+}
+}
+
+int main(int argc, char *argv[])
+{
+    if (!qEnvironmentVariableIsSet("QT_QPA_PLATFORM")) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+    QApplication app(argc, argv);
+
+    QStringList args = app.arguments();
+    QString jsonPath = QStringLiteral("bench_results.json");
+    const int jsonIdx = args.indexOf(QStringLiteral("--json"));
+    if (jsonIdx > 0 && jsonIdx + 1 < args.size()) {
+        jsonPath = args.at(jsonIdx + 1);
+        args.remove(jsonIdx, 2);
+    }
+
+    QTemporaryDir reportDir;
+    const QString xmlPath = reportDir.filePath(QStringLiteral("bench.xml"));
+    args << QStringLiteral("-o") << xmlPath + QStringLiteral(",xml")
+         << QStringLiteral("-o") << QStringLiteral("-,txt");
+
+    ProyectoBench bench;
+    const int rc = QTest::qExec(&bench, args);
+
+    if (!writeJsonReport(xmlPath, jsonPath)) {
+        qWarning("No se pudo escribir el informe JSON en %s", qPrintable(jsonPath));
+        return rc == 0 ? 1 : rc;
+    }
+    return rc;
+}
+
+#include "bench_main.moc"
@@ -0,0 +1,573 @@
+#include "boardfile.h"
+
+#include <QFile>
+#include <QSaveFile>
+#include <QtEndian>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace {
+constexpr char kMagic[] = "PIHMBRD";
+constexpr int kMagicSize = 7;
+constexpr quint8 kVersion = 3;          // v2: cada registro lleva su id; v3: id de la carta
+constexpr quint8 kOldestVersion = 1;
+
+constexpr qint64 kHeaderSize = kMagicSize + 1 + 5 * 4;
+constexpr qint64 kIdSize = 4;
+constexpr qint64 kPointSize = 2 * 8 + 4;
+constexpr qint64 kLineSize = 4 * 8 + 4 + 4;
+constexpr qint64 kArcSize = 5 * 8 + 4 + 4;
+constexpr qint64 kTextFixedSize = 4 * 8 + 4 + 4 + 4;  // + 2 bytes por unidad UTF-16
+constexpr qint64 kToolSize = 1 + 1 + 4 * 8;
+
+// Escritura secuencial sobre un buffer ya dimensionado
+class Writer
+{
+public:
+    explicit Writer(uchar *out) : m_p(out) {}
+
+    void u8(quint8 v) { *m_p++ = v; }
+    void u32(quint32 v) { qToLittleEndian(v, m_p); m_p += 4; }
+    void f32(float v)
+    {
+        quint32 bits;
+        std::memcpy(&bits, &v, 4);
+        u32(bits);
+    }
+    void f64(double v)
+    {
+        quint64 bits;
+        std::memcpy(&bits, &v, 8);
+        qToLittleEndian(bits, m_p);
+        m_p += 8;
+    }
+    void point(const QPointF &p) { f64(p.x()); f64(p.y()); }
+    void raw(const void *data, qint64 size) { std::memcpy(m_p, data, static_cast<size_t>(size)); m_p += size; }
+
+private:
+    uchar *m_p;
+};
+
+// Lectura con comprobacion de limites; tras un desbordamiento todo devuelve 0 y ok() es false
+class Reader
+{
+public:
+    Reader(const uchar *data, qint64 size) : m_begin(data), m_p(data), m_end(data + size) {}
+
+    bool ok() const { return m_ok; }
+    bool has(qint64 bytes)
+    {
+        if (m_ok && m_end - m_p >= bytes) {
+            return true;
+        }
+        m_ok = false;
+        return false;
+    }
+    quint8 u8() { return has(1) ? *m_p++ : 0; }
+    quint32 u32()
+    {
+        if (!has(4)) {
+            return 0;
+        }
+        const quint32 v = qFromLittleEndian<quint32>(m_p);
+        m_p += 4;
+        return v;
+    }
+    float f32()
+    {
+        const quint32 bits = u32();
+        float v;
+        std::memcpy(&v, &bits, 4);
+        return v;
+    }
+    double f64()
+    {
+        if (!has(8)) {
+            return 0.0;
+        }
+        const quint64 bits = qFromLittleEndian<quint64>(m_p);
+        m_p += 8;
+        double v;
+        std::memcpy(&v, &bits, 8);
+        return v;
+    }
+    QPointF point()
+    {
+        const double x = f64();
+        return QPointF(x, f64());
+    }
+    const uchar *take(qint64 bytes)
+    {
+        if (!has(bytes)) {
+            return nullptr;
+        }
+        const uchar *p = m_p;
+        m_p += bytes;
+        return p;
+    }
+    qint64 remaining() const { return m_end - m_p; }
+    qint64 consumed() const { return m_p - m_begin; }
+
+private:
+    const uchar *m_begin;
+    const uchar *m_p;
+    const uchar *m_end;
+    bool m_ok = true;
+};
+
+bool fail(QString *error, const QString &msg)
+{
+    if (error) {
+        *error = msg;
+    }
+    return false;
+}
+
+// NaN o infinito en una coordenada acabaria en la escena y en los indices espaciales
+bool finite(double v)
+{
+    return std::isfinite(v);
+}
+
+bool finite(const QPointF &p)
+{
+    return finite(p.x()) && finite(p.y());
+}
+
+bool validPoint(const BoardPoint &p)
+{
+    return finite(p.pos);
+}
+
+bool validLine(const BoardLine &l)
+{
+    return finite(l.line.p1()) && finite(l.line.p2()) && finite(l.width);
+}
+
+bool validArc(const BoardArc &a)
+{
+    return finite(a.arc.center) && finite(a.arc.radius) && finite(a.arc.startDeg) && finite(a.arc.spanDeg)
+           && finite(a.width);
+}
+
+bool validText(const BoardText &t)
+{
+    return finite(t.pos) && finite(t.size.width()) && finite(t.size.height()) && finite(t.fontSize);
+}
+
+// Cadena como longitud en unidades UTF-16 y las unidades
+qint64 stringSize(const QString &text)
+{
+    return 4 + text.size() * 2;
+}
+
+void writeString(Writer &w, const QString &text)
+{
+    w.u32(static_cast<quint32>(text.size()));
+    for (QChar c : text) {
+        const quint16 unit = c.unicode();
+        w.u8(static_cast<quint8>(unit & 0xff));
+        w.u8(static_cast<quint8>(unit >> 8));
+    }
+}
+
+bool readString(Reader &r, QString &text)
+{
+    const quint32 length = r.u32();
+    const uchar *units = r.take(static_cast<qint64>(length) * 2);
+    if (!units) {
+        return false;
+    }
+    text.resize(length);
+    QChar *chars = text.data();
+    for (quint32 i = 0; i < length; ++i) {
+        chars[i] = QChar(static_cast<char16_t>(units[2 * i] | (units[2 * i + 1] << 8)));
+    }
+    return true;
+}
+
+qint64 textRecordSize(const BoardText &text)
+{
+    return kIdSize + kTextFixedSize + text.text.size() * 2;
+}
+
+// Registros comunes al fichero y a los cambios del diario (siempre con id)
+void writePoint(Writer &w, const BoardPoint &p)
+{
+    w.u32(p.id);
+    w.point(p.pos);
+    w.u32(p.color);
+}
+
+void writeLine(Writer &w, const BoardLine &l)
+{
+    w.u32(l.id);
+    w.point(l.line.p1());
+    w.point(l.line.p2());
+    w.u32(l.color);
+    w.f32(l.width);
+}
+
+void writeArc(Writer &w, const BoardArc &a)
+{
+    w.u32(a.id);
+    w.point(a.arc.center);
+    w.f64(a.arc.radius);
+    w.f64(a.arc.startDeg);
+    w.f64(a.arc.spanDeg);
+    w.u32(a.color);
+    w.f32(a.width);
+}
+
+void writeText(Writer &w, const BoardText &t)
+{
+    w.u32(t.id);
+    w.point(t.pos);
+    w.f64(t.size.width());
+    w.f64(t.size.height());
+    w.u32(t.color);
+    w.f32(t.fontSize);
+    writeString(w, t.text);
+}
+
+void readPoint(Reader &r, BoardPoint &p, bool withId)
+{
+    p.id = withId ? r.u32() : 0;
+    p.pos = r.point();
+    p.color = r.u32();
+}
+
+void readLine(Reader &r, BoardLine &l, bool withId)
+{
+    l.id = withId ? r.u32() : 0;
+    const QPointF p1 = r.point();
+    l.line = QLineF(p1, r.point());
+    l.color = r.u32();
+    l.width = r.f32();
+}
+
+void readArc(Reader &r, BoardArc &a, bool withId)
+{
+    a.id = withId ? r.u32() : 0;
+    a.arc.center = r.point();
+    a.arc.radius = r.f64();
+    a.arc.startDeg = r.f64();
+    a.arc.spanDeg = r.f64();
+    a.color = r.u32();
+    a.width = r.f32();
+}
+
+bool readText(Reader &r, BoardText &t, bool withId)
+{
+    t.id = withId ? r.u32() : 0;
+    t.pos = r.point();
+    const double width = r.f64();
+    t.size = QSizeF(width, r.f64());
+    t.color = r.u32();
+    t.fontSize = r.f32();
+    return readString(r, t.text);
+}
+}
+
+quint32 BoardOp::id() const
+{
+    switch (type) {
+    case Type::AddPoint:
+    case Type::ErasePoint:
+        return point.id;
+    case Type::AddLine:
+    case Type::EraseLine:
+        return line.id;
+    case Type::AddArc:
+    case Type::EraseArc:
+        return arc.id;
+    case Type::AddText:
+    case Type::UpdateText:
+    case Type::EraseText:
+        return text.id;
+    case Type::Clear:
+        break;
+    }
+    return 0;
+}
+
+namespace BoardFile {
+
+QByteArray encode(const BoardData &board)
+{
+    qint64 size = kHeaderSize + stringSize(board.chartId)
+                  + board.points.size() * (kIdSize + kPointSize)
+                  + board.lines.size() * (kIdSize + kLineSize)
+                  + board.arcs.size() * (kIdSize + kArcSize)
+                  + board.tools.size() * kToolSize;
+    for (const BoardText &text : board.texts) {
+        size += textRecordSize(text);
+    }
+
+    QByteArray bytes(size, Qt::Uninitialized);
+    Writer w(reinterpret_cast<uchar*>(bytes.data()));
+    w.raw(kMagic, kMagicSize);
+    w.u8(kVersion);
+    w.u32(static_cast<quint32>(board.points.size()));
+    w.u32(static_cast<quint32>(board.lines.size()));
+    w.u32(static_cast<quint32>(board.arcs.size()));
+    w.u32(static_cast<quint32>(board.texts.size()));
+    w.u32(static_cast<quint32>(board.tools.size()));
+    writeString(w, board.chartId);
+
+    for (const BoardPoint &p : board.points) {
+        writePoint(w, p);
+    }
+    for (const BoardLine &l : board.lines) {
+        writeLine(w, l);
+    }
+    for (const BoardArc &a : board.arcs) {
+        writeArc(w, a);
+    }
+    for (const BoardText &t : board.texts) {
+        writeText(w, t);
+    }
+    for (const BoardToolPose &tool : board.tools) {
+        w.u8(static_cast<quint8>(tool.tool));
+        w.u8(tool.visible ? 1 : 0);
+        w.point(tool.pos);
+        w.f64(tool.rotationDeg);
+        w.f64(tool.openingDeg);
+    }
+    return bytes;
+}
+
+bool decode(const uchar *data, qint64 size, BoardData *board, QString *error)
+{
+    Reader r(data, size);
+    const uchar *magic = r.take(kMagicSize);
+    if (!magic || !std::equal(magic, magic + kMagicSize, reinterpret_cast<const uchar*>(kMagic))) {
+        return fail(error, QStringLiteral("no es un fichero de pizarra"));
+    }
+    const quint8 version = r.u8();
+    if (version < kOldestVersion || version > kVersion) {
+        return fail(error, QStringLiteral("version de pizarra no soportada: %1").arg(version));
+    }
+    const bool withIds = version >= 2;
+    const qint64 idSize = withIds ? kIdSize : 0;
+
+    const quint32 pointCount = r.u32();
+    const quint32 lineCount = r.u32();
+    const quint32 arcCount = r.u32();
+    const quint32 textCount = r.u32();
+    const quint32 toolCount = r.u32();
+    BoardData out;
+    if (version >= 3 && !readString(r, out.chartId)) {
+        return fail(error, QStringLiteral("fichero de pizarra truncado"));
+    }
+    // Los recuentos se validan contra el tamano antes de reservar nada
+    const qint64 fixedBytes = pointCount * (idSize + kPointSize) + lineCount * (idSize + kLineSize)
+                              + arcCount * (idSize + kArcSize) + textCount * (idSize + kTextFixedSize)
+                              + toolCount * kToolSize;
+    if (!r.ok() || fixedBytes > r.remaining()) {
+        return fail(error, QStringLiteral("fichero de pizarra truncado"));
+    }
+
+    const QString badValue = QStringLiteral("coordenada no valida en la pizarra");
+    out.points.resize(pointCount);
+    for (BoardPoint &p : out.points) {
+        readPoint(r, p, withIds);
+        if (!validPoint(p)) {
+            return fail(error, badValue);
+        }
+    }
+    out.lines.resize(lineCount);
+    for (BoardLine &l : out.lines) {
+        readLine(r, l, withIds);
+        if (!validLine(l)) {
+            return fail(error, badValue);
+        }
+    }
+    out.arcs.resize(arcCount);
+    for (BoardArc &a : out.arcs) {
+        readArc(r, a, withIds);
+        if (!validArc(a)) {
+            return fail(error, badValue);
+        }
+    }
+    out.texts.resize(textCount);
+    for (BoardText &t : out.texts) {
+        if (!readText(r, t, withIds)) {
+            break;
+        }
+        if (!validText(t)) {
+            return fail(error, badValue);
+        }
+    }
+    out.tools.resize(toolCount);
+    for (BoardToolPose &tool : out.tools) {
+        const quint8 kind = r.u8();
+        if (r.ok() && kind > quint8(BoardToolPose::Tool::Compass)) {
+            return fail(error, QStringLiteral("herramienta desconocida en la pizarra: %1").arg(kind));
+        }
+        tool.tool = static_cast<BoardToolPose::Tool>(kind);
+        tool.visible = r.u8() != 0;
+        tool.pos = r.point();
+        tool.rotationDeg = r.f64();
+        tool.openingDeg = r.f64();
+        if (!finite(tool.pos) || !finite(tool.rotationDeg) || !finite(tool.openingDeg)) {
+            return fail(error, badValue);
+        }
+    }
+
+    if (!r.ok()) {
+        return fail(error, QStringLiteral("fichero de pizarra truncado"));
+    }
+    *board = std::move(out);
+    return true;
+}
+
+QByteArray encodeOp(const BoardOp &op)
+{
+    qint64 size = 1;
+    switch (op.type) {
+    case BoardOp::Type::AddPoint:
+        size += kIdSize + kPointSize;
+        break;
+    case BoardOp::Type::AddLine:
+        size += kIdSize + kLineSize;
+        break;
+    case BoardOp::Type::AddArc:
+        size += kIdSize + kArcSize;
+        break;
+    case BoardOp::Type::AddText:
+    case BoardOp::Type::UpdateText:
+        size += textRecordSize(op.text);
+        break;
+    case BoardOp::Type::ErasePoint:
+    case BoardOp::Type::EraseLine:
+    case BoardOp::Type::EraseArc:
+    case BoardOp::Type::EraseText:
+        size += kIdSize;
+        break;
+    case BoardOp::Type::Clear:
+        break;
+    }
+
+    QByteArray bytes(size, Qt::Uninitialized);
+    Writer w(reinterpret_cast<uchar*>(bytes.data()));
+    w.u8(static_cast<quint8>(op.type));
+    switch (op.type) {
+    case BoardOp::Type::AddPoint:
+        writePoint(w, op.point);
+        break;
+    case BoardOp::Type::AddLine:
+        writeLine(w, op.line);
+        break;
+    case BoardOp::Type::AddArc:
+        writeArc(w, op.arc);
+        break;
+    case BoardOp::Type::AddText:
+    case BoardOp::Type::UpdateText:
+        writeText(w, op.text);
+        break;
+    case BoardOp::Type::ErasePoint:
+    case BoardOp::Type::EraseLine:
+    case BoardOp::Type::EraseArc:
+    case BoardOp::Type::EraseText:
+        w.u32(op.id());
+        break;
+    case BoardOp::Type::Clear:
+        break;
+    }
+    return bytes;
+}
+
+qint64 decodeOp(const uchar *data, qint64 size, BoardOp *op)
+{
+    Reader r(data, size);
+    const quint8 type = r.u8();
+    if (!r.ok() || type > static_cast<quint8>(BoardOp::Type::Clear)) {
+        return 0;
+    }
+
+    BoardOp out;
+    out.type = static_cast<BoardOp::Type>(type);
+    switch (out.type) {
+    case BoardOp::Type::AddPoint:
+        readPoint(r, out.point, true);
+        if (!validPoint(out.point)) {
+            return 0;
+        }
+        break;
+    case BoardOp::Type::AddLine:
+        readLine(r, out.line, true);
+        if (!validLine(out.line)) {
+            return 0;
+        }
+        break;
+    case BoardOp::Type::AddArc:
+        readArc(r, out.arc, true);
+        if (!validArc(out.arc)) {
+            return 0;
+        }
+        break;
+    case BoardOp::Type::AddText:
+    case BoardOp::Type::UpdateText:
+        if (readText(r, out.text, true) && !validText(out.text)) {
+            return 0;
+        }
+        break;
+    case BoardOp::Type::ErasePoint:
+        out.point.id = r.u32();
+        break;
+    case BoardOp::Type::EraseLine:
+        out.line.id = r.u32();
+        break;
+    case BoardOp::Type::EraseArc:
+        out.arc.id = r.u32();
+        break;
+    case BoardOp::Type::EraseText:
+        out.text.id = r.u32();
+        break;
+    case BoardOp::Type::Clear:
+        break;
+    }
+
+    if (!r.ok()) {
+        return 0;
+    }
+    *op = std::move(out);
+    return r.consumed();
+}
+
+bool save(const QString &path, const BoardData &board, QString *error)
+{
+    const QByteArray bytes = encode(board);
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return fail(error, file.errorString());
+    }
+    if (file.write(bytes) != bytes.size() || !file.commit()) {
+        return fail(error, file.errorString());
+    }
+    return true;
+}
+
+bool load(const QString &path, BoardData *board, QString *error)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return fail(error, file.errorString());
+    }
+
+    const qint64 size = file.size();
+    if (uchar *mapped = size > 0 ? file.map(0, size) : nullptr) {
+        const bool ok = decode(mapped, size, board, error);
+        file.unmap(mapped);
+        return ok;
+    }
+
+    // Sin mmap (algunos sistemas de ficheros de red): lectura completa
+    const QByteArray bytes = file.readAll();
+    return decode(reinterpret_cast<const uchar*>(bytes.constData()), bytes.size(), board, error);
+}
+
+}
@@ -0,0 +1,97 @@
+#ifndef BOARDFILE_H
+#define BOARDFILE_H
+
+#include "arcitem.h"
+
+#include <QByteArray>
+#include <QLineF>
+#include <QPointF>
+#include <QRgb>
+#include <QSizeF>
+#include <QString>
+#include <QVector>
+
+// Contenido guardable de una pizarra: primitivas de Dibujos, cajas de texto y herramientas.
+// Los id identifican cada elemento dentro de la pizarra (0 = sin asignar) y no se reutilizan.
+struct BoardPoint {
+    quint32 id = 0;
+    QPointF pos;
+    QRgb color = 0;
+};
+
+struct BoardLine {
+    quint32 id = 0;
+    QLineF line;
+    QRgb color = 0;
+    float width = 0.0f;
+};
+
+struct BoardArc {
+    quint32 id = 0;
+    ArcPrimitive arc;
+    QRgb color = 0;
+    float width = 0.0f;
+};
+
+struct BoardText {
+    quint32 id = 0;
+    QPointF pos;
+    QSizeF size;
+    QRgb color = 0;
+    float fontSize = 0.0f;
+    QString text;
+};
+
+struct BoardToolPose {
+    enum class Tool : quint8 { Ruler, Protractor, Compass };
+    Tool tool = Tool::Ruler;
+    bool visible = false;
+    QPointF pos;
+    double rotationDeg = 0.0;
+    double openingDeg = 0.0;    // solo compas
+};
+
+struct BoardData {
+    QString chartId;        // carta del catalogo bajo lo dibujado; vacia = la carta por defecto (v1 y v2)
+    QVector<BoardPoint> points;
+    QVector<BoardLine> lines;
+    QVector<BoardArc> arcs;
+    QVector<BoardText> texts;
+    QVector<BoardToolPose> tools;
+};
+
+// Un cambio de la pizarra. Los borrados llevan el elemento completo para poder deshacerlos;
+// en el diario solo se guarda su id.
+struct BoardOp {
+    enum class Type : quint8 {
+        AddPoint, AddLine, AddArc,
+        ErasePoint, EraseLine, EraseArc,
+        AddText, UpdateText, EraseText,
+        Clear
+    };
+    Type type = Type::Clear;
+    BoardPoint point;
+    BoardLine line;
+    BoardArc arc;
+    BoardText text;
+
+    quint32 id() const;
+};
+
+// Formato binario versionado (little endian): cabecera "PIHMBRD" + version + recuentos, el id de la
+// carta (v3) y despues registros de tamano fijo por tipo (los textos llevan su longitud delante). Se escribe de una vez
+// desde un buffer ya dimensionado y se lee sobre el fichero mapeado en memoria.
+namespace BoardFile {
+QByteArray encode(const BoardData &board);
+bool decode(const uchar *data, qint64 size, BoardData *board, QString *error = nullptr);
+
+// Un cambio con los mismos registros que el fichero; decodeOp devuelve los bytes consumidos
+// (0 si el buffer no contiene un cambio completo)
+QByteArray encodeOp(const BoardOp &op);
+qint64 decodeOp(const uchar *data, qint64 size, BoardOp *op);
+
+bool save(const QString &path, const BoardData &board, QString *error = nullptr);
+bool load(const QString &path, BoardData *board, QString *error = nullptr);
+}
+
+#endif // BOARDFILE_H
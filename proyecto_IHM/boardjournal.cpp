@@ -0,0 +1,390 @@
+#include "boardjournal.h"
+
+#include <QByteArrayView>
+#include <QDir>
+#include <QFile>
+#include <QHash>
+#include <QMutexLocker>
+#include <QSaveFile>
+#include <QThread>
+#include <QtEndian>
+
+#include <algorithm>
+
+#ifdef Q_OS_WIN
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace {
+constexpr char kJournalMagic[] = "PIHMJRN";
+constexpr char kSnapshotMagic[] = "PIHMSNP";
+constexpr int kMagicSize = 7;
+constexpr quint8 kVersion = 1;
+constexpr qint64 kFileHeaderSize = kMagicSize + 1 + 4;   // magia + version + generacion
+constexpr qint64 kFrameHeaderSize = 4 + 2;              // longitud + suma de control
+
+QByteArray fileHeader(const char *magic, quint32 generation)
+{
+    QByteArray header(kFileHeaderSize, Qt::Uninitialized);
+    std::copy(magic, magic + kMagicSize, header.data());
+    header[kMagicSize] = static_cast<char>(kVersion);
+    qToLittleEndian(generation, header.data() + kMagicSize + 1);
+    return header;
+}
+
+// Generacion del fichero, o -1 si la cabecera no es valida
+qint64 readHeader(const QByteArray &bytes, const char *magic)
+{
+    if (bytes.size() < kFileHeaderSize || !std::equal(magic, magic + kMagicSize, bytes.constData())
+        || static_cast<quint8>(bytes.at(kMagicSize)) != kVersion) {
+        return -1;
+    }
+    return qFromLittleEndian<quint32>(bytes.constData() + kMagicSize + 1);
+}
+
+void syncToDisk(QFile &file)
+{
+#ifdef Q_OS_WIN
+    _commit(file.handle());
+#else
+    ::fsync(file.handle());
+#endif
+}
+
+// Reconstruccion de un tipo de registro: los borrados dejan hueco y se compacta al final
+template <typename Record>
+struct ReplayList {
+    QVector<Record> items;
+    QVector<bool> alive;
+    QHash<quint32, int> index;
+
+    void seed(const QVector<Record> &records)
+    {
+        for (const Record &r : records) {
+            add(r);
+        }
+    }
+    void add(const Record &r)
+    {
+        index.insert(r.id, items.size());
+        items.append(r);
+        alive.append(true);
+    }
+    void update(const Record &r)
+    {
+        const auto it = index.constFind(r.id);
+        if (it == index.constEnd()) {
+            add(r);
+        } else {
+            items[it.value()] = r;
+        }
+    }
+    void erase(quint32 id)
+    {
+        const auto it = index.find(id);
+        if (it != index.end()) {
+            alive[it.value()] = false;
+            index.erase(it);
+        }
+    }
+    void clear()
+    {
+        items.clear();
+        alive.clear();
+        index.clear();
+    }
+    QVector<Record> take() const
+    {
+        QVector<Record> out;
+        out.reserve(index.size());
+        for (int i = 0; i < items.size(); ++i) {
+            if (alive.at(i)) {
+                out.append(items.at(i));
+            }
+        }
+        return out;
+    }
+};
+}
+
+BoardJournal::BoardJournal(const QString &directory)
+    : m_snapshotPath(QDir(directory).filePath(QStringLiteral("board.snapshot")))
+    , m_journalPath(QDir(directory).filePath(QStringLiteral("board.journal")))
+{
+    QDir().mkpath(directory);
+}
+
+BoardJournal::~BoardJournal()
+{
+    stop();
+}
+
+bool BoardJournal::recover(BoardData *board, QString *error)
+{
+    BoardData base;
+    qint64 snapshotGeneration = -1;
+    {
+        QFile file(m_snapshotPath);
+        if (file.open(QIODevice::ReadOnly)) {
+            const QByteArray bytes = file.readAll();
+            snapshotGeneration = readHeader(bytes, kSnapshotMagic);
+            if (snapshotGeneration < 0
+                || !BoardFile::decode(reinterpret_cast<const uchar*>(bytes.constData()) + kFileHeaderSize,
+                                      bytes.size() - kFileHeaderSize, &base, error)) {
+                snapshotGeneration = -1;
+                base = BoardData();
+            }
+        }
+    }
+
+    QByteArray journal;
+    {
+        QFile file(m_journalPath);
+        if (file.open(QIODevice::ReadOnly)) {
+            journal = file.readAll();
+        }
+    }
+    const qint64 journalGeneration = readHeader(journal, kJournalMagic);
+    m_generation = static_cast<quint32>(std::max<qint64>({0, snapshotGeneration, journalGeneration}));
+
+    if (snapshotGeneration < 0 && journalGeneration < 0) {
+        return false;
+    }
+
+    ReplayList<BoardPoint> points;
+    ReplayList<BoardLine> lines;
+    ReplayList<BoardArc> arcs;
+    ReplayList<BoardText> texts;
+    points.seed(base.points);
+    lines.seed(base.lines);
+    arcs.seed(base.arcs);
+    texts.seed(base.texts);
+
+    // Un diario mas antiguo que la instantanea ya esta dentro de ella
+    if (journalGeneration >= 0 && journalGeneration >= snapshotGeneration) {
+        const auto *data = reinterpret_cast<const uchar*>(journal.constData());
+        qint64 offset = kFileHeaderSize;
+        while (journal.size() - offset >= kFrameHeaderSize) {
+            const quint32 length = qFromLittleEndian<quint32>(data + offset);
+            const quint16 checksum = qFromLittleEndian<quint16>(data + offset + 4);
+            const qint64 payload = offset + kFrameHeaderSize;
+            if (length > static_cast<quint64>(journal.size() - payload)
+                || qChecksum(QByteArrayView(journal.constData() + payload, length)) != checksum) {
+                break; // ultimo cambio a medio escribir
+            }
+
+            BoardOp op;
+            if (BoardFile::decodeOp(data + payload, length, &op) != static_cast<qint64>(length)) {
+                break;
+            }
+            switch (op.type) {
+            case BoardOp::Type::AddPoint:
+                points.add(op.point);
+                break;
+            case BoardOp::Type::AddLine:
+                lines.add(op.line);
+                break;
+            case BoardOp::Type::AddArc:
+                arcs.add(op.arc);
+                break;
+            case BoardOp::Type::ErasePoint:
+                points.erase(op.id());
+                break;
+            case BoardOp::Type::EraseLine:
+                lines.erase(op.id());
+                break;
+            case BoardOp::Type::EraseArc:
+                arcs.erase(op.id());
+                break;
+            case BoardOp::Type::AddText:
+            case BoardOp::Type::UpdateText:
+                texts.update(op.text);
+                break;
+            case BoardOp::Type::EraseText:
+                texts.erase(op.id());
+                break;
+            case BoardOp::Type::Clear:
+                points.clear();
+                lines.clear();
+                arcs.clear();
+                texts.clear();
+                break;
+            }
+            offset = payload + length;
+        }
+    }
+
+    board->points = points.take();
+    board->lines = lines.take();
+    board->arcs = arcs.take();
+    board->texts = texts.take();
+    board->tools = base.tools;
+    board->chartId = base.chartId;
+    return true;
+}
+
+void BoardJournal::start(const BoardData &initial)
+{
+    if (m_thread) {
+        return;
+    }
+
+    m_journal = new QFile(m_journalPath);
+    m_stopping = false;
+    m_queue.clear();
+    m_queue.append({true, initial, QByteArray()});
+    m_opsSinceSnapshot = 0;
+    m_bytesSinceSnapshot = 0;
+
+    m_thread = QThread::create([this] { run(); });
+    m_thread->setObjectName(QStringLiteral("BoardJournal"));
+    m_thread->start(QThread::LowPriority);
+}
+
+void BoardJournal::stop()
+{
+    if (!m_thread) {
+        return;
+    }
+    {
+        QMutexLocker locker(&m_mutex);
+        m_stopping = true;
+        m_wake.wakeOne();
+    }
+    m_thread->wait();
+    delete m_thread;
+    m_thread = nullptr;
+    delete m_journal;
+    m_journal = nullptr;
+}
+
+void BoardJournal::append(const BoardOp &op)
+{
+    if (!m_thread) {
+        return;
+    }
+
+    const QByteArray payload = BoardFile::encodeOp(op);
+    QByteArray frame(kFrameHeaderSize, Qt::Uninitialized);
+    qToLittleEndian(static_cast<quint32>(payload.size()), frame.data());
+    qToLittleEndian(qChecksum(QByteArrayView(payload)), frame.data() + 4);
+
+    ++m_opsSinceSnapshot;
+    m_bytesSinceSnapshot += frame.size() + payload.size();
+
+    QMutexLocker locker(&m_mutex);
+    const bool wasIdle = m_queue.isEmpty();
+    if (wasIdle || m_queue.last().isSnapshot) {
+        m_queue.append(Task());
+    }
+    QByteArray &ops = m_queue.last().ops;
+    ops += frame;
+    ops += payload;
+    if (ops.size() >= kUrgentBytes) {
+        m_urgent = true;
+        m_wake.wakeOne();
+    } else if (wasIdle) {
+        m_wake.wakeOne();
+    }
+}
+
+void BoardJournal::snapshot(const BoardData &board)
+{
+    if (!m_thread) {
+        return;
+    }
+    m_opsSinceSnapshot = 0;
+    m_bytesSinceSnapshot = 0;
+
+    QMutexLocker locker(&m_mutex);
+    m_queue.append({true, board, QByteArray()});
+    m_urgent = true;
+    m_wake.wakeOne();
+}
+
+bool BoardJournal::wantsSnapshot() const
+{
+    return m_opsSinceSnapshot >= kSnapshotOps || m_bytesSinceSnapshot >= kSnapshotBytes;
+}
+
+void BoardJournal::run()
+{
+    forever {
+        QVector<Task> batch;
+        bool stopping = false;
+        {
+            QMutexLocker locker(&m_mutex);
+            while (m_queue.isEmpty() && !m_stopping) {
+                m_wake.wait(&m_mutex);
+            }
+            // Con el primer cambio de un grupo se espera un poco a que lleguen los siguientes
+            if (!m_stopping && !m_urgent) {
+                m_wake.wait(&m_mutex, kGroupWindowMs);
+            }
+            batch.swap(m_queue);
+            m_urgent = false;
+            stopping = m_stopping;
+        }
+
+        bool wroteOps = false;
+        for (const Task &task : std::as_const(batch)) {
+            if (task.isSnapshot) {
+                if (wroteOps) {
+                    m_journal->flush();
+                    syncToDisk(*m_journal);
+                    wroteOps = false;
+                }
+                if (!writeSnapshot(task.board, m_generation + 1) || !resetJournal(m_generation + 1)) {
+                    qWarning("No se pudo compactar el diario de la pizarra en %s", qPrintable(m_snapshotPath));
+                    continue;
+                }
+                ++m_generation;
+            } else if (m_journal->isOpen()) {
+                m_journal->write(task.ops);
+                wroteOps = true;
+            }
+        }
+        if (wroteOps) {
+            m_journal->flush();
+            syncToDisk(*m_journal);
+        }
+
+        if (stopping) {
+            QMutexLocker locker(&m_mutex);
+            if (m_queue.isEmpty()) {
+                break;
+            }
+        }
+    }
+    m_journal->close();
+}
+
+bool BoardJournal::writeSnapshot(const BoardData &board, quint32 generation)
+{
+    // QSaveFile escribe en un temporal, lo sincroniza y lo renombra: nunca queda a medias
+    QSaveFile file(m_snapshotPath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+    file.write(fileHeader(kSnapshotMagic, generation));
+    file.write(BoardFile::encode(board));
+    return file.commit();
+}
+
+bool BoardJournal::resetJournal(quint32 generation)
+{
+    m_journal->close();
+    {
+        QSaveFile file(m_journalPath);
+        if (!file.open(QIODevice::WriteOnly)) {
+            return false;
+        }
+        file.write(fileHeader(kJournalMagic, generation));
+        if (!file.commit()) {
+            return false;
+        }
+    }
+    return m_journal->open(QIODevice::WriteOnly | QIODevice::Append);
+}
@@ -0,0 +1,79 @@
+#ifndef BOARDJOURNAL_H
+#define BOARDJOURNAL_H
+
+#include "boardfile.h"
+
+#include <QByteArray>
+#include <QMutex>
+#include <QString>
+#include <QVector>
+#include <QWaitCondition>
+
+class QFile;
+class QThread;
+
+// Diario de cambios de la pizarra para recuperarla tras un cierre inesperado. El hilo de la interfaz
+// solo codifica cada cambio en memoria; un hilo propio los escribe en grupos al final del diario y
+// hace fsync. Cada cierto numero de cambios la pizarra completa se guarda como instantanea y el
+// diario vuelve a empezar.
+//
+// En disco: board.snapshot (generacion + fichero de pizarra) y board.journal (generacion + cambios,
+// cada uno con longitud y suma de control). Un diario de una generacion anterior a la instantanea
+// ya esta incluido en ella y se ignora.
+class BoardJournal
+{
+public:
+    explicit BoardJournal(const QString &directory);
+    ~BoardJournal();
+
+    // Ultima pizarra guardada: instantanea mas los cambios validos del diario. Llamar antes de start().
+    // Devuelve false si no hay nada que recuperar.
+    bool recover(BoardData *board, QString *error = nullptr);
+
+    // Arranca el hilo de escritura; lo primero que escribe es una instantanea de initial
+    void start(const BoardData &initial);
+    // Escribe lo pendiente y detiene el hilo
+    void stop();
+
+    void append(const BoardOp &op);
+    void snapshot(const BoardData &board);
+    // Hay suficientes cambios desde la ultima instantanea como para compactar
+    bool wantsSnapshot() const;
+
+private:
+    struct Task {
+        bool isSnapshot = false;
+        BoardData board;
+        QByteArray ops;
+    };
+
+    static constexpr int kGroupWindowMs = 250;          // espera para agrupar cambios en una escritura
+    static constexpr int kUrgentBytes = 64 * 1024;
+    static constexpr int kSnapshotOps = 2000;
+    static constexpr qint64 kSnapshotBytes = 4 * 1024 * 1024;
+
+    void run();
+    bool writeSnapshot(const BoardData &board, quint32 generation);
+    bool resetJournal(quint32 generation);
+
+    QString m_snapshotPath;
+    QString m_journalPath;
+    QThread *m_thread = nullptr;
+
+    // Compartido con el hilo de escritura
+    QMutex m_mutex;
+    QWaitCondition m_wake;
+    QVector<Task> m_queue;
+    bool m_urgent = false;
+    bool m_stopping = false;
+
+    // Solo hilo de escritura
+    QFile *m_journal = nullptr;
+    quint32 m_generation = 0;
+
+    // Solo hilo de la interfaz
+    int m_opsSinceSnapshot = 0;
+    qint64 m_bytesSinceSnapshot = 0;
+};
+
+#endif // BOARDJOURNAL_H
@@ -0,0 +1,159 @@
+#include "chartcatalogue.h"
+#include "charttiles.h"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QStandardPaths>
+
+#include <algorithm>
+
+namespace {
+const QString kBuiltinCatalogue = QStringLiteral(":/charts/catalogue.json");
+
+bool fail(QString *error, const QString &msg)
+{
+    if (error) {
+        *error = msg;
+    }
+    return false;
+}
+
+// Las rutas relativas del catalogo son relativas al propio fichero
+QString resolvePath(const QDir &base, const QString &path)
+{
+    if (path.isEmpty() || path.startsWith(QLatin1Char(':')) || QDir::isAbsolutePath(path)) {
+        return path;
+    }
+    return base.filePath(path);
+}
+
+bool readPair(const QJsonObject &entry, const QString &key, double *first, double *second)
+{
+    const QJsonArray values = entry.value(key).toArray();
+    if (values.size() != 2) {
+        return false;
+    }
+    *first = values.at(0).toDouble();
+    *second = values.at(1).toDouble();
+    return true;
+}
+}
+
+GeoReference ChartInfo::geoReference() const
+{
+    return GeoReference(frame, latTop, latBottom, lonLeft, lonRight);
+}
+
+ChartCatalogue &ChartCatalogue::instance()
+{
+    static ChartCatalogue catalogue;
+    return catalogue;
+}
+
+ChartCatalogue::ChartCatalogue()
+{
+    load(kBuiltinCatalogue);
+
+    QString extra = qEnvironmentVariable("PROYECTO_IHM_CHARTS");
+    if (extra.isEmpty()) {
+        extra = QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation)
+                + QStringLiteral("/charts/catalogue.json");
+    }
+    if (QFileInfo::exists(extra)) {
+        QString error;
+        if (!load(extra, &error)) {
+            qWarning("catalogo de cartas %s: %s", qPrintable(extra), qPrintable(error));
+        }
+    }
+}
+
+bool ChartCatalogue::load(const QString &path, QString *error)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return fail(error, file.errorString());
+    }
+    QJsonParseError parseError;
+    const QJsonDocument document = QJsonDocument::fromJson(file.readAll(), &parseError);
+    if (parseError.error != QJsonParseError::NoError) {
+        return fail(error, parseError.errorString());
+    }
+
+    const QDir base = QFileInfo(path).absoluteDir();
+    const QJsonArray entries = document.object().value(QStringLiteral("charts")).toArray();
+    QVector<ChartInfo> loaded;
+    loaded.reserve(entries.size());
+    for (const QJsonValue &value : entries) {
+        const QJsonObject entry = value.toObject();
+        ChartInfo info;
+        info.id = entry.value(QStringLiteral("id")).toString();
+        info.name = entry.value(QStringLiteral("name")).toString(info.id);
+        info.imagePath = resolvePath(base, entry.value(QStringLiteral("image")).toString());
+        info.tileDir = resolvePath(base, entry.value(QStringLiteral("tiles")).toString());
+
+        const QJsonArray frame = entry.value(QStringLiteral("frame")).toArray();
+        if (info.id.isEmpty() || info.imagePath.isEmpty() || frame.size() != 4
+            || !readPair(entry, QStringLiteral("lat"), &info.latTop, &info.latBottom)
+            || !readPair(entry, QStringLiteral("lon"), &info.lonLeft, &info.lonRight)) {
+            return fail(error, QStringLiteral("carta %1 incompleta: faltan id, image, frame, lat o lon")
+                                   .arg(loaded.size() + 1));
+        }
+        info.frame = QRectF(QPointF(frame.at(0).toDouble(), frame.at(1).toDouble()),
+                            QPointF(frame.at(2).toDouble(), frame.at(3).toDouble()));
+        loaded.append(info);
+    }
+
+    for (const ChartInfo &info : std::as_const(loaded)) {
+        auto it = std::find_if(m_charts.begin(), m_charts.end(),
+                               [&info](const ChartInfo &known) { return known.id == info.id; });
+        if (it != m_charts.end()) {
+            *it = info;
+        } else {
+            m_charts.append(info);
+        }
+        // Las pizarras que ya la tienen abierta siguen con la version anterior
+        m_open.remove(info.id);
+    }
+    return true;
+}
+
+const ChartInfo *ChartCatalogue::find(const QString &id) const
+{
+    for (const ChartInfo &info : m_charts) {
+        if (info.id == id) {
+            return &info;
+        }
+    }
+    return nullptr;
+}
+
+QString ChartCatalogue::defaultId() const
+{
+    return m_charts.isEmpty() ? QString() : m_charts.first().id;
+}
+
+GeoReference ChartCatalogue::defaultGeoReference() const
+{
+    if (m_charts.isEmpty()) {
+        return GeoReference(QRectF(0.0, 0.0, 1.0, 1.0), 0.0, 0.0, 0.0, 0.0);
+    }
+    return m_charts.first().geoReference();
+}
+
+std::shared_ptr<ChartTiles> ChartCatalogue::open(const QString &id)
+{
+    if (std::shared_ptr<ChartTiles> chart = m_open.value(id).lock()) {
+        return chart;
+    }
+    const ChartInfo *info = find(id);
+    if (!info) {
+        return nullptr;
+    }
+    auto chart = std::make_shared<ChartTiles>(*info);
+    m_open.insert(id, chart);
+    return chart;
+}
@@ -0,0 +1,58 @@
+#ifndef CHARTCATALOGUE_H
+#define CHARTCATALOGUE_H
+
+#include "georeference.h"
+
+#include <QHash>
+#include <QRectF>
+#include <QString>
+#include <QVector>
+
+#include <memory>
+
+class ChartTiles;
+
+// Una carta del catalogo: de donde sale la imagen y como se georreferencia
+struct ChartInfo {
+    QString id;
+    QString name;
+    QString imagePath;
+    QString tileDir;        // piramide ya cortada (<nivel>/<columna>_<fila>.jpg); vacia = se corta al vuelo
+    QRectF frame;           // rectangulo de la imagen (en pixeles) que cubren lat/lon
+    double latTop = 0.0;
+    double latBottom = 0.0;
+    double lonLeft = 0.0;
+    double lonRight = 0.0;
+
+    GeoReference geoReference() const;
+};
+
+// Catalogo de cartas. Al arrancar solo se leen los JSON con los metadatos (el incluido en los
+// recursos y, si existe, el de PROYECTO_IHM_CHARTS o <datos de la aplicacion>/charts/catalogue.json);
+// las imagenes no se tocan hasta que se abre una carta. open() comparte la carta entre las pizarras
+// que la usan y la libera, con sus teselas, cuando ninguna la usa ya.
+class ChartCatalogue
+{
+public:
+    static ChartCatalogue &instance();
+
+    // Anade las cartas de un catalogo JSON; una carta con un id ya conocido sustituye a la anterior
+    bool load(const QString &path, QString *error = nullptr);
+
+    const QVector<ChartInfo> &charts() const { return m_charts; }
+    const ChartInfo *find(const QString &id) const;
+    QString defaultId() const;
+    // La de la carta por defecto; sin cartas, una que lo deja todo en 0 grados
+    GeoReference defaultGeoReference() const;
+
+    // nullptr si el id no esta en el catalogo
+    std::shared_ptr<ChartTiles> open(const QString &id);
+
+private:
+    ChartCatalogue();
+
+    QVector<ChartInfo> m_charts;
+    QHash<QString, std::weak_ptr<ChartTiles>> m_open;
+};
+
+#endif // CHARTCATALOGUE_H
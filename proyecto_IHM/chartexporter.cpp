@@ -0,0 +1,461 @@
+#include "chartexporter.h"
+#include "dibujos.h"
+#include "exportcommon.h"
+
+#include <QPageLayout>
+#include <QPageSize>
+#include <QPainter>
+#include <QPdfWriter>
+#include <QSaveFile>
+#include <QSemaphore>
+#include <QtEndian>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <memory>
+#include <vector>
+
+#ifdef PROYECTO_IHM_HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+namespace {
+using ExportCommon::fail;
+using ExportCommon::kTextInset;
+constexpr double kPointRadius = Dibujos::kPointRadius;
+constexpr int kIdatBytes = 64 * 1024;
+
+quint32 crc32(const char *data, qint64 size, quint32 crc = 0)
+{
+    static const std::array<quint32, 256> table = [] {
+        std::array<quint32, 256> t{};
+        for (quint32 n = 0; n < 256; ++n) {
+            quint32 c = n;
+            for (int k = 0; k < 8; ++k) {
+                c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            }
+            t[n] = c;
+        }
+        return t;
+    }();
+
+    crc = ~crc;
+    for (qint64 i = 0; i < size; ++i) {
+        crc = table[(crc ^ static_cast<uchar>(data[i])) & 0xFF] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+// PNG RGB de 8 bits escrito fila a fila: lo comprimido se vuelca en bloques IDAT segun sale, asi
+// que solo se guarda en memoria una fila y el bloque en curso. Sin zlib los datos van en bloques
+// deflate sin comprimir (fichero valido, mas grande).
+class PngStream
+{
+public:
+    explicit PngStream(const QString &path) : m_file(path) {}
+    ~PngStream()
+    {
+#ifdef PROYECTO_IHM_HAVE_ZLIB
+        if (m_zlibOpen) {
+            deflateEnd(&m_zs);
+        }
+#endif
+    }
+
+    bool open(int width, int height, double dpi)
+    {
+        if (!m_file.open(QIODevice::WriteOnly)) {
+            return false;
+        }
+        m_width = width;
+        m_row.resize(1 + qsizetype(width) * 3);
+        m_file.write("\x89PNG\r\n\x1a\n", 8);
+
+        QByteArray header(13, '\0');
+        qToBigEndian(static_cast<quint32>(width), header.data());
+        qToBigEndian(static_cast<quint32>(height), header.data() + 4);
+        header[8] = 8;      // bits por muestra
+        header[9] = 2;      // RGB
+        writeChunk("IHDR", header);
+
+        QByteArray physical(9, '\0');
+        const auto perMeter = static_cast<quint32>(std::lround(dpi / 0.0254));
+        qToBigEndian(perMeter, physical.data());
+        qToBigEndian(perMeter, physical.data() + 4);
+        physical[8] = 1;    // metros
+        writeChunk("pHYs", physical);
+
+#ifdef PROYECTO_IHM_HAVE_ZLIB
+        m_zlibOpen = deflateInit(&m_zs, 6) == Z_OK;
+        return m_zlibOpen;
+#else
+        m_pending.append("\x78\x01", 2);
+        return true;
+#endif
+    }
+
+    // rgb32 tiene width pixeles; se guarda con el filtro Sub, que abarata la compresion de la carta
+    void writeRow(const QRgb *rgb32)
+    {
+        uchar *out = reinterpret_cast<uchar*>(m_row.data());
+        out[0] = 1;
+        uchar prev[3] = {0, 0, 0};
+        for (int x = 0; x < m_width; ++x) {
+            const uchar px[3] = {static_cast<uchar>(qRed(rgb32[x])),
+                                 static_cast<uchar>(qGreen(rgb32[x])),
+                                 static_cast<uchar>(qBlue(rgb32[x]))};
+            for (int c = 0; c < 3; ++c) {
+                out[1 + x * 3 + c] = static_cast<uchar>(px[c] - prev[c]);
+                prev[c] = px[c];
+            }
+        }
+        compress(out, m_row.size(), false);
+    }
+
+    bool finish()
+    {
+        compress(nullptr, 0, true);
+        flushIdat();
+        writeChunk("IEND", QByteArray());
+        return m_file.commit();
+    }
+
+    QString errorString() const { return m_file.errorString(); }
+
+private:
+    void compress(const uchar *data, qsizetype size, bool last)
+    {
+#ifdef PROYECTO_IHM_HAVE_ZLIB
+        uchar buffer[16 * 1024];
+        m_zs.next_in = const_cast<Bytef*>(data);
+        m_zs.avail_in = static_cast<uInt>(size);
+        do {
+            m_zs.next_out = buffer;
+            m_zs.avail_out = sizeof(buffer);
+            deflate(&m_zs, last ? Z_FINISH : Z_NO_FLUSH);
+            m_pending.append(reinterpret_cast<const char*>(buffer), sizeof(buffer) - m_zs.avail_out);
+        } while (m_zs.avail_out == 0);
+#else
+        // Bloques "stored" de hasta 65535 bytes y Adler-32 al final del flujo zlib
+        for (qsizetype i = 0; i < size; ++i) {
+            m_adlerA = (m_adlerA + data[i]) % 65521;
+            m_adlerB = (m_adlerB + m_adlerA) % 65521;
+        }
+        m_stored.append(reinterpret_cast<const char*>(data), size);
+        while (m_stored.size() >= 65535) {
+            storedBlock(65535, false);
+        }
+        if (last) {
+            storedBlock(m_stored.size(), true);
+            char adler[4];
+            qToBigEndian((m_adlerB << 16) | m_adlerA, adler);
+            m_pending.append(adler, 4);
+        }
+#endif
+        if (m_pending.size() >= kIdatBytes) {
+            flushIdat();
+        }
+    }
+
+#ifndef PROYECTO_IHM_HAVE_ZLIB
+    void storedBlock(qsizetype length, bool final)
+    {
+        char header[5];
+        header[0] = final ? 1 : 0;
+        qToLittleEndian(static_cast<quint16>(length), header + 1);
+        qToLittleEndian(static_cast<quint16>(~length), header + 3);
+        m_pending.append(header, 5);
+        m_pending.append(m_stored.constData(), length);
+        m_stored.remove(0, length);
+    }
+#endif
+
+    void flushIdat()
+    {
+        if (!m_pending.isEmpty()) {
+            writeChunk("IDAT", m_pending);
+            m_pending.clear();
+        }
+    }
+
+    void writeChunk(const char type[4], const QByteArray &data)
+    {
+        char length[4];
+        qToBigEndian(static_cast<quint32>(data.size()), length);
+        m_file.write(length, 4);
+        m_file.write(type, 4);
+        m_file.write(data);
+        char crc[4];
+        qToBigEndian(crc32(data.constData(), data.size(), crc32(type, 4)), crc);
+        m_file.write(crc, 4);
+    }
+
+    QSaveFile m_file;
+    int m_width = 0;
+    QByteArray m_row;
+    QByteArray m_pending;
+#ifdef PROYECTO_IHM_HAVE_ZLIB
+    z_stream m_zs{};
+    bool m_zlibOpen = false;
+#else
+    QByteArray m_stored;
+    quint32 m_adlerA = 1;
+    quint32 m_adlerB = 0;
+#endif
+};
+}
+
+struct ChartExporter::Band {
+    QRect pixels;                   // filas de la imagen de salida
+    std::vector<QRect> tileRects;
+    std::vector<QImage> tiles;      // cada tarea escribe solo su elemento
+    QImage chart;                   // franja de carta de toda la banda, decodificada una vez
+    QRectF chartScene;              // zona de la escena que cubre chart
+    QSemaphore done;
+
+    int tileCount() const { return static_cast<int>(tileRects.size()); }
+};
+
+ChartExporter::ChartExporter(const QString &chartPath, const QRectF &chartRect, const BoardData &board,
+                             QObject *parent)
+    : QObject(parent)
+    , m_chartPath(chartPath)
+    , m_chartRect(chartRect)
+    , m_board(board)
+{
+}
+
+QRectF ChartExporter::exportRegion(const Options &options) const
+{
+    return ExportCommon::exportRegion(m_chartRect, options.region);
+}
+
+QSize ChartExporter::outputSize(const Options &options) const
+{
+    const QRectF region = exportRegion(options);
+    const double scale = options.dpi / kChartDpi;
+    return QSize(static_cast<int>(std::ceil(region.width() * scale)),
+                 static_cast<int>(std::ceil(region.height() * scale)));
+}
+
+bool ChartExporter::exportTo(const QString &path, const Options &options, QString *error)
+{
+    m_cancelled = false;
+    const QRectF region = exportRegion(options);
+    const double scale = options.dpi / kChartDpi;
+    const QSize size = outputSize(options);
+    if (size.isEmpty() || scale <= 0.0) {
+        return fail(error, QStringLiteral("la zona a exportar esta vacia"));
+    }
+
+    // Dos bandas de ancho completo (la que se escribe y la que se pinta), cada una con sus teselas y
+    // su franja de carta, caben en el presupuesto
+    const int tile = std::max(64, options.tileSize);
+    const qint64 rowBytes = qint64(size.width()) * 4;
+    const int bandHeight = static_cast<int>(std::clamp<qint64>(options.memoryBudget / 4 / rowBytes, 16, tile));
+    const int bandCount = (size.height() + bandHeight - 1) / bandHeight;
+
+    const auto makeBand = [&](int index) {
+        auto band = std::make_unique<Band>();
+        const int top = index * bandHeight;
+        band->pixels = QRect(0, top, size.width(), std::min(bandHeight, size.height() - top));
+        for (int x = 0; x < size.width(); x += tile) {
+            band->tileRects.push_back(QRect(x, top, std::min(tile, size.width() - x), band->pixels.height()));
+        }
+        band->tiles.resize(band->tileRects.size());
+        startBand(band.get(), region, scale);
+        return band;
+    };
+
+    std::unique_ptr<PngStream> png;
+    QSaveFile pdfFile(path);
+    std::unique_ptr<QPdfWriter> pdf;
+    QPainter pdfPainter;
+    if (options.format == Format::Png) {
+        png = std::make_unique<PngStream>(path);
+        if (!png->open(size.width(), size.height(), options.dpi)) {
+            return fail(error, png->errorString());
+        }
+    } else {
+        if (!pdfFile.open(QIODevice::WriteOnly)) {
+            return fail(error, pdfFile.errorString());
+        }
+        pdf = std::make_unique<QPdfWriter>(&pdfFile);
+        pdf->setResolution(qRound(options.dpi));
+        pdf->setPageLayout(QPageLayout(QPageSize(QSizeF(size) / options.dpi, QPageSize::Inch, QString(), QPageSize::ExactMatch),
+                                       QPageLayout::Portrait, QMarginsF()));
+        if (!pdfPainter.begin(pdf.get())) {
+            return fail(error, QStringLiteral("no se pudo crear el PDF"));
+        }
+    }
+
+    std::vector<QRgb> row(size.width());
+    std::unique_ptr<Band> current = makeBand(0);
+    for (int b = 0;;) {
+        current->done.acquire(current->tileCount());
+        if (m_cancelled) {
+            break;
+        }
+        // La banda siguiente se pinta mientras esta se escribe
+        std::unique_ptr<Band> next = b + 1 < bandCount ? makeBand(b + 1) : nullptr;
+
+        if (png) {
+            for (int y = 0; y < current->pixels.height(); ++y) {
+                for (int t = 0; t < current->tileCount(); ++t) {
+                    const QImage &image = current->tiles[t];
+                    const auto *line = reinterpret_cast<const QRgb*>(image.constScanLine(y));
+                    std::copy(line, line + image.width(), row.begin() + current->tileRects[t].x());
+                }
+                png->writeRow(row.data());
+            }
+        } else {
+            for (int t = 0; t < current->tileCount(); ++t) {
+                pdfPainter.drawImage(current->tileRects[t].topLeft(), current->tiles[t]);
+            }
+        }
+
+        emit progress(++b, bandCount);
+        if (!next) {
+            break;
+        }
+        current = std::move(next);
+    }
+
+    if (m_cancelled) {
+        m_pool.waitForDone();
+        if (pdfPainter.isActive()) {
+            pdfPainter.end();
+        }
+        return fail(error, QStringLiteral("exportacion cancelada"));
+    }
+    if (png) {
+        if (!png->finish()) {
+            return fail(error, png->errorString());
+        }
+        return true;
+    }
+    pdfPainter.end();
+    if (!pdfFile.commit()) {
+        return fail(error, pdfFile.errorString());
+    }
+    return true;
+}
+
+void ChartExporter::startBand(Band *band, const QRectF &region, double scale)
+{
+    // Una tarea decodifica la franja de carta de la banda y despues lanza las teselas, que la recortan
+    m_pool.start([this, band, region, scale] {
+        if (!m_cancelled) {
+            decodeBandChart(band, region, scale);
+        }
+        // Cuando acaba la ultima tesela la banda puede liberarse: no se vuelve a leer despues
+        const int count = band->tileCount();
+        for (int t = 0; t < count; ++t) {
+            m_pool.start([this, band, t, region, scale] {
+                if (!m_cancelled) {
+                    band->tiles[t] = renderTile(*band, band->tileRects[t], region, scale);
+                }
+                band->done.release();
+            });
+        }
+    });
+}
+
+void ChartExporter::decodeBandChart(Band *band, const QRectF &region, double scale) const
+{
+    const QRectF scene(region.x(), region.y() + band->pixels.y() / scale,
+                       region.width(), band->pixels.height() / scale);
+    const QRectF chartPart = scene.intersected(m_chartRect);
+    if (chartPart.isEmpty()) {
+        return;
+    }
+
+    // Un pixel de margen para que el filtrado en el borde de la banda no deje costuras
+    band->chart = ExportCommon::chartPiece(m_chartPath, m_chartRect, chartPart.adjusted(-1, -1, 1, 1),
+                                           std::min(scale, 1.0), &band->chartScene);
+}
+
+QImage ChartExporter::renderTile(const Band &band, const QRect &pixels, const QRectF &region, double scale) const
+{
+    QImage image(pixels.size(), QImage::Format_RGB32);
+    image.fill(Qt::white);
+
+    // Zona de la escena que cae en la tesela
+    const QRectF scene(region.x() + pixels.x() / scale, region.y() + pixels.y() / scale,
+                       pixels.width() / scale, pixels.height() / scale);
+
+    QPainter painter(&image);
+    painter.setRenderHints(QPainter::Antialiasing | QPainter::SmoothPixmapTransform | QPainter::TextAntialiasing);
+
+    if (!band.chart.isNull() && band.chartScene.intersects(scene)) {
+        // Toda la franja en su sitio: el recorte del pintor deja solo lo que cae en la tesela, y todas
+        // las teselas muestrean la misma imagen, asi que no hay saltos entre ellas
+        const QRectF target((band.chartScene.x() - scene.x()) * scale, (band.chartScene.y() - scene.y()) * scale,
+                            band.chartScene.width() * scale, band.chartScene.height() * scale);
+        painter.drawImage(target, band.chart);
+    }
+
+    painter.scale(scale, scale);
+    painter.translate(-scene.topLeft());
+    paintBoard(&painter, m_board, scene);
+    return image;
+}
+
+void ChartExporter::paintBoard(QPainter *painter, const BoardData &board, const QRectF &visible)
+{
+    const auto shown = [&visible](const QRectF &bounds) {
+        return visible.isEmpty() || visible.intersects(bounds);
+    };
+
+    painter->setBrush(Qt::NoBrush);
+    for (const BoardLine &line : board.lines) {
+        const double pad = line.width;
+        if (!shown(QRectF(line.line.p1(), line.line.p2()).normalized().adjusted(-pad, -pad, pad, pad))) {
+            continue;
+        }
+        painter->setPen(QPen(QColor::fromRgba(line.color), line.width));
+        painter->drawLine(line.line);
+    }
+
+    for (const BoardArc &arc : board.arcs) {
+        const ArcPrimitive &a = arc.arc;
+        if (a.radius <= 0.0) {
+            continue;
+        }
+        const QRectF box(a.center.x() - a.radius, a.center.y() - a.radius, a.radius * 2.0, a.radius * 2.0);
+        const double pad = arc.width;
+        if (!shown(box.adjusted(-pad, -pad, pad, pad))) {
+            continue;
+        }
+        painter->setPen(QPen(QColor::fromRgba(arc.color), arc.width, Qt::SolidLine, Qt::RoundCap, Qt::RoundJoin));
+        painter->drawArc(box, qRound(a.startDeg * 16.0), qRound(std::clamp(a.spanDeg, -360.0, 360.0) * 16.0));
+    }
+
+    for (const BoardPoint &point : board.points) {
+        const double r = kPointRadius + 1.0;
+        if (!shown(QRectF(point.pos.x() - r, point.pos.y() - r, r * 2.0, r * 2.0))) {
+            continue;
+        }
+        const QColor color = QColor::fromRgba(point.color);
+        painter->setPen(QPen(color, 2.0));
+        painter->setBrush(color);
+        painter->drawEllipse(point.pos, kPointRadius, kPointRadius);
+    }
+
+    painter->setBrush(Qt::NoBrush);
+    for (const BoardText &text : board.texts) {
+        const QRectF box(text.pos, text.size);
+        if (text.text.isEmpty() || !shown(box)) {
+            continue;
+        }
+        // Mismo tamano en unidades de escena que en pantalla (96 ppp) sea cual sea el dispositivo
+        const double points = text.fontSize > 0.0f ? text.fontSize : 64.0;
+        QFont font = painter->font();
+        font.setPointSizeF(points * 96.0 / painter->device()->logicalDpiY());
+        painter->setFont(font);
+        painter->setPen(QColor::fromRgba(text.color));
+        painter->drawText(box.adjusted(kTextInset, kTextInset, -kTextInset, -kTextInset),
+                          Qt::AlignLeft | Qt::AlignTop | Qt::TextWordWrap, text.text);
+    }
+}
@@ -0,0 +1,74 @@
+#ifndef CHARTEXPORTER_H
+#define CHARTEXPORTER_H
+
+#include "boardfile.h"
+
+#include <QImage>
+#include <QObject>
+#include <QRect>
+#include <QRectF>
+#include <QString>
+#include <QThreadPool>
+
+#include <atomic>
+
+class QPainter;
+
+// Exportacion de la carta con lo dibujado a PNG o PDF a la resolucion pedida. La imagen se genera
+// por bandas horizontales de teselas: las teselas de una banda se pintan en paralelo en un
+// QThreadPool propio mientras la banda anterior se escribe, de modo que en memoria solo hay dos
+// bandas aunque la salida ocupe cientos de MB. La franja de carta de cada banda se lee una vez con
+// QImageReader (recorte y escalado en el decodificador) y sus teselas la comparten; lo dibujado se
+// pinta desde una copia de la pizarra, sin tocar la escena desde los hilos.
+class ChartExporter : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum class Format { Png, Pdf };
+
+    struct Options {
+        QRectF region;              // zona de la escena a exportar; vacia = toda la carta
+        double dpi = 300.0;
+        Format format = Format::Png;
+        int tileSize = 512;
+        qint64 memoryBudget = 64 * 1024 * 1024;    // para las dos bandas en vuelo y sus franjas de carta
+    };
+
+    // La carta escaneada se considera impresa a esta resolucion: a 300 ppp sale a tamano original
+    static constexpr double kChartDpi = 300.0;
+
+    ChartExporter(const QString &chartPath, const QRectF &chartRect, const BoardData &board,
+                  QObject *parent = nullptr);
+
+    // Tamano en pixeles de la imagen que generaria exportTo
+    QSize outputSize(const Options &options) const;
+
+    // Bloquea hasta terminar; progress se emite desde el hilo que llama
+    bool exportTo(const QString &path, const Options &options, QString *error = nullptr);
+    // Se puede llamar desde un slot conectado a progress (p. ej. el boton de un QProgressDialog)
+    void cancel() { m_cancelled = true; }
+
+    // Pinta lo dibujado de board (lineas, arcos, puntos y textos) en coordenadas de escena. Con
+    // visible no vacio se omite lo que cae fuera.
+    static void paintBoard(QPainter *painter, const BoardData &board, const QRectF &visible = QRectF());
+
+signals:
+    void progress(int done, int total);
+
+private:
+    struct Band;
+
+    QRectF exportRegion(const Options &options) const;
+    void startBand(Band *band, const QRectF &region, double scale);
+    void decodeBandChart(Band *band, const QRectF &region, double scale) const;
+    QImage renderTile(const Band &band, const QRect &pixels, const QRectF &region, double scale) const;
+
+    QString m_chartPath;
+    QRectF m_chartRect;
+    BoardData m_board;
+    QThreadPool m_pool;
+    std::atomic_bool m_cancelled{false};
+};
+
+#endif // CHARTEXPORTER_H
@@ -0,0 +1,170 @@
+#include "charttiles.h"
+
+#include <QDir>
+#include <QImageReader>
+#include <QMutexLocker>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+
+namespace {
+// Por debajo de este tamano un nivel se decodifica entero: son pocas teselas y recortar cada una
+// de la imagen original costaria mas que leerla reducida una vez
+constexpr qint64 kWholeLevelPixels = 2048 * 2048;
+
+std::atomic<quint32> nextSerial{1};
+}
+
+ChartTiles::ChartTiles(const ChartInfo &info)
+    : m_info(info)
+    , m_serial(nextSerial++)
+{
+    // Solo la cabecera: el tamano sale sin decodificar la imagen
+    QImageReader reader(m_info.imagePath);
+    m_size = reader.size();
+    if (!m_size.isEmpty()) {
+        m_levelCount = 1;
+        while (std::max(levelSize(m_levelCount - 1).width(), levelSize(m_levelCount - 1).height()) > kTileSize) {
+            ++m_levelCount;
+        }
+    }
+    m_levelImages.resize(m_levelCount);
+}
+
+int ChartTiles::levelForScale(double scale) const
+{
+    if (m_levelCount == 0 || scale >= 1.0 || scale <= 0.0) {
+        return 0;
+    }
+    const int level = static_cast<int>(std::floor(std::log2(1.0 / scale)));
+    return std::clamp(level, 0, m_levelCount - 1);
+}
+
+QSize ChartTiles::levelSize(int level) const
+{
+    const int step = 1 << level;
+    return QSize(std::max(1, (m_size.width() + step - 1) / step),
+                 std::max(1, (m_size.height() + step - 1) / step));
+}
+
+int ChartTiles::columns(int level) const
+{
+    return (levelSize(level).width() + kTileSize - 1) / kTileSize;
+}
+
+int ChartTiles::rows(int level) const
+{
+    return (levelSize(level).height() + kTileSize - 1) / kTileSize;
+}
+
+QRect ChartTiles::tilePixels(int level, int column, int row) const
+{
+    return QRect(column * kTileSize, row * kTileSize, kTileSize, kTileSize)
+        .intersected(QRect(QPoint(0, 0), levelSize(level)));
+}
+
+QRectF ChartTiles::tileSceneRect(int level, int column, int row) const
+{
+    const QRect pixels = tilePixels(level, column, row);
+    const double step = 1 << level;
+    return QRectF(pixels.x() * step, pixels.y() * step, pixels.width() * step, pixels.height() * step)
+        .intersected(sceneRect());
+}
+
+QImage ChartTiles::decodeTile(int level, int column, int row) const
+{
+    const QRect pixels = tilePixels(level, column, row);
+    if (level < 0 || level >= m_levelCount || pixels.isEmpty()) {
+        return QImage();
+    }
+
+    if (!m_info.tileDir.isEmpty()) {
+        const QString path = QDir(m_info.tileDir)
+                                 .filePath(QStringLiteral("%1/%2_%3.jpg").arg(level).arg(column).arg(row));
+        QImage image;
+        if (image.load(path)) {
+            if (image.size() != pixels.size()) {
+                image = image.scaled(pixels.size(), Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+            }
+            return image;
+        }
+    }
+    return decodeFromSource(level, pixels);
+}
+
+QImage ChartTiles::decodeFromSource(int level, const QRect &pixels) const
+{
+    const QSize whole = levelSize(level);
+    if (qint64(whole.width()) * whole.height() <= kWholeLevelPixels) {
+        QMutexLocker locker(&m_levelMutex);
+        QImage &image = m_levelImages[level];
+        if (image.isNull()) {
+            QImageReader reader(m_info.imagePath);
+            if (whole != m_size) {
+                reader.setScaledSize(whole);
+            }
+            image = reader.read();
+        }
+        return image.isNull() ? QImage() : image.copy(pixels);
+    }
+
+    // Toda la fila de teselas de una vez: un JPEG se decodifica por lineas completas, asi que recortar
+    // cada tesela por separado repetiria el trabajo de las demas columnas
+    const int row = pixels.y() / kTileSize;
+    const std::shared_ptr<RowStrip> strip = rowStrip(level, row);
+    QMutexLocker locker(&strip->mutex);
+    if (!strip->decoded) {
+        // El decodificador recorta y reduce: no hace falta tener la carta entera en memoria
+        const int step = 1 << level;
+        const QRect rowPixels = QRect(0, row * kTileSize, whole.width(), kTileSize)
+                                    .intersected(QRect(QPoint(0, 0), whole));
+        const QRect source = QRect(0, rowPixels.y() * step, m_size.width(), rowPixels.height() * step)
+                                 .intersected(QRect(QPoint(0, 0), m_size));
+        QImageReader reader(m_info.imagePath);
+        reader.setClipRect(source);
+        if (level > 0) {
+            reader.setScaledSize(rowPixels.size());
+        }
+        strip->image = reader.read();
+        strip->decoded = true;
+    }
+    if (strip->image.isNull()) {
+        return QImage();
+    }
+    return strip->image.copy(pixels.x(), 0, pixels.width(), pixels.height());
+}
+
+std::shared_ptr<ChartTiles::RowStrip> ChartTiles::rowStrip(int level, int row) const
+{
+    QMutexLocker locker(&m_stripMutex);
+    for (int i = m_strips.size() - 1; i >= 0; --i) {
+        if (m_strips[i]->level == level && m_strips[i]->row == row) {
+            std::shared_ptr<RowStrip> strip = m_strips[i];
+            m_strips.remove(i);
+            m_strips.append(strip);
+            return strip;
+        }
+    }
+
+    auto strip = std::make_shared<RowStrip>();
+    strip->level = level;
+    strip->row = row;
+    m_strips.append(strip);
+
+    // Se descartan las mas antiguas; una que aun se este leyendo sigue viva en quien la pidio
+    qint64 bytes = 0;
+    for (const std::shared_ptr<RowStrip> &kept : std::as_const(m_strips)) {
+        bytes += stripBytes(kept->level);
+    }
+    while (m_strips.size() > 1 && bytes > kStripBytes) {
+        bytes -= stripBytes(m_strips.first()->level);
+        m_strips.removeFirst();
+    }
+    return strip;
+}
+
+qint64 ChartTiles::stripBytes(int level) const
+{
+    return qint64(levelSize(level).width()) * kTileSize * 4;
+}
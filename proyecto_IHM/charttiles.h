@@ -0,0 +1,78 @@
+#ifndef CHARTTILES_H
+#define CHARTTILES_H
+
+#include "chartcatalogue.h"
+
+#include <QImage>
+#include <QMutex>
+#include <QRect>
+#include <QRectF>
+#include <QSize>
+#include <QVector>
+
+#include <memory>
+
+// Piramide de teselas de una carta. El nivel 0 es la imagen original y cada nivel tiene la mitad
+// de lado que el anterior, hasta que cabe en una tesela. Al construirla solo se lee la cabecera de
+// la imagen; cada tesela se decodifica cuando se pide, del fichero ya cortado si la carta trae
+// piramide o de la imagen original. Los niveles pequenos se decodifican enteros una vez y se
+// trocean; en los grandes se decodifica una vez la franja de una fila de teselas (recortada y
+// reducida en el decodificador) y se trocea mientras siga en memoria. Las teselas ya decodificadas
+// las guarda TileCache.
+class ChartTiles
+{
+public:
+    static constexpr int kTileSize = 512;
+
+    explicit ChartTiles(const ChartInfo &info);
+
+    const ChartInfo &info() const { return m_info; }
+    // Distinto para cada carta abierta, aunque sea la misma del catalogo
+    quint32 serial() const { return m_serial; }
+    // Tamano de la imagen original; la carta ocupa (0, 0, ancho, alto) en la escena
+    QSize size() const { return m_size; }
+    QRectF sceneRect() const { return QRectF(QPointF(0.0, 0.0), QSizeF(m_size)); }
+    bool isNull() const { return m_size.isEmpty(); }
+
+    int levelCount() const { return m_levelCount; }
+    // Nivel cuyas teselas se ven a 1:1 o algo mayores con scale pixeles de pantalla por pixel de carta
+    int levelForScale(double scale) const;
+    QSize levelSize(int level) const;
+    int columns(int level) const;
+    int rows(int level) const;
+    // Pixeles que ocupa la tesela en su nivel y rectangulo que cubre en la escena
+    QRect tilePixels(int level, int column, int row) const;
+    QRectF tileSceneRect(int level, int column, int row) const;
+
+    // Se puede llamar desde cualquier hilo
+    QImage decodeTile(int level, int column, int row) const;
+
+private:
+    // Franja de una fila de teselas; su mutex la protege mientras se decodifica, de modo que dos
+    // teselas de la misma fila esperan a una sola lectura y filas distintas se leen en paralelo
+    struct RowStrip {
+        int level = 0;
+        int row = 0;
+        QMutex mutex;
+        QImage image;
+        bool decoded = false;
+    };
+
+    // Franjas recientes que se conservan, en bytes (la de nivel 0 de una carta de 8000 px son 16 MB)
+    static constexpr qint64 kStripBytes = 64 * 1024 * 1024;
+
+    QImage decodeFromSource(int level, const QRect &pixels) const;
+    std::shared_ptr<RowStrip> rowStrip(int level, int row) const;
+    qint64 stripBytes(int level) const;
+
+    ChartInfo m_info;
+    quint32 m_serial = 0;
+    QSize m_size;
+    int m_levelCount = 0;
+    mutable QMutex m_levelMutex;
+    mutable QVector<QImage> m_levelImages;          // niveles pequenos decodificados enteros
+    mutable QMutex m_stripMutex;
+    mutable QVector<std::shared_ptr<RowStrip>> m_strips;   // la mas reciente al final
+};
+
+#endif // CHARTTILES_H
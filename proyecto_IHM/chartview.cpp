@@ -0,0 +1,397 @@
+#include "chartview.h"
+#include "charttiles.h"
+#include "tilecache.h"
+
+#include <QPaintEvent>
+#include <QPainter>
+#include <QScreen>
+#include <QScrollBar>
+#include <QTimer>
+#include <QVariantAnimation>
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+namespace {
+constexpr int kZoomDurationMs = 200;
+
+// Deslizamiento al soltar: la velocidad de los ultimos kPanSampleWindowMs decae exponencialmente
+constexpr qint64 kPanSampleWindowMs = 100;
+constexpr qint64 kPanStillMs = 50;          // quieto al menos esto antes de soltar: no desliza
+constexpr double kFlingMinSpeed = 300.0;    // px/s
+constexpr double kFlingMaxSpeed = 6000.0;
+constexpr double kFlingStopSpeed = 20.0;
+constexpr double kFlingTimeConstant = 0.325;    // s
+
+int frameIntervalMs(const QWidget *widget)
+{
+    const QScreen *screen = widget->screen();
+    const double hz = screen && screen->refreshRate() > 0.0 ? screen->refreshRate() : 60.0;
+    return std::max(1, qRound(1000.0 / hz));
+}
+}
+
+ChartView::ChartView(QWidget *parent)
+    : QGraphicsView(parent)
+    , m_tiles(new TileCache(this))
+{
+    // Un fondo estatico y pocos items moviles: se repinta solo la region sucia, el fondo sale
+    // de la cache de QGraphicsView y los items restauran su propio estado del painter
+    setViewportUpdateMode(QGraphicsView::SmartViewportUpdate);
+    setCacheMode(QGraphicsView::CacheBackground);
+    setOptimizationFlags(QGraphicsView::DontSavePainterState
+                         | QGraphicsView::DontAdjustForAntialiasing);
+
+    connect(m_tiles, &TileCache::tileReady, this, &ChartView::tileReady);
+
+    // Los fotogramas los marca el temporizador de animaciones de Qt: un QTimer de 16 ms, no el
+    // refresco de la pantalla
+    m_zoomAnimation = new QVariantAnimation(this);
+    m_zoomAnimation->setDuration(kZoomDurationMs);
+    m_zoomAnimation->setEasingCurve(QEasingCurve::OutCubic);
+    m_zoomAnimation->setStartValue(0.0);
+    m_zoomAnimation->setEndValue(1.0);
+    connect(m_zoomAnimation, &QVariantAnimation::valueChanged, this, [this](const QVariant &value) {
+        zoomStep(value.toDouble());
+    });
+    connect(m_zoomAnimation, &QVariantAnimation::finished, this, &ChartView::zoomSettled);
+
+    // El raton puede mandar varios movimientos por fotograma: se suman y se desplaza una vez
+    m_panClock.start();
+    m_panTimer = new QTimer(this);
+    m_panTimer->setSingleShot(true);
+    m_panTimer->setTimerType(Qt::PreciseTimer);
+    connect(m_panTimer, &QTimer::timeout, this, &ChartView::flushPan);
+
+    m_flingAnimation = new QVariantAnimation(this);
+    m_flingAnimation->setStartValue(0.0);
+    connect(m_flingAnimation, &QVariantAnimation::valueChanged, this, [this](const QVariant &value) {
+        flingStep(value.toDouble());
+    });
+    connect(m_flingAnimation, &QVariantAnimation::finished, this, &ChartView::endPan);
+}
+
+void ChartView::setChart(std::shared_ptr<ChartTiles> chart)
+{
+    m_chart = std::move(chart);
+    m_chartRect = m_chart ? m_chart->sceneRect() : QRectF();
+    m_tiles->setChart(m_chart);
+    m_level = -1;
+    resetCachedContent();
+    viewport()->update();
+}
+
+void ChartView::panBy(const QPoint &delta, quint64 timestampMs)
+{
+    // Arrastrar durante un zoom animado lo deja en el zoom alcanzado; si no, zoomStep volveria a
+    // fijar el ancla y desharia el arrastre en cada fotograma
+    stopZoom();
+    m_flingAnimation->stop();
+    m_pendingPan += delta;
+
+    m_panSamples.append(qMakePair(timestampMs, delta));
+    while (timestampMs - m_panSamples.first().first > quint64(kPanSampleWindowMs)) {
+        m_panSamples.removeFirst();
+    }
+
+    const qint64 now = m_panClock.elapsed();
+
+    // El primer movimiento tras un fotograma sale ya; los siguientes esperan al proximo
+    const qint64 wait = m_lastPanFrame < 0 ? 0 : m_lastPanFrame + frameIntervalMs(this) - now;
+    if (wait <= 0) {
+        m_panTimer->stop();
+        flushPan();
+    } else if (!m_panTimer->isActive()) {
+        m_panTimer->start(int(wait));
+    }
+}
+
+void ChartView::releasePan(quint64 timestampMs)
+{
+    m_panTimer->stop();
+    flushPan();
+
+    QPointF velocity;
+    if (!m_panSamples.isEmpty() && timestampMs - m_panSamples.last().first <= quint64(kPanStillMs)) {
+        QPoint moved;
+        for (const auto &sample : std::as_const(m_panSamples)) {
+            moved += sample.second;
+        }
+        const double span = std::max<quint64>(timestampMs - m_panSamples.first().first, 8) / 1000.0;
+        velocity = QPointF(moved) / span;
+    }
+    m_panSamples.clear();
+
+    double speed = std::hypot(velocity.x(), velocity.y());
+    if (speed < kFlingMinSpeed) {
+        endPan();
+        return;
+    }
+    if (speed > kFlingMaxSpeed) {
+        velocity *= kFlingMaxSpeed / speed;
+        speed = kFlingMaxSpeed;
+    }
+    // Hasta que la velocidad baja de kFlingStopSpeed
+    const double duration = kFlingTimeConstant * std::log(speed / kFlingStopSpeed);
+    m_flingVelocity = velocity;
+    m_flingApplied = QPoint();
+    m_flingAnimation->setDuration(qRound(duration * 1000.0));
+    m_flingAnimation->setEndValue(duration);
+    m_flingAnimation->start();
+}
+
+void ChartView::endPan()
+{
+    m_panTimer->stop();
+    flushPan();
+    m_flingAnimation->stop();
+    m_panSamples.clear();
+    m_panDirection = QPointF();
+}
+
+bool ChartView::isFlinging() const
+{
+    return m_flingAnimation->state() == QAbstractAnimation::Running;
+}
+
+void ChartView::flushPan()
+{
+    if (m_pendingPan.isNull()) {
+        return;
+    }
+    m_lastPanFrame = m_panClock.elapsed();
+    scrollContents(std::exchange(m_pendingPan, QPoint()));
+}
+
+void ChartView::scrollContents(const QPoint &delta)
+{
+    // La carta se mueve con el raton: lo que va a aparecer esta en sentido contrario
+    notePan(-delta);
+    // Con SmartViewportUpdate y la cache del fondo, QGraphicsView::scrollContentsBy desplaza los
+    // pixeles ya pintados y solo expone las franjas nuevas
+    horizontalScrollBar()->setValue(horizontalScrollBar()->value() - delta.x());
+    verticalScrollBar()->setValue(verticalScrollBar()->value() - delta.y());
+}
+
+void ChartView::flingStep(double seconds)
+{
+    const double travelled = kFlingTimeConstant * (1.0 - std::exp(-seconds / kFlingTimeConstant));
+    const QPoint target = (m_flingVelocity * travelled).toPoint();
+    const QPoint delta = target - m_flingApplied;
+    if (delta.isNull()) {
+        return;
+    }
+    const QPoint before(horizontalScrollBar()->value(), verticalScrollBar()->value());
+    scrollContents(delta);
+    m_flingApplied = target;
+    // Contra el borde de la carta no queda nada que deslizar
+    if (before == QPoint(horizontalScrollBar()->value(), verticalScrollBar()->value())) {
+        endPan();
+    }
+}
+
+void ChartView::notePan(const QPoint &delta)
+{
+    const double length = std::hypot(delta.x(), delta.y());
+    if (length <= 0.0) {
+        return;
+    }
+    // Suavizado: un tiron lateral no cambia de golpe lo que se adelanta
+    const QPointF direction = 0.5 * m_panDirection + 0.5 * QPointF(delta) / length;
+    const double directionLength = std::hypot(direction.x(), direction.y());
+    m_panDirection = directionLength > 1e-6 ? direction / directionLength : QPointF();
+}
+
+double ChartView::targetZoom() const
+{
+    return m_zoomAnimating ? m_zoomTo : zoom();
+}
+
+void ChartView::setZoom(double zoom)
+{
+    endPan();
+    stopZoom();
+    resetTransform();
+    scale(zoom, zoom);
+}
+
+void ChartView::zoomTo(double zoom, const QPoint &anchor)
+{
+    endPan();
+    m_zoomAnimation->stop();
+    m_zoomFrom = this->zoom();
+    m_zoomTo = zoom;
+    m_zoomAnchor = anchor;
+    m_zoomAnchorScene = mapToScene(anchor);
+    if (qFuzzyCompare(m_zoomFrom, m_zoomTo)) {
+        m_zoomAnimating = false;
+        return;
+    }
+
+    // Durante la animacion no se piden teselas de los niveles intermedios: se pinta con el mas
+    // reducido de los dos extremos (ya en la cache o casi) y se adelantan las del zoom final
+    const double dpr = devicePixelRatioF();
+    if (m_chart && !m_chart->isNull()) {
+        const int finalLevel = m_chart->levelForScale(m_zoomTo * dpr);
+        m_zoomLevel = std::max(m_chart->levelForScale(m_zoomFrom * dpr), finalLevel);
+        const QRectF finalVisible(m_zoomAnchorScene - QPointF(anchor) / m_zoomTo,
+                                  QSizeF(viewport()->size()) / m_zoomTo);
+        const QRectF visible = mapToScene(viewport()->rect()).boundingRect();
+        m_tiles->beginPass();
+        requestTiles(m_zoomLevel, visible.united(finalVisible), true);
+        requestTiles(finalLevel, finalVisible, true);
+        m_tiles->endPass();
+    }
+    m_zoomAnimating = true;
+    m_zoomAnimation->start();
+}
+
+void ChartView::stopZoom()
+{
+    if (!m_zoomAnimating) {
+        return;
+    }
+    m_zoomAnimation->stop();
+    zoomSettled();
+}
+
+void ChartView::zoomStep(double progress)
+{
+    if (!m_zoomAnimating) {
+        return;
+    }
+    // Interpolado en escala logaritmica: cada fotograma acerca lo mismo en proporcion
+    const double zoom = std::exp(std::log(m_zoomFrom) + progress * (std::log(m_zoomTo) - std::log(m_zoomFrom)));
+    const ViewportAnchor anchor = transformationAnchor();
+    setTransformationAnchor(QGraphicsView::NoAnchor);
+    setTransform(QTransform::fromScale(zoom, zoom));
+    setTransformationAnchor(anchor);
+    const QPoint drift = mapFromScene(m_zoomAnchorScene) - m_zoomAnchor;
+    horizontalScrollBar()->setValue(horizontalScrollBar()->value() + drift.x());
+    verticalScrollBar()->setValue(verticalScrollBar()->value() + drift.y());
+    emit zoomChanged(zoom);
+}
+
+void ChartView::zoomSettled()
+{
+    m_zoomAnimating = false;
+    // Repinta con el nivel nitido del zoom final
+    resetCachedContent();
+    viewport()->update();
+}
+
+void ChartView::paintEvent(QPaintEvent *event)
+{
+    QGraphicsView::paintEvent(event);
+    emit framePainted();
+}
+
+void ChartView::drawBackground(QPainter *painter, const QRectF &rect)
+{
+    QGraphicsView::drawBackground(painter, rect);
+
+    const QRectF exposed = rect.intersected(m_chartRect);
+    if (!m_chart || m_chart->isNull() || exposed.isEmpty()) {
+        return;
+    }
+
+    // Pixeles de dispositivo por pixel de carta: decide el nivel de la piramide
+    const double scale = painter->worldTransform().m11() * painter->device()->devicePixelRatioF();
+    const int level = m_zoomAnimating ? m_zoomLevel : m_chart->levelForScale(scale);
+    m_level = level;
+    const double tileSide = double(ChartTiles::kTileSize << level);
+    const int firstColumn = std::max(0, int(std::floor(exposed.left() / tileSide)));
+    const int lastColumn = std::min(m_chart->columns(level) - 1, int(std::floor(exposed.right() / tileSide)));
+    const int firstRow = std::max(0, int(std::floor(exposed.top() / tileSide)));
+    const int lastRow = std::min(m_chart->rows(level) - 1, int(std::floor(exposed.bottom() / tileSide)));
+
+    // Los items no restauran el painter (DontSavePainterState): el filtrado se deja como estaba
+    const bool smooth = painter->testRenderHint(QPainter::SmoothPixmapTransform);
+    const bool scaled = std::abs(scale * (1 << level) - 1.0) > 1e-3;
+    for (int row = firstRow; row <= lastRow; ++row) {
+        for (int column = firstColumn; column <= lastColumn; ++column) {
+            const QRectF target = m_chart->tileSceneRect(level, column, row);
+            const QPixmap tile = level == m_chart->levelCount() - 1 ? m_tiles->overview()
+                                                                    : m_tiles->find(level, column, row);
+            if (tile.isNull()) {
+                drawFallback(painter, level, target);
+                continue;
+            }
+            painter->setRenderHint(QPainter::SmoothPixmapTransform, scaled);
+            painter->drawPixmap(target, tile, QRectF(tile.rect()));
+        }
+    }
+    painter->setRenderHint(QPainter::SmoothPixmapTransform, smooth);
+
+    if (!m_zoomAnimating) {
+        scheduleTiles(level);
+    }
+}
+
+void ChartView::drawFallback(QPainter *painter, int level, const QRectF &target)
+{
+    // El primer nivel mas reducido que ya este decodificado; el ultimo (la carta entera en una
+    // tesela) siempre lo esta
+    const int coarsest = m_chart->levelCount() - 1;
+    for (int l = level + 1; l <= coarsest; ++l) {
+        const double side = double(ChartTiles::kTileSize << l);
+        const int column = int(target.center().x() / side);
+        const int row = int(target.center().y() / side);
+        const QPixmap tile = l == coarsest ? m_tiles->overview() : m_tiles->find(l, column, row);
+        if (tile.isNull()) {
+            continue;
+        }
+        const double step = 1 << l;
+        const QRectF tileRect = m_chart->tileSceneRect(l, column, row);
+        const QRectF source = QRectF((target.topLeft() - tileRect.topLeft()) / step, target.size() / step)
+                                  .intersected(QRectF(tile.rect()));
+        painter->setRenderHint(QPainter::SmoothPixmapTransform, true);
+        painter->drawPixmap(target, tile, source);
+        return;
+    }
+}
+
+void ChartView::scheduleTiles(int level)
+{
+    const QRectF visible = mapToScene(viewport()->rect()).boundingRect().intersected(m_chartRect);
+    if (visible.isEmpty()) {
+        return;
+    }
+    const double side = double(ChartTiles::kTileSize << level);
+
+    m_tiles->beginPass();
+    requestTiles(level, visible, true);
+    // Una corona de teselas alrededor y, mientras se arrastra, una pantalla por delante
+    requestTiles(level, visible.adjusted(-side, -side, side, side), false);
+    if (!m_panDirection.isNull()) {
+        const QPointF ahead(m_panDirection.x() * visible.width(), m_panDirection.y() * visible.height());
+        requestTiles(level, visible.translated(ahead), false);
+    }
+    m_tiles->endPass();
+}
+
+void ChartView::requestTiles(int level, const QRectF &area, bool visible)
+{
+    // El nivel mas reducido ya lo tiene la cache desde setChart
+    const QRectF clipped = area.intersected(m_chartRect);
+    if (clipped.isEmpty() || level == m_chart->levelCount() - 1) {
+        return;
+    }
+    const double side = double(ChartTiles::kTileSize << level);
+    const int lastColumn = std::min(m_chart->columns(level) - 1, int(std::floor(clipped.right() / side)));
+    const int lastRow = std::min(m_chart->rows(level) - 1, int(std::floor(clipped.bottom() / side)));
+    for (int row = std::max(0, int(std::floor(clipped.top() / side))); row <= lastRow; ++row) {
+        for (int column = std::max(0, int(std::floor(clipped.left() / side))); column <= lastColumn; ++column) {
+            m_tiles->request(level, column, row, visible);
+        }
+    }
+}
+
+void ChartView::tileReady(int level, int column, int row)
+{
+    // Sustituye en la cache del fondo lo que se pinto con el nivel reducido
+    if (m_chart && level == m_level) {
+        invalidateScene(m_chart->tileSceneRect(level, column, row), QGraphicsScene::BackgroundLayer);
+    }
+}
@@ -0,0 +1,108 @@
+#ifndef CHARTVIEW_H
+#define CHARTVIEW_H
+
+#include <QElapsedTimer>
+#include <QGraphicsView>
+#include <QPair>
+#include <QPointF>
+#include <QRectF>
+#include <QVector>
+
+#include <memory>
+
+class QPaintEvent;
+class QTimer;
+class QVariantAnimation;
+class ChartTiles;
+class TileCache;
+
+// Vista de la carta: QGraphicsView que avisa cuando un fotograma termina de pintarse.
+// La carta no es un item de la escena sino el fondo de la vista, cacheado por QGraphicsView:
+// mover una herramienta solo repinta la zona que ocupaba y la que ocupa, sin redibujar la carta.
+// El fondo se pinta con las teselas del nivel de la piramide que corresponde al zoom; las que aun
+// no estan decodificadas se pintan ampliando un nivel mas reducido y se repintan al llegar.
+// El zoom animado mantiene fijo el punto bajo el cursor; mientras dura se pinta con el nivel mas
+// reducido de los dos extremos y, al terminar, con las teselas nitidas del zoom final. Empezar a
+// arrastrar lo detiene en el zoom que lleve.
+// El arrastre mueve las barras de desplazamiento a lo sumo una vez por fotograma: QGraphicsView
+// desplaza lo ya pintado del viewport y la cache del fondo, y solo pinta las franjas que entran.
+// Al soltar con velocidad, la carta sigue deslizandose y frena sola.
+class ChartView : public QGraphicsView
+{
+    Q_OBJECT
+
+public:
+    explicit ChartView(QWidget *parent = nullptr);
+
+    // La carta ocupa el rectangulo (0, 0, ancho, alto) de la escena
+    void setChart(std::shared_ptr<ChartTiles> chart);
+    const std::shared_ptr<ChartTiles> &chart() const { return m_chart; }
+    QRectF chartRect() const { return m_chartRect; }
+    TileCache *tileCache() const { return m_tiles; }
+
+    // Arrastre con el raton: delta es lo que se ha movido el raton (la carta se mueve con el).
+    // releasePan al soltar lanza el deslizamiento si se soltaba en marcha; endPan lo corta todo.
+    // timestampMs es el QInputEvent::timestamp() del evento: la velocidad al soltar sale de el y no
+    // del reloj, asi una reproduccion desliza igual que la grabacion aunque vaya mas rapida.
+    void panBy(const QPoint &delta, quint64 timestampMs);
+    void releasePan(quint64 timestampMs);
+    void endPan();
+    bool isFlinging() const;
+
+    // Pixeles del viewport por pixel de carta
+    double zoom() const { return transform().m11(); }
+    // Zoom al que se llegara al terminar la animacion en curso
+    double targetZoom() const;
+    bool isZoomAnimating() const { return m_zoomAnimating; }
+    // Sin animacion; el ancla es la de transformationAnchor
+    void setZoom(double zoom);
+    // Animado, con el punto de la escena bajo anchor (viewport) quieto en pantalla
+    void zoomTo(double zoom, const QPoint &anchor);
+
+signals:
+    // Emitida al terminar cada pintado del viewport (lo que el usuario ya ve en pantalla)
+    void framePainted();
+    // En cada fotograma del zoom animado
+    void zoomChanged(double zoom);
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+    void drawBackground(QPainter *painter, const QRectF &rect) override;
+
+private:
+    void drawFallback(QPainter *painter, int level, const QRectF &target);
+    void scheduleTiles(int level);
+    void requestTiles(int level, const QRectF &area, bool visible);
+    void tileReady(int level, int column, int row);
+    void notePan(const QPoint &delta);
+    void flushPan();
+    void scrollContents(const QPoint &delta);
+    void flingStep(double seconds);
+    void stopZoom();
+    void zoomStep(double progress);
+    void zoomSettled();
+
+    std::shared_ptr<ChartTiles> m_chart;
+    QRectF m_chartRect;
+    TileCache *m_tiles = nullptr;
+    int m_level = -1;           // nivel del ultimo fondo pintado
+    QPointF m_panDirection;     // unitario mientras se arrastra o desliza; nulo si no
+    QPoint m_pendingPan;        // acumulado hasta el siguiente fotograma
+    QTimer *m_panTimer = nullptr;
+    QElapsedTimer m_panClock;
+    qint64 m_lastPanFrame = -1;
+    QVector<QPair<quint64, QPoint>> m_panSamples;   // ultimos movimientos (hora del evento), para la velocidad al soltar
+    QVariantAnimation *m_flingAnimation = nullptr;
+    QPointF m_flingVelocity;    // px/s al soltar
+    QPoint m_flingApplied;      // pixeles ya desplazados desde que se solto
+
+    QVariantAnimation *m_zoomAnimation = nullptr;
+    bool m_zoomAnimating = false;
+    double m_zoomFrom = 1.0;
+    double m_zoomTo = 1.0;
+    QPoint m_zoomAnchor;
+    QPointF m_zoomAnchorScene;
+    int m_zoomLevel = 0;        // nivel fijo durante la animacion
+};
+
+#endif // CHARTVIEW_H
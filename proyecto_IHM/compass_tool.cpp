@@ -1,4 +1,5 @@
 #include "compass_tool.h"
+#include "toolrendercache.h"
 
 #include <QtMath>
 #include <algorithm>
@@ -12,6 +13,7 @@
 #include <QGraphicsSvgItem>
 #include <QGraphicsView>
 #include <QEvent>
+#include <QLineF>
 #include <QTransform>
 
 namespace
@@ -21,12 +23,32 @@ class CompassLegItem final : public QGraphicsSvgItem
 public:
     explicit CompassLegItem(const QString &fileName, QGraphicsItem *parent = nullptr)
         : QGraphicsSvgItem(fileName, parent)
+        , m_renderCache(this, fileName)
     {
         setAcceptedMouseButtons(Qt::NoButton);
         setFlag(QGraphicsItem::ItemStacksBehindParent, true);
+        setFlag(QGraphicsItem::ItemSendsGeometryChanges, true);
+    }
+
+    // El compas avisa cuando se mueve o gira el conjunto
+    void touchRenderCache() { m_renderCache.touch(); }
+
+    void paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget) override
+    {
+        if (!m_renderCache.paint(painter, option)) {
+            QGraphicsSvgItem::paint(painter, option, widget);
+        }
     }
 
 protected:
+    QVariant itemChange(GraphicsItemChange change, const QVariant &value) override
+    {
+        if (change == ItemRotationHasChanged) {
+            m_renderCache.touch();
+        }
+        return QGraphicsSvgItem::itemChange(change, value);
+    }
+
     void wheelEvent(QGraphicsSceneWheelEvent *event) override
     {
         if (!event || !(event->modifiers() & Qt::AltModifier)) {
@@ -55,6 +77,9 @@ protected:
             event->ignore();
         }
     }
+
+private:
+    ToolRenderCache m_renderCache;
 };
 
 constexpr QPointF kLegHingeLocal(0.0, 10.0);
@@ -102,6 +127,7 @@ void CompassTool::setToolSize(const QSizeF &sizePx)
 void CompassTool::setView(QGraphicsView *view)
 {
     m_view = view;
+    invalidatePickShape();
 }
 
 bool CompassTool::adjustOpeningSteps(double steps)
@@ -118,6 +144,15 @@ bool CompassTool::adjustOpeningSteps(double steps)
     return true;
 }
 
+void CompassTool::setPose(double rotationDeg, double openingDeg)
+{
+    m_angleDeg = rotationDeg;
+    setRotation(m_angleDeg);
+    m_openingDeg = std::clamp(openingDeg, kOpeningMinDeg, kOpeningMaxDeg);
+    applyLegTransforms();
+    updateGeometry();
+}
+
 CompassTool* CompassTool::toggleTool(CompassTool *&tool,
                                      QGraphicsScene *scene,
                                      QGraphicsView *view,
@@ -146,7 +181,6 @@ CompassTool* CompassTool::toggleTool(CompassTool *&tool,
     tool->setVisible(visible);
     if (visible) {
         tool->setZValue(1000);
-        scene->update();
     }
 
     return tool;
@@ -173,15 +207,88 @@ QRectF CompassTool::boundingRect() const
 
 QPainterPath CompassTool::shape() const
 {
-    QPainterPath path;
-    if (m_fixedLeg) {
-        path.addPath(m_fixedLeg->mapToParent(m_fixedLeg->shape()));
+    if (!m_localShapeValid) {
+        QPainterPath path;
+        if (m_fixedLeg) {
+            path.addPath(m_fixedLeg->mapToParent(m_fixedLeg->shape()));
+        }
+        if (m_movingLeg) {
+            path.addPath(m_movingLeg->mapToParent(m_movingLeg->shape()));
+        }
+        path.addEllipse(QPointF(0.0, 0.0), kHingePickRadiusPx, kHingePickRadiusPx);
+        m_localShape = path;
+        m_localShapeValid = true;
     }
-    if (m_movingLeg) {
-        path.addPath(m_movingLeg->mapToParent(m_movingLeg->shape()));
+    return m_localShape;
+}
+
+bool CompassTool::hitTest(const QPointF &scenePos, double tolerance) const
+{
+    if (!isVisible()) {
+        return false;
+    }
+
+    // Con ItemIgnoresTransformations la forma en escena depende del zoom de la vista
+    const QTransform viewTransform = m_view ? m_view->transform() : QTransform();
+    if (!m_scenePickValid || viewTransform != m_scenePickViewTransform) {
+        m_scenePickShape = itemToSceneTransform().map(shape());
+        m_scenePickBounds = m_scenePickShape.boundingRect();
+        m_scenePickViewTransform = viewTransform;
+        m_scenePickValid = true;
+    }
+
+    const double tol = std::max(tolerance, 0.0);
+    if (!m_scenePickBounds.adjusted(-tol, -tol, tol, tol).contains(scenePos)) {
+        return false;
+    }
+    if (m_scenePickShape.contains(scenePos)) {
+        return true;
+    }
+    return tol > 0.0
+        && m_scenePickShape.intersects(QRectF(scenePos.x() - tol, scenePos.y() - tol, tol * 2.0, tol * 2.0));
+}
+
+void CompassTool::invalidatePickShape()
+{
+    m_scenePickValid = false;
+}
+
+QTransform CompassTool::itemToSceneTransform() const
+{
+    if (!m_view) {
+        return sceneTransform();
+    }
+    const QTransform viewport = m_view->viewportTransform();
+    return deviceTransform(viewport) * viewport.inverted();
+}
+
+QPointF CompassTool::legTipScenePos(const QGraphicsItem *leg) const
+{
+    const QPointF tipLocal(leg->boundingRect().right(), kLegHingeLocal.y());
+    return itemToSceneTransform().map(leg->mapToParent(tipLocal));
+}
+
+void CompassTool::rotateAroundItemPoint(const QPointF &itemPoint, double deltaDeg)
+{
+    if (!m_view) {
+        m_angleDeg += deltaDeg;
+        setRotation(m_angleDeg);
+        return;
+    }
+
+    // Gira sobre el origen y compensa con un desplazamiento para que itemPoint no se mueva en pantalla
+    const QTransform viewport = m_view->viewportTransform();
+    const QPointF anchorBefore = deviceTransform(viewport).map(itemPoint);
+    m_angleDeg += deltaDeg;
+    setRotation(m_angleDeg);
+    const QPointF anchorAfter = deviceTransform(viewport).map(itemPoint);
+
+    bool invertible = false;
+    const QTransform invView = viewport.inverted(&invertible);
+    if (!invertible) {
+        return;
     }
-    path.addEllipse(QPointF(0.0, 0.0), kHingePickRadiusPx, kHingePickRadiusPx);
-    return path;
+    setPos(pos() + invView.map(anchorBefore) - invView.map(anchorAfter));
 }
 
 void CompassTool::paint(QPainter *, const QStyleOptionGraphicsItem *, QWidget *)
@@ -218,14 +325,31 @@ void CompassTool::applyLegTransforms()
 
 void CompassTool::updateGeometry()
 {
+    // Marca como sucia la union de los limites antiguos y nuevos; no hace falta repintar toda la escena
     prepareGeometryChange();
-    if (scene()) {
-        scene()->update();
-    }
+    m_localShapeValid = false;
+    invalidatePickShape();
 }
 
 void CompassTool::mousePressEvent(QGraphicsSceneMouseEvent *event)
 {
+    if (event && event->button() == Qt::LeftButton && (event->modifiers() & Qt::ShiftModifier)
+        && m_view && m_fixedLeg && m_movingLeg) {
+        // La pata fija hace de aguja (centro) y la movil de lapiz (radio = distancia entre puntas)
+        const QPointF needle = legTipScenePos(m_fixedLeg);
+        const QLineF radius(needle, legTipScenePos(m_movingLeg));
+        const QPointF toPointer = event->scenePos() - needle;
+
+        m_scribeArc.center = needle;
+        m_scribeArc.radius = radius.length();
+        m_scribeArc.startDeg = qRadiansToDegrees(std::atan2(-radius.dy(), radius.dx()));
+        m_scribeArc.spanDeg = 0.0;
+        m_scribeLastPointerDeg = qRadiansToDegrees(std::atan2(-toPointer.y(), toPointer.x()));
+        m_scribing = true;
+        event->accept();
+        return;
+    }
+
     QGraphicsObject::mousePressEvent(event);
 
     if (event && event->button() == Qt::LeftButton && event->isAccepted() && !m_dragCursorActive) {
@@ -234,8 +358,41 @@ void CompassTool::mousePressEvent(QGraphicsSceneMouseEvent *event)
     }
 }
 
+void CompassTool::mouseMoveEvent(QGraphicsSceneMouseEvent *event)
+{
+    if (!m_scribing || !event) {
+        QGraphicsObject::mouseMoveEvent(event);
+        return;
+    }
+
+    const QPointF toPointer = event->scenePos() - m_scribeArc.center;
+    const double pointerDeg = qRadiansToDegrees(std::atan2(-toPointer.y(), toPointer.x()));
+    // Delta en (-180, 180] para poder dar mas de media vuelta sin saltos
+    const double delta = std::fmod(pointerDeg - m_scribeLastPointerDeg + 540.0, 360.0) - 180.0;
+    m_scribeLastPointerDeg = pointerDeg;
+    if (qFuzzyIsNull(delta)) {
+        event->accept();
+        return;
+    }
+
+    m_scribeArc.spanDeg += delta;
+    // Los angulos del arco crecen en sentido antihorario; setRotation gira en sentido horario
+    const QPointF needleItem = m_fixedLeg->mapToParent(QPointF(m_fixedLeg->boundingRect().right(),
+                                                               kLegHingeLocal.y()));
+    rotateAroundItemPoint(needleItem, -delta);
+    emit arcScribing(m_scribeArc);
+    event->accept();
+}
+
 void CompassTool::mouseReleaseEvent(QGraphicsSceneMouseEvent *event)
 {
+    if (m_scribing && event && event->button() == Qt::LeftButton) {
+        m_scribing = false;
+        emit arcScribed(m_scribeArc);
+        event->accept();
+        return;
+    }
+
     QGraphicsObject::mouseReleaseEvent(event);
 
     if (event && event->button() == Qt::LeftButton && m_dragCursorActive) {
@@ -281,9 +438,6 @@ void CompassTool::wheelEvent(QGraphicsSceneWheelEvent *event)
         double deltaDegrees = (delta / 8.0) * 0.1;
         m_angleDeg += deltaDegrees;
         setRotation(m_angleDeg);
-        if (scene()) {
-            scene()->update();
-        }
         event->accept();
         return;
     }
@@ -300,25 +454,7 @@ void CompassTool::wheelEvent(QGraphicsSceneWheelEvent *event)
     const QPointF anchorItemPos = invDeviceBefore.map(anchorViewportPos);
 
     double deltaDegrees = (delta / 8.0) * 0.1;
-    m_angleDeg += deltaDegrees;
-    setRotation(m_angleDeg);
-
-    const QTransform deviceAfter = deviceTransform(m_view->viewportTransform());
-    const QPointF anchorViewportPosFromItem = deviceAfter.map(anchorItemPos);
-    const QPointF deltaViewport = anchorViewportPos - anchorViewportPosFromItem;
-
-    bool invertible = false;
-    const QTransform invView = m_view->viewportTransform().inverted(&invertible);
-    if (!invertible) {
-        event->ignore();
-        return;
-    }
-    const QPointF deltaScene = invView.map(deltaViewport) - invView.map(QPointF(0.0, 0.0));
-    setPos(pos() + deltaScene);
-
-    if (scene()) {
-        scene()->update();
-    }
+    rotateAroundItemPoint(anchorItemPos, deltaDegrees);
 
     event->accept();
 }
@@ -343,6 +479,26 @@ void CompassTool::hoverLeaveEvent(QGraphicsSceneHoverEvent *event)
     QGraphicsObject::hoverLeaveEvent(event);
 }
 
+QVariant CompassTool::itemChange(GraphicsItemChange change, const QVariant &value)
+{
+    switch (change) {
+    case ItemPositionHasChanged:
+    case ItemRotationHasChanged:
+    case ItemScaleHasChanged:
+        invalidatePickShape();
+        if (m_fixedLeg) {
+            static_cast<CompassLegItem*>(m_fixedLeg)->touchRenderCache();
+        }
+        if (m_movingLeg) {
+            static_cast<CompassLegItem*>(m_movingLeg)->touchRenderCache();
+        }
+        break;
+    default:
+        break;
+    }
+    return QGraphicsObject::itemChange(change, value);
+}
+
 bool CompassTool::sceneEventFilter(QGraphicsItem *watched, QEvent *event)
 {
     if ((watched == m_fixedLeg || watched == m_movingLeg) &&
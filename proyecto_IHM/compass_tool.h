@@ -8,6 +8,9 @@
 #include <QRectF>
 #include <QSizeF>
 #include <QString>
+#include <QTransform>
+
+#include "arcitem.h"
 
 class QGraphicsScene;
 class QGraphicsSvgItem;
@@ -31,6 +34,15 @@ public:
     void setView(QGraphicsView *view);
     bool adjustOpeningSteps(double steps);
 
+    // Giro del conjunto y apertura entre patas (grados), para guardar y restaurar la pizarra
+    double rotationDeg() const { return m_angleDeg; }
+    double openingDeg() const { return m_openingDeg; }
+    void setPose(double rotationDeg, double openingDeg);
+
+    // Impacto en coordenadas de escena con tolerancia (tambien de escena) alrededor del puntero.
+    // La forma en escena se cachea y solo se recalcula si cambia la geometria o el zoom de la vista.
+    bool hitTest(const QPointF &scenePos, double tolerance) const;
+
     static CompassTool* toggleTool(CompassTool *&tool,
                                    QGraphicsScene *scene,
                                    QGraphicsView *view,
@@ -45,18 +57,29 @@ public:
                const QStyleOptionGraphicsItem *option,
                QWidget *widget = nullptr) override;
 
+signals:
+    // Mayus+arrastre gira el compas sobre la punta fija (aguja) y la otra punta traza un arco
+    void arcScribing(const ArcPrimitive &arc);
+    void arcScribed(const ArcPrimitive &arc);
+
 protected:
     void mousePressEvent(QGraphicsSceneMouseEvent *event) override;
+    void mouseMoveEvent(QGraphicsSceneMouseEvent *event) override;
     void mouseReleaseEvent(QGraphicsSceneMouseEvent *event) override;
     void wheelEvent(QGraphicsSceneWheelEvent *event) override;
     void hoverMoveEvent(QGraphicsSceneHoverEvent *event) override;
     void hoverLeaveEvent(QGraphicsSceneHoverEvent *event) override;
     bool sceneEventFilter(QGraphicsItem *watched, QEvent *event) override;
+    QVariant itemChange(GraphicsItemChange change, const QVariant &value) override;
 
 private:
     void applyInitialScale();
     void applyLegTransforms();
     void updateGeometry();
+    void invalidatePickShape();
+    QTransform itemToSceneTransform() const;
+    QPointF legTipScenePos(const QGraphicsItem *leg) const;
+    void rotateAroundItemPoint(const QPointF &itemPoint, double deltaDeg);
 
     QSizeF m_targetSizePx;
     double m_uniformScale = 1.0;
@@ -67,9 +90,20 @@ private:
 
     bool m_dragCursorActive = false;
 
+    bool m_scribing = false;
+    ArcPrimitive m_scribeArc;
+    double m_scribeLastPointerDeg = 0.0;
+
     QGraphicsSvgItem *m_fixedLeg = nullptr;
     QGraphicsSvgItem *m_movingLeg = nullptr;
     QPointer<QGraphicsView> m_view;
+
+    mutable QPainterPath m_localShape;
+    mutable bool m_localShapeValid = false;
+    mutable QPainterPath m_scenePickShape;
+    mutable QRectF m_scenePickBounds;
+    mutable QTransform m_scenePickViewTransform;
+    mutable bool m_scenePickValid = false;
 };
 
 #endif // COMPASS_TOOL_H
@@ -1,6 +1,11 @@
 ﻿#include "dibujos.h"
+#include "arcitem.h"
+#include "boardfile.h"
+#include "chartcatalogue.h"
+#include "georeference.h"
 #include <utility>
 #include <cmath>
+#include <algorithm>
 
 #include <QEvent>
 #include <QGraphicsItem>
@@ -9,13 +14,8 @@
 #include <QBrush>
 #include <QLineF>
 #include <QObject>
-#include <QPainterPath>
-#include <QPainterPathStroker>
 #include <QtMath>
 
-double tamanyo_punto = 15.0;
-
-
 DMS Dibujos::decimalToDMS(double value, bool isLatitude)
 {
     DMS dms;
@@ -53,7 +53,11 @@ QString Dibujos::formatDMS(double value, bool isLatitude)
 Dibujos::Dibujos(QGraphicsScene *scene, QGraphicsView *view)
     : m_scene(scene)
     , m_view(view)
+    , m_geo(ChartCatalogue::instance().defaultGeoReference())
+    , m_crossings(m_geo)
 {
+    m_previewTimer.setSingleShot(true);
+    QObject::connect(&m_previewTimer, &QTimer::timeout, [this]() { flushPreview(); });
     refreshInteractionMode();
 }
 
@@ -165,7 +169,7 @@ bool Dibujos::handleEvent(QObject *obj, QEvent *event)
                     m_arcCenter = m_view->mapToScene(e->pos());
 
                     QPen pen(m_lineColor, 8, Qt::SolidLine, Qt::RoundCap, Qt::RoundJoin);
-                    m_currentArcItem = new QGraphicsPathItem();
+                    m_currentArcItem = new ArcItem();
                     m_currentArcItem->setZValue(11);
                     m_currentArcItem->setPen(pen);
                     m_scene->addItem(m_currentArcItem);
@@ -197,15 +201,8 @@ bool Dibujos::handleEvent(QObject *obj, QEvent *event)
         } else if (event->type() == QEvent::MouseMove) {
             auto *e = static_cast<QMouseEvent*>(event);
             if ((e->buttons() & Qt::RightButton) && m_currentArcItem) {
-                const QPointF scenePos = m_view->mapToScene(e->pos());
-                if (m_arcDraggingRadius) {
-                    QLineF line(m_arcCenter, scenePos);
-                    const double r = line.length();
-                    if (m_radiusGuide) {
-                        m_radiusGuide->setLine(line);
-                    }
-                } else if (m_arcSweeping && m_arcStartLocked) {
-                    updateArcPreview(scenePos);
+                if (m_arcDraggingRadius || (m_arcSweeping && m_arcStartLocked)) {
+                    schedulePreview(m_view->mapToScene(e->pos()));
                 }
                 return true;
             }
@@ -213,6 +210,7 @@ bool Dibujos::handleEvent(QObject *obj, QEvent *event)
             auto *e = static_cast<QMouseEvent*>(event);
             if (e->button() == Qt::RightButton && m_currentArcItem) {
                 if (m_arcDraggingRadius) {
+                    cancelPreview();
                     // Soltar define radio y punto inicial
                     QLineF line(m_arcCenter, m_view->mapToScene(e->pos()));
                     const double r = line.length();
@@ -234,11 +232,17 @@ bool Dibujos::handleEvent(QObject *obj, QEvent *event)
                 }
 
                 if (m_arcSweeping && m_arcStartLocked) {
+                    flushPreview();
                     const bool valid = std::fabs(m_arcSpanDeg) > 1.0;
                     if (!valid) {
                         clearCurrentArc();
                     } else {
                         m_arcItems.append(m_currentArcItem);
+                        registerArc(m_currentArcItem, m_currentArcItem->arc(), 0);
+                        BoardOp op;
+                        op.type = BoardOp::Type::AddArc;
+                        op.arc = arcRecord(m_currentArcItem);
+                        notifyChange(op);
                         m_currentArcItem = nullptr;
                         if (m_radiusGuide) {
                             m_scene->removeItem(m_radiusGuide);
@@ -260,7 +264,7 @@ bool Dibujos::handleEvent(QObject *obj, QEvent *event)
         if (event->type() == QEvent::MouseButtonPress) {
             auto *e = static_cast<QMouseEvent*>(event);
             if (e->button() == Qt::RightButton) {
-                m_lineStart = m_view->mapToScene(e->pos());
+                m_lineStart = snapped(m_view->mapToScene(e->pos()));
 
                 QPen pen(m_lineColor, 8);
                 m_currentLineItem = new QGraphicsLineItem();
@@ -274,19 +278,27 @@ bool Dibujos::handleEvent(QObject *obj, QEvent *event)
         } else if (event->type() == QEvent::MouseMove) {
             auto *e = static_cast<QMouseEvent*>(event);
             if ((e->buttons() & Qt::RightButton) && m_currentLineItem) {
-                QPointF p2 = m_view->mapToScene(e->pos());
-                m_currentLineItem->setLine(QLineF(m_lineStart, p2));
+                schedulePreview(m_view->mapToScene(e->pos()));
                 return true;
             }
         } else if (event->type() == QEvent::MouseButtonRelease) {
             auto *e = static_cast<QMouseEvent*>(event);
             if (e->button() == Qt::RightButton && m_currentLineItem) {
+                // La posicion de la suelta manda sobre cualquier movimiento pendiente
+                cancelPreview();
+                m_currentLineItem->setLine(QLineF(m_lineStart, snapped(m_view->mapToScene(e->pos()))));
                 QLineF line = m_currentLineItem->line();
                 if (line.length() < 2.0) {
                     m_scene->removeItem(m_currentLineItem);
                     delete m_currentLineItem;
                 } else {
                     m_lineItems.append(m_currentLineItem);
+                    m_lineItemSet.insert(m_currentLineItem);
+                    registerSegment(m_currentLineItem, line, 0);
+                    BoardOp op;
+                    op.type = BoardOp::Type::AddLine;
+                    op.line = lineRecord(m_currentLineItem);
+                    notifyChange(op);
                 }
                 m_currentLineItem = nullptr;
                 return true;
@@ -296,7 +308,10 @@ bool Dibujos::handleEvent(QObject *obj, QEvent *event)
         if (event->type() == QEvent::MouseButtonPress) {
             auto *e = static_cast<QMouseEvent*>(event);
             if (e->button() == Qt::RightButton) {
-                addPointAt(m_view->mapToScene(e->pos()));
+                BoardOp op;
+                op.type = BoardOp::Type::AddPoint;
+                op.point = pointRecord(addPointAt(snapped(m_view->mapToScene(e->pos())), m_pointColor));
+                notifyChange(op);
                 return true;
             }
         }
@@ -312,14 +327,16 @@ void Dibujos::reset()
     m_drawArcMode = false;
     clearCurrentLine();
     clearCurrentArc();
+    clearScribePreview();
 
     for (QGraphicsLineItem *line : m_lineItems) {
         m_scene->removeItem(line);
         delete line;
     }
     m_lineItems.clear();
+    m_lineItemSet.clear();
 
-    for (QGraphicsPathItem *arc : m_arcItems) {
+    for (ArcItem *arc : m_arcItems) {
         m_scene->removeItem(arc);
         delete arc;
     }
@@ -331,6 +348,10 @@ void Dibujos::reset()
     }
     m_pointItems.clear();
     m_pointCoordinates.clear();
+    m_snap.clear();
+    m_crossings.clear();
+    m_featureIds.clear();
+    m_itemsById.clear();
 
     refreshInteractionMode();
 }
@@ -346,6 +367,7 @@ void Dibujos::refreshInteractionMode()
 
 void Dibujos::clearCurrentLine()
 {
+    cancelPreview();
     if (m_currentLineItem) {
         m_scene->removeItem(m_currentLineItem);
         delete m_currentLineItem;
@@ -355,6 +377,7 @@ void Dibujos::clearCurrentLine()
 
 void Dibujos::clearCurrentArc()
 {
+    cancelPreview();
     if (m_currentArcItem) {
         m_scene->removeItem(m_currentArcItem);
         delete m_currentArcItem;
@@ -376,32 +399,15 @@ void Dibujos::clearCurrentArc()
 
 std::pair<double,double> Dibujos::screenToGeo(double pos_x, double pos_y)
 {
-    //Coordenadas de la imagen del mapa en pantalla
-    const double x_min = 321.0;
-    const double x_max = 8369.0;
-    const double y_min = 437.0;
-    const double y_max = 5332.8;
-
-    //Coordenadas geogrÃ¡ficas reales del mapa
-
-    const double lat_top    = 36.20;
-    const double lat_bottom = 35.60;
-    const double lon_left   = -6.40;
-    const double lon_right  = -4.90;
-
-    // Tamaaño total
-    double map_width  = x_max - x_min;
-    double map_height = y_max - y_min;
-
-    // Normalizacion a coordenadas [0,1]
-    double u = (pos_x - x_min) / map_width;
-    double v = (pos_y - y_min) / map_height;
-
-    // Interpolacion geografica
-    double lon = lon_left + u * (lon_right - lon_left);
-    double lat = lat_top - v * (lat_top - lat_bottom);
+    const GeoPoint geo = m_geo.toGeo(QPointF(pos_x, pos_y));
+    return {geo.lat, geo.lon};
+}
 
-    return {lat, lon};
+void Dibujos::setGeoReference(const GeoReference &geo)
+{
+    // Se asigna sobre el mismo objeto: m_crossings sigue apuntando a el
+    m_geo = geo;
+    m_crossings.refreshGeo();
 }
 
 void Dibujos::updateArcPreview(const QPointF &scenePos)
@@ -422,15 +428,7 @@ void Dibujos::updateArcPreview(const QPointF &scenePos)
     m_arcSpanDeg += delta;
     m_arcLastDeg = currentDeg;
 
-    QRectF box(m_arcCenter.x() - m_arcRadius,
-               m_arcCenter.y() - m_arcRadius,
-               m_arcRadius * 2.0,
-               m_arcRadius * 2.0);
-
-    QPainterPath path;
-    path.arcMoveTo(box, m_arcStartDeg);
-    path.arcTo(box, m_arcStartDeg, m_arcSpanDeg);
-    m_currentArcItem->setPath(path);
+    m_currentArcItem->setArc(m_arcCenter, m_arcRadius, m_arcStartDeg, m_arcSpanDeg);
 
     if (m_radiusGuide) {
         const double endDeg = m_arcStartDeg + m_arcSpanDeg;
@@ -441,21 +439,226 @@ void Dibujos::updateArcPreview(const QPointF &scenePos)
     }
 }
 
-void Dibujos::addPointAt(const QPointF &scenePos)
+void Dibujos::setScribePreview(const ArcPrimitive &arc)
+{
+    if (!m_scribePreviewItem) {
+        m_scribePreviewItem = new ArcItem();
+        m_scribePreviewItem->setZValue(11);
+        m_scribePreviewItem->setPen(QPen(m_lineColor, 8, Qt::SolidLine, Qt::RoundCap, Qt::RoundJoin));
+        m_scene->addItem(m_scribePreviewItem);
+    }
+    m_scribePreviewItem->setArc(arc);
+}
+
+void Dibujos::clearScribePreview()
+{
+    if (m_scribePreviewItem) {
+        m_scene->removeItem(m_scribePreviewItem);
+        delete m_scribePreviewItem;
+        m_scribePreviewItem = nullptr;
+    }
+}
+
+void Dibujos::addArc(const ArcPrimitive &arc)
+{
+    if (arc.radius <= 0.0 || std::fabs(arc.spanDeg) <= 1.0) {
+        return;
+    }
+    BoardOp op;
+    op.type = BoardOp::Type::AddArc;
+    op.arc = arcRecord(addArcItem(arc, m_lineColor, 8.0));
+    notifyChange(op);
+}
+
+ArcItem *Dibujos::addArcItem(const ArcPrimitive &arc, const QColor &color, double width, quint32 id)
+{
+    auto *item = new ArcItem();
+    item->setZValue(11);
+    item->setPen(QPen(color, width, Qt::SolidLine, Qt::RoundCap, Qt::RoundJoin));
+    item->setArc(arc);
+    m_scene->addItem(item);
+    m_arcItems.append(item);
+    registerArc(item, arc, id);
+    return item;
+}
+
+QGraphicsLineItem *Dibujos::addLineItem(const QLineF &line, const QColor &color, double width, quint32 id)
+{
+    auto *item = new QGraphicsLineItem(line);
+    item->setZValue(10);
+    item->setPen(QPen(color, width));
+    m_scene->addItem(item);
+    m_lineItems.append(item);
+    m_lineItemSet.insert(item);
+    registerSegment(item, line, id);
+    return item;
+}
+
+BoardPoint Dibujos::pointRecord(const QGraphicsEllipseItem *item) const
+{
+    const int idx = m_pointItems.indexOf(const_cast<QGraphicsEllipseItem*>(item));
+    return {m_featureIds.value(item).boardId,
+            idx >= 0 ? m_pointCoordinates.at(idx) : item->rect().center(),
+            item->brush().color().rgba()};
+}
+
+BoardLine Dibujos::lineRecord(const QGraphicsLineItem *item) const
+{
+    const QPen pen = item->pen();
+    return {m_featureIds.value(item).boardId, item->line(), pen.color().rgba(), static_cast<float>(pen.widthF())};
+}
+
+BoardArc Dibujos::arcRecord(const ArcItem *item) const
+{
+    const QPen pen = item->pen();
+    return {m_featureIds.value(item).boardId, item->arc(), pen.color().rgba(), static_cast<float>(pen.widthF())};
+}
+
+void Dibujos::notifyChange(const BoardOp &op) const
+{
+    if (m_changeListener) {
+        m_changeListener(op);
+    }
+}
+
+void Dibujos::exportBoard(BoardData *board) const
+{
+    board->points.clear();
+    board->points.reserve(m_pointItems.size());
+    for (int i = 0; i < m_pointItems.size(); ++i) {
+        const QGraphicsEllipseItem *item = m_pointItems.at(i);
+        board->points.append({m_featureIds.value(item).boardId, m_pointCoordinates.at(i), item->brush().color().rgba()});
+    }
+
+    board->lines.clear();
+    board->lines.reserve(m_lineItems.size());
+    for (const QGraphicsLineItem *item : m_lineItems) {
+        board->lines.append(lineRecord(item));
+    }
+
+    board->arcs.clear();
+    board->arcs.reserve(m_arcItems.size());
+    for (const ArcItem *item : m_arcItems) {
+        board->arcs.append(arcRecord(item));
+    }
+}
+
+void Dibujos::importBoard(const BoardData &board)
 {
-    static const qreal kRadius = tamanyo_punto;
-    QPen pen(m_pointColor, 2.0);
-    QBrush brush(m_pointColor);
+    reset();
+
+    m_pointItems.reserve(board.points.size());
+    m_pointCoordinates.reserve(board.points.size());
+    m_lineItems.reserve(board.lines.size());
+    m_lineItemSet.reserve(board.lines.size());
+    m_arcItems.reserve(board.arcs.size());
+    m_featureIds.reserve(board.points.size() + board.lines.size() + board.arcs.size());
+    m_itemsById.reserve(board.points.size() + board.lines.size() + board.arcs.size());
+
+    for (const BoardLine &line : board.lines) {
+        addLineItem(line.line, QColor::fromRgba(line.color), line.width, line.id);
+    }
+    for (const BoardArc &arc : board.arcs) {
+        addArcItem(arc.arc, QColor::fromRgba(arc.color), arc.width, arc.id);
+    }
+    for (const BoardPoint &point : board.points) {
+        addPointAt(point.pos, QColor::fromRgba(point.color), point.id);
+    }
+}
+
+bool Dibujos::nearestLine(const QPointF &scenePos, double radius, QLineF *line) const
+{
+    if (!m_scene || radius <= 0.0) {
+        return false;
+    }
+
+    const QRectF area(scenePos.x() - radius, scenePos.y() - radius, radius * 2.0, radius * 2.0);
+    const QList<QGraphicsItem*> candidates = m_scene->items(area, Qt::IntersectsItemBoundingRect);
+
+    double bestDist = radius;
+    bool found = false;
+    for (QGraphicsItem *item : candidates) {
+        if (!m_lineItemSet.contains(item)) {
+            continue;
+        }
+        const auto *lineItem = static_cast<const QGraphicsLineItem*>(item);
+        const QLineF sceneLine(lineItem->mapToScene(lineItem->line().p1()),
+                               lineItem->mapToScene(lineItem->line().p2()));
+
+        // Distancia del punto al segmento
+        const QPointF d = sceneLine.p2() - sceneLine.p1();
+        const double len2 = QPointF::dotProduct(d, d);
+        double t = len2 > 0.0 ? QPointF::dotProduct(scenePos - sceneLine.p1(), d) / len2 : 0.0;
+        t = std::clamp(t, 0.0, 1.0);
+        const QPointF closest = sceneLine.p1() + d * t;
+        const double dist = QLineF(scenePos, closest).length();
+        if (dist <= bestDist) {
+            bestDist = dist;
+            found = true;
+            if (line) {
+                *line = sceneLine;
+            }
+        }
+    }
+    return found;
+}
+
+void Dibujos::schedulePreview(const QPointF &scenePos)
+{
+    m_pendingPreviewPos = scenePos;
+    if (m_previewPending) {
+        return;
+    }
+    m_previewPending = true;
+
+    // El primer movimiento tras un fotograma se aplica en la siguiente vuelta del bucle de eventos
+    const qint64 sinceLast = m_previewClock.isValid() ? m_previewClock.elapsed() : kPreviewFrameMs;
+    m_previewTimer.start(static_cast<int>(std::max<qint64>(0, kPreviewFrameMs - sinceLast)));
+}
+
+void Dibujos::flushPreview()
+{
+    m_previewTimer.stop();
+    if (!m_previewPending) {
+        return;
+    }
+    m_previewPending = false;
+    m_previewClock.start();
+
+    const QPointF scenePos = m_pendingPreviewPos;
+    if (m_drawLineMode && m_currentLineItem) {
+        m_currentLineItem->setLine(QLineF(m_lineStart, snapped(scenePos)));
+    } else if (m_drawArcMode && m_currentArcItem) {
+        if (m_arcDraggingRadius) {
+            if (m_radiusGuide) {
+                m_radiusGuide->setLine(QLineF(m_arcCenter, scenePos));
+            }
+        } else if (m_arcSweeping && m_arcStartLocked) {
+            updateArcPreview(scenePos);
+        }
+    }
+}
+
+void Dibujos::cancelPreview()
+{
+    m_previewTimer.stop();
+    m_previewPending = false;
+}
+
+QGraphicsEllipseItem *Dibujos::addPointAt(const QPointF &scenePos, const QColor &color, quint32 id)
+{
+    QPen pen(color, 2.0);
+    QBrush brush(color);
 
     auto [lat, lon] = screenToGeo(scenePos.x(), scenePos.y());
 
     QString latStr = formatDMS(lat,  true);  // true  = es latitud
     QString lonStr = formatDMS(lon, false);  // false = es longitud
 
-    auto *pointItem = m_scene->addEllipse(scenePos.x() - kRadius,
-                                          scenePos.y() - kRadius,
-                                          kRadius * 2.0,
-                                          kRadius * 2.0,
+    auto *pointItem = m_scene->addEllipse(scenePos.x() - kPointRadius,
+                                          scenePos.y() - kPointRadius,
+                                          kPointRadius * 2.0,
+                                          kPointRadius * 2.0,
                                           pen,
                                           brush);
     pointItem->setZValue(12);
@@ -467,6 +670,72 @@ void Dibujos::addPointAt(const QPointF &scenePos)
 
     m_pointItems.append(pointItem);
     m_pointCoordinates.append(scenePos);
+    registerPoint(pointItem, scenePos, id);
+    return pointItem;
+}
+
+QPointF Dibujos::snapped(const QPointF &scenePos) const
+{
+    const double scale = m_view ? m_view->transform().m11() : 1.0;
+    QPointF target;
+    if (scale > 0.0 && m_snap.nearest(scenePos, kSnapPx / scale, &target)) {
+        return target;
+    }
+    return scenePos;
+}
+
+bool Dibujos::crossingNear(const QPointF &scenePos, IntersectionEngine::Intersection *hit)
+{
+    const double scale = m_view ? m_view->transform().m11() : 1.0;
+    if (scale <= 0.0) {
+        return false;
+    }
+    const IntersectionEngine::Intersection *best = m_crossings.nearest(scenePos, kSnapPx / scale);
+    if (!best) {
+        return false;
+    }
+    if (hit) {
+        *hit = *best;
+    }
+    return true;
+}
+
+quint32 Dibujos::registerFeature(QGraphicsItem *item, FeatureIds ids)
+{
+    if (ids.boardId == 0) {
+        ids.boardId = m_nextItemId++;
+    } else {
+        m_nextItemId = std::max(m_nextItemId, ids.boardId + 1);
+    }
+    m_featureIds.insert(item, ids);
+    m_itemsById.insert(ids.boardId, item);
+    return ids.boardId;
+}
+
+quint32 Dibujos::registerPoint(QGraphicsItem *item, const QPointF &pos, quint32 id)
+{
+    return registerFeature(item, {id, m_snap.addPoint(pos), IntersectionEngine::kInvalidId});
+}
+
+quint32 Dibujos::registerSegment(QGraphicsItem *item, const QLineF &line, quint32 id)
+{
+    return registerFeature(item, {id, m_snap.addSegment(line), m_crossings.addSegment(line)});
+}
+
+quint32 Dibujos::registerArc(QGraphicsItem *item, const ArcPrimitive &arc, quint32 id)
+{
+    return registerFeature(item, {id, m_snap.addArc(arc), m_crossings.addArc(arc)});
+}
+
+void Dibujos::unregisterFeature(const QGraphicsItem *item)
+{
+    const auto it = m_featureIds.constFind(item);
+    if (it != m_featureIds.constEnd()) {
+        m_snap.remove(it->snap);
+        m_crossings.remove(it->crossing);
+        m_itemsById.remove(it->boardId);
+        m_featureIds.erase(it);
+    }
 }
 
 
@@ -482,10 +751,11 @@ bool Dibujos::erasePointItem(QGraphicsItem *item)
         return false;
     }
 
-    m_scene->removeItem(point);
-    delete point;
-    m_pointItems.removeAt(idx);
-    m_pointCoordinates.removeAt(idx);
+    BoardOp op;
+    op.type = BoardOp::Type::ErasePoint;
+    op.point = pointRecord(point);
+    removePointAt(idx);
+    notifyChange(op);
     return true;
 }
 
@@ -501,15 +771,17 @@ bool Dibujos::eraseLineItem(QGraphicsItem *item)
         return false;
     }
 
-    m_scene->removeItem(line);
-    delete line;
-    m_lineItems.removeAt(idx);
+    BoardOp op;
+    op.type = BoardOp::Type::EraseLine;
+    op.line = lineRecord(line);
+    removeLineAt(idx);
+    notifyChange(op);
     return true;
 }
 
 bool Dibujos::eraseArcItem(QGraphicsItem *item, const QPointF &scenePos)
 {
-    auto *arc = qgraphicsitem_cast<QGraphicsPathItem*>(item);
+    auto *arc = qgraphicsitem_cast<ArcItem*>(item);
     if (!arc) {
         return false;
     }
@@ -520,16 +792,96 @@ bool Dibujos::eraseArcItem(QGraphicsItem *item, const QPointF &scenePos)
     }
 
     // Reducir el area de borrado para evitar borrar "a distancia": comprobamos distancia a la trayectoria
-    const QPointF localPos = arc->mapFromScene(scenePos);
-    QPainterPathStroker stroker;
-    stroker.setWidth(10.0); // tolerancia de borrado mas ajustada que la caja completa del arco
-    QPainterPath hitArea = stroker.createStroke(arc->path());
-    if (!hitArea.contains(localPos)) {
+    if (!arc->hitTest(scenePos, 5.0)) {
         return false;
     }
 
+    BoardOp op;
+    op.type = BoardOp::Type::EraseArc;
+    op.arc = arcRecord(arc);
+    removeArcAt(idx);
+    notifyChange(op);
+    return true;
+}
+
+void Dibujos::removePointAt(int idx)
+{
+    QGraphicsEllipseItem *point = m_pointItems.takeAt(idx);
+    m_pointCoordinates.removeAt(idx);
+    unregisterFeature(point);
+    m_scene->removeItem(point);
+    delete point;
+}
+
+void Dibujos::removeLineAt(int idx)
+{
+    QGraphicsLineItem *line = m_lineItems.takeAt(idx);
+    m_lineItemSet.remove(line);
+    unregisterFeature(line);
+    m_scene->removeItem(line);
+    delete line;
+}
+
+void Dibujos::removeArcAt(int idx)
+{
+    ArcItem *arc = m_arcItems.takeAt(idx);
+    unregisterFeature(arc);
     m_scene->removeItem(arc);
     delete arc;
-    m_arcItems.removeAt(idx);
-    return true;
+}
+
+bool Dibujos::applyOp(const BoardOp &op)
+{
+    switch (op.type) {
+    case BoardOp::Type::AddPoint:
+        if (m_itemsById.contains(op.point.id)) {
+            return false;
+        }
+        addPointAt(op.point.pos, QColor::fromRgba(op.point.color), op.point.id);
+        return true;
+    case BoardOp::Type::AddLine:
+        if (m_itemsById.contains(op.line.id)) {
+            return false;
+        }
+        addLineItem(op.line.line, QColor::fromRgba(op.line.color), op.line.width, op.line.id);
+        return true;
+    case BoardOp::Type::AddArc:
+        if (m_itemsById.contains(op.arc.id)) {
+            return false;
+        }
+        addArcItem(op.arc.arc, QColor::fromRgba(op.arc.color), op.arc.width, op.arc.id);
+        return true;
+    case BoardOp::Type::ErasePoint: {
+        const int idx = m_pointItems.indexOf(qgraphicsitem_cast<QGraphicsEllipseItem*>(m_itemsById.value(op.id())));
+        if (idx == -1) {
+            return false;
+        }
+        removePointAt(idx);
+        return true;
+    }
+    case BoardOp::Type::EraseLine: {
+        const int idx = m_lineItems.indexOf(qgraphicsitem_cast<QGraphicsLineItem*>(m_itemsById.value(op.id())));
+        if (idx == -1) {
+            return false;
+        }
+        removeLineAt(idx);
+        return true;
+    }
+    case BoardOp::Type::EraseArc: {
+        const int idx = m_arcItems.indexOf(qgraphicsitem_cast<ArcItem*>(m_itemsById.value(op.id())));
+        if (idx == -1) {
+            return false;
+        }
+        removeArcAt(idx);
+        return true;
+    }
+    case BoardOp::Type::Clear:
+        reset();
+        return true;
+    case BoardOp::Type::AddText:
+    case BoardOp::Type::UpdateText:
+    case BoardOp::Type::EraseText:
+        break; // los textos son de MainWindow
+    }
+    return false;
 }
@@ -5,14 +5,23 @@
 #include <QGraphicsView>
 #include <QGraphicsLineItem>
 #include <QGraphicsEllipseItem>
-#include <QGraphicsPathItem>
 #include <QColor>
+#include <QElapsedTimer>
 #include <QPointF>
+#include <QTimer>
+#include <functional>
 #include <utility>
 
 #include <QChar>
 #include <QString>
+#include <QLineF>
+#include <QSet>
 #include <QVector>
+#include <QHash>
+
+#include "boardfile.h"
+#include "intersectionengine.h"
+#include "snapengine.h"
 
 class QObject;
 class QEvent;
@@ -27,6 +36,9 @@ struct DMS {
 class Dibujos
 {
 public:
+    // Radio de los puntos en unidades de escena (tambien lo usan las exportaciones)
+    static constexpr double kPointRadius = 15.0;
+
     Dibujos(QGraphicsScene *scene, QGraphicsView *view);
     DMS decimalToDMS(double value, bool isLatitude);
     QString formatDMS(double value, bool isLatitude);
@@ -38,6 +50,9 @@ public:
     bool drawArcMode() const { return m_drawArcMode; }
     void setLineColor(const QColor &color);
     std::pair<double,double> screenToGeo(double pos_x, double pos_y);
+    // Georreferencia de la carta de esta pizarra; la usan los cortes y las herramientas
+    const GeoReference &geoReference() const { return m_geo; }
+    void setGeoReference(const GeoReference &geo);
     void setPointColor(const QColor &color);
     QColor lineColor() const { return m_lineColor; }
     QColor pointColor() const { return m_pointColor; }
@@ -50,12 +65,66 @@ public:
     bool eraseLineItem(QGraphicsItem *item);
     bool eraseArcItem(QGraphicsItem *item, const QPointF &scenePos);
 
+    // Arcos trazados con el compas: previsualizacion mientras se arrastra y arco definitivo al soltar
+    void setScribePreview(const ArcPrimitive &arc);
+    void clearScribePreview();
+    void addArc(const ArcPrimitive &arc);
+
+    // Linea dibujada mas cercana a scenePos (distancia al segmento <= radius), usando el indice
+    // espacial de la escena. Devuelve false si no hay ninguna.
+    bool nearestLine(const QPointF &scenePos, double radius, QLineF *line) const;
+
+    // Cortes entre todas las lineas y arcos de la pizarra, con latitud y longitud
+    const QVector<IntersectionEngine::Intersection> &intersections() { return m_crossings.intersections(); }
+    // Corte mas cercano a scenePos dentro del radio de enganche (en pixeles de pantalla)
+    bool crossingNear(const QPointF &scenePos, IntersectionEngine::Intersection *hit);
+
+    // Puntos, lineas y arcos de la pizarra con su color y grosor. importBoard sustituye lo dibujado.
+    void exportBoard(BoardData *board) const;
+    void importBoard(const BoardData &board);
+
+    // Se llama con cada alta o borrado hecho por el usuario (no en importBoard ni en reset)
+    using ChangeListener = std::function<void(const BoardOp &op)>;
+    void setChangeListener(ChangeListener listener) { m_changeListener = std::move(listener); }
+    // Aplica un cambio registrado (deshacer/rehacer) sin avisar al listener. Las altas conservan
+    // su id; devuelve false si el elemento ya existe o no se encuentra.
+    bool applyOp(const BoardOp &op);
+
 private:
     void refreshInteractionMode();
     void clearCurrentLine();
-    void addPointAt(const QPointF &scenePos);
+    // id = 0 asigna el siguiente libre
+    QGraphicsEllipseItem *addPointAt(const QPointF &scenePos, const QColor &color, quint32 id = 0);
+    QGraphicsLineItem *addLineItem(const QLineF &line, const QColor &color, double width, quint32 id = 0);
+    ArcItem *addArcItem(const ArcPrimitive &arc, const QColor &color, double width, quint32 id = 0);
+    BoardPoint pointRecord(const QGraphicsEllipseItem *item) const;
+    BoardLine lineRecord(const QGraphicsLineItem *item) const;
+    BoardArc arcRecord(const ArcItem *item) const;
+    void notifyChange(const BoardOp &op) const;
     void clearCurrentArc();
     void updateArcPreview(const QPointF &scenePos);
+    // Ajusta scenePos al punto de enganche mas cercano (puntos, extremos, intersecciones)
+    // dentro de una tolerancia fija en pixeles de pantalla
+    QPointF snapped(const QPointF &scenePos) const;
+    quint32 registerPoint(QGraphicsItem *item, const QPointF &pos, quint32 id);
+    quint32 registerSegment(QGraphicsItem *item, const QLineF &line, quint32 id);
+    quint32 registerArc(QGraphicsItem *item, const ArcPrimitive &arc, quint32 id);
+    void unregisterFeature(const QGraphicsItem *item);
+    void removePointAt(int idx);
+    void removeLineAt(int idx);
+    void removeArcAt(int idx);
+    static constexpr double kSnapPx = 12.0;
+
+    // Las previsualizaciones guardan la ultima posicion del puntero y recalculan la geometria
+    // como mucho una vez por fotograma, aunque el raton envie varios MouseMove entre pintados
+    void schedulePreview(const QPointF &scenePos);
+    void flushPreview();
+    void cancelPreview();
+    static constexpr int kPreviewFrameMs = 16;
+    QTimer m_previewTimer;
+    QElapsedTimer m_previewClock;
+    QPointF m_pendingPreviewPos;
+    bool m_previewPending = false;
 
     QGraphicsScene *m_scene = nullptr;
     QGraphicsView *m_view = nullptr;
@@ -65,7 +134,8 @@ private:
     bool m_drawArcMode = false;
 
     QGraphicsLineItem *m_currentLineItem = nullptr;
-    QGraphicsPathItem *m_currentArcItem = nullptr;
+    ArcItem *m_currentArcItem = nullptr;
+    ArcItem *m_scribePreviewItem = nullptr;
     QGraphicsLineItem *m_radiusGuide = nullptr;
     QColor m_lineColor = Qt::red;
     QColor m_pointColor = Qt::red;
@@ -80,8 +150,22 @@ private:
     bool m_arcSweeping = false;
     QVector<QGraphicsEllipseItem*> m_pointItems;
     QVector<QGraphicsLineItem*> m_lineItems;
-    QVector<QGraphicsPathItem*> m_arcItems;
+    QSet<const QGraphicsItem*> m_lineItemSet; // pertenencia O(1) para filtrar consultas de la escena
+    QVector<ArcItem*> m_arcItems;
     QVector<QPointF> m_pointCoordinates;
+    SnapEngine m_snap;
+    GeoReference m_geo;                 // antes que m_crossings, que guarda una referencia
+    IntersectionEngine m_crossings;
+    struct FeatureIds {
+        quint32 boardId = 0;
+        SnapEngine::PrimitiveId snap = SnapEngine::kInvalidId;
+        IntersectionEngine::Id crossing = IntersectionEngine::kInvalidId;
+    };
+    quint32 registerFeature(QGraphicsItem *item, FeatureIds ids);
+    QHash<const QGraphicsItem*, FeatureIds> m_featureIds;
+    QHash<quint32, QGraphicsItem*> m_itemsById;
+    quint32 m_nextItemId = 1;
+    ChangeListener m_changeListener;
 };
 
 #endif // DIBUJOS_H
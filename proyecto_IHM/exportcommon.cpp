@@ -0,0 +1,36 @@
+#include "exportcommon.h"
+
+#include <QImageReader>
+
+namespace ExportCommon {
+
+QRectF exportRegion(const QRectF &chartRect, const QRectF &region)
+{
+    return region.isEmpty() ? chartRect : region.intersected(chartRect);
+}
+
+QImage chartPiece(const QString &chartPath, const QRectF &chartRect, const QRectF &region, double scale,
+                  QRectF *pieceRect)
+{
+    const QRect source = region.toAlignedRect().intersected(chartRect.toAlignedRect());
+    if (source.isEmpty() || scale <= 0.0) {
+        return QImage();
+    }
+    QImageReader reader(chartPath);
+    if (scale < 1.0) {
+        const QSize full = (chartRect.size() * scale).toSize().expandedTo(QSize(1, 1));
+        const double sx = full.width() / chartRect.width();
+        const double sy = full.height() / chartRect.height();
+        const QRect clip = QRectF(source.x() * sx, source.y() * sy, source.width() * sx, source.height() * sy)
+                               .toAlignedRect().intersected(QRect(QPoint(), full));
+        reader.setScaledSize(full);
+        reader.setScaledClipRect(clip);
+        *pieceRect = QRectF(clip.x() / sx, clip.y() / sy, clip.width() / sx, clip.height() / sy);
+    } else {
+        reader.setClipRect(source);
+        *pieceRect = source;
+    }
+    return reader.read();
+}
+
+} // namespace ExportCommon
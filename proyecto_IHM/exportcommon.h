@@ -0,0 +1,33 @@
+#ifndef EXPORTCOMMON_H
+#define EXPORTCOMMON_H
+
+#include <QImage>
+#include <QRectF>
+#include <QString>
+
+// Piezas compartidas por ChartExporter y VectorExport; no forman parte de su interfaz publica
+namespace ExportCommon {
+
+// Margen del layout mas el relleno del cuadro de texto, en unidades de escena
+constexpr double kTextInset = 10.0;
+
+inline bool fail(QString *error, const QString &msg)
+{
+    if (error) {
+        *error = msg;
+    }
+    return false;
+}
+
+// Zona pedida recortada a la carta; vacia = toda la carta
+QRectF exportRegion(const QRectF &chartRect, const QRectF &region);
+
+// Trozo de la carta bajo region a scale pixeles por unidad de escena (como mucho 1: por encima se
+// lee a tamano completo). Con scale < 1 el decodificador reduce al leer, asi que el trozo a tamano
+// completo no llega a existir. pieceRect recibe la zona de la escena que cubre la imagen.
+QImage chartPiece(const QString &chartPath, const QRectF &chartRect, const QRectF &region, double scale,
+                  QRectF *pieceRect);
+
+} // namespace ExportCommon
+
+#endif // EXPORTCOMMON_H
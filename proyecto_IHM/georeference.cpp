@@ -0,0 +1,58 @@
+#include "georeference.h"
+
+#include <QtMath>
+
+#include <algorithm>
+#include <cmath>
+
+GeoReference::GeoReference(const QRectF &sceneRect, double latTop, double latBottom, double lonLeft, double lonRight)
+    : m_sceneRect(sceneRect)
+    , m_latTop(latTop)
+    , m_lonLeft(lonLeft)
+    , m_degLatPerPx((latTop - latBottom) / sceneRect.height())
+    , m_degLonPerPx((lonRight - lonLeft) / sceneRect.width())
+{
+    for (int i = 0; i <= kCosTableSize; ++i) {
+        const double lat = latTop - (latTop - latBottom) * i / kCosTableSize;
+        m_cosLat[i] = std::cos(qDegreesToRadians(lat));
+    }
+}
+
+GeoPoint GeoReference::toGeo(const QPointF &scenePos) const
+{
+    return {m_latTop - (scenePos.y() - m_sceneRect.top()) * m_degLatPerPx,
+            m_lonLeft + (scenePos.x() - m_sceneRect.left()) * m_degLonPerPx};
+}
+
+double GeoReference::cosLatAtSceneY(double y) const
+{
+    // Interpolacion lineal en la tabla; fuera de la carta se usa el extremo mas cercano
+    const double t = std::clamp((y - m_sceneRect.top()) / m_sceneRect.height(), 0.0, 1.0) * kCosTableSize;
+    const int i = std::min(static_cast<int>(t), kCosTableSize - 1);
+    const double f = t - i;
+    return m_cosLat[i] + (m_cosLat[i + 1] - m_cosLat[i]) * f;
+}
+
+void GeoReference::offsetsNm(const QPointF &a, const QPointF &b, double &dN, double &dE) const
+{
+    // 1 minuto de latitud = 1 milla; la longitud se reduce por cos(latitud media)
+    dN = -(b.y() - a.y()) * m_degLatPerPx * 60.0;
+    dE = (b.x() - a.x()) * m_degLonPerPx * 60.0 * cosLatAtSceneY((a.y() + b.y()) * 0.5);
+}
+
+double GeoReference::distanceNm(const QPointF &a, const QPointF &b) const
+{
+    double dN = 0.0;
+    double dE = 0.0;
+    offsetsNm(a, b, dN, dE);
+    return std::hypot(dN, dE);
+}
+
+double GeoReference::bearingDeg(const QPointF &a, const QPointF &b) const
+{
+    double dN = 0.0;
+    double dE = 0.0;
+    offsetsNm(a, b, dN, dE);
+    const double deg = qRadiansToDegrees(std::atan2(dE, dN));
+    return deg < 0.0 ? deg + 360.0 : deg;
+}
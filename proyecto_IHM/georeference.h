@@ -0,0 +1,45 @@
+#ifndef GEOREFERENCE_H
+#define GEOREFERENCE_H
+
+#include <QPointF>
+#include <QRectF>
+
+#include <array>
+
+struct GeoPoint {
+    double lat = 0.0;
+    double lon = 0.0;
+};
+
+// Georreferencia lineal de una carta: un rectangulo de la escena corresponde a un rango de latitud y
+// longitud. Las escalas grado/pixel y la tabla de cos(latitud) se calculan en el constructor, de modo
+// que convertir, medir distancias y rumbos son unas pocas operaciones sin reservar memoria. Los
+// valores salen de ChartInfo (catalogo de cartas); cada pizarra guarda la de su carta en Dibujos.
+class GeoReference
+{
+public:
+    GeoReference(const QRectF &sceneRect, double latTop, double latBottom, double lonLeft, double lonRight);
+
+    GeoPoint toGeo(const QPointF &scenePos) const;
+
+    // Distancia en millas nauticas y rumbo verdadero (0..360, desde el norte en sentido horario)
+    // entre dos puntos de la escena, aproximando la tierra como plana a la latitud media
+    double distanceNm(const QPointF &a, const QPointF &b) const;
+    double bearingDeg(const QPointF &a, const QPointF &b) const;
+
+private:
+    static constexpr int kCosTableSize = 256;
+
+    // Millas de desplazamiento norte (dN) y este (dE) entre dos puntos
+    void offsetsNm(const QPointF &a, const QPointF &b, double &dN, double &dE) const;
+    double cosLatAtSceneY(double y) const;
+
+    QRectF m_sceneRect;
+    double m_latTop = 0.0;
+    double m_lonLeft = 0.0;
+    double m_degLatPerPx = 0.0;
+    double m_degLonPerPx = 0.0;
+    std::array<double, kCosTableSize + 1> m_cosLat{};
+};
+
+#endif // GEOREFERENCE_H
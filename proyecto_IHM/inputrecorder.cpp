@@ -0,0 +1,303 @@
+#include "inputrecorder.h"
+
+#include <QKeyEvent>
+#include <QMouseEvent>
+#include <QResizeEvent>
+#include <QWheelEvent>
+#include <QWidget>
+
+#include <algorithm>
+#include <limits>
+
+namespace {
+constexpr char kMagic[] = "PIHMREC";
+constexpr int kMagicSize = 7;
+constexpr quint8 kVersion = 1;
+
+// Los modificadores de Qt ocupan los bits 25..29 (Shift, Ctrl, Alt, Meta, Keypad)
+quint8 packModifiers(Qt::KeyboardModifiers mods)
+{
+    return static_cast<quint8>((mods.toInt() >> 25) & 0x1f);
+}
+
+Qt::KeyboardModifiers unpackModifiers(quint8 packed)
+{
+    return Qt::KeyboardModifiers::fromInt(static_cast<int>(packed) << 25);
+}
+
+// Los botones de raton que usa la aplicacion caben en 8 bits (izquierdo, derecho, central, X1, X2)
+quint8 packButtons(Qt::MouseButtons buttons)
+{
+    return static_cast<quint8>(buttons.toInt() & 0xff);
+}
+
+qint16 clamp16(int v)
+{
+    return static_cast<qint16>(std::clamp(v, -32768, 32767));
+}
+
+RecordedEvent::Type typeFor(QEvent::Type type)
+{
+    switch (type) {
+    case QEvent::MouseButtonPress:
+        return RecordedEvent::Type::MousePress;
+    case QEvent::MouseButtonRelease:
+        return RecordedEvent::Type::MouseRelease;
+    case QEvent::MouseButtonDblClick:
+        return RecordedEvent::Type::MouseDoubleClick;
+    case QEvent::KeyPress:
+        return RecordedEvent::Type::KeyPress;
+    case QEvent::KeyRelease:
+        return RecordedEvent::Type::KeyRelease;
+    default:
+        return RecordedEvent::Type::MouseMove;
+    }
+}
+
+QEvent::Type qtTypeFor(RecordedEvent::Type type)
+{
+    switch (type) {
+    case RecordedEvent::Type::MousePress:
+        return QEvent::MouseButtonPress;
+    case RecordedEvent::Type::MouseRelease:
+        return QEvent::MouseButtonRelease;
+    case RecordedEvent::Type::MouseDoubleClick:
+        return QEvent::MouseButtonDblClick;
+    case RecordedEvent::Type::KeyPress:
+        return QEvent::KeyPress;
+    case RecordedEvent::Type::KeyRelease:
+        return QEvent::KeyRelease;
+    default:
+        return QEvent::MouseMove;
+    }
+}
+}
+
+std::unique_ptr<QEvent> RecordedEvent::toEvent(QWidget *viewport) const
+{
+    const Qt::KeyboardModifiers mods = unpackModifiers(modifiers);
+    const Qt::MouseButtons heldButtons = Qt::MouseButtons::fromInt(buttons);
+
+    switch (type) {
+    case Type::MousePress:
+    case Type::MouseRelease:
+    case Type::MouseMove:
+    case Type::MouseDoubleClick: {
+        const QPointF local(pos);
+        const QPointF global = viewport ? QPointF(viewport->mapToGlobal(pos)) : local;
+        auto event = std::make_unique<QMouseEvent>(qtTypeFor(type), local, local, global,
+                                                   static_cast<Qt::MouseButton>(button), heldButtons, mods);
+        // La hora grabada, no la de ahora: de ella sale la velocidad del deslizamiento
+        event->setTimestamp(quint64(timestampUs / 1000));
+        return event;
+    }
+    case Type::Wheel: {
+        const QPointF local(pos);
+        const QPointF global = viewport ? QPointF(viewport->mapToGlobal(pos)) : local;
+        auto event = std::make_unique<QWheelEvent>(local, global, QPoint(), angleDelta, heldButtons, mods,
+                                                   Qt::NoScrollPhase, false);
+        event->setTimestamp(quint64(timestampUs / 1000));
+        return event;
+    }
+    case Type::KeyPress:
+    case Type::KeyRelease: {
+        auto event = std::make_unique<QKeyEvent>(qtTypeFor(type), key, mods, text, autoRepeat);
+        event->setTimestamp(quint64(timestampUs / 1000));
+        return event;
+    }
+    case Type::Resize:
+    case Type::ViewState:
+        break;
+    }
+    return nullptr;
+}
+
+bool InputRecorder::start(const QString &path)
+{
+    stop();
+    m_file.setFileName(path);
+    if (!m_file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        return false;
+    }
+    m_out.setDevice(&m_file);
+    m_out.setByteOrder(QDataStream::LittleEndian);
+    m_out.writeRawData(kMagic, kMagicSize);
+    m_out << kVersion;
+    m_lastUs = 0;
+    m_clock.start();
+    return true;
+}
+
+void InputRecorder::stop()
+{
+    if (!m_file.isOpen()) {
+        return;
+    }
+    m_out.setDevice(nullptr);
+    m_file.close();
+}
+
+void InputRecorder::writeHeader(RecordedEvent::Type type, InteractionMode mode)
+{
+    const qint64 nowUs = m_clock.nsecsElapsed() / 1000;
+    const qint64 delta = std::clamp<qint64>(nowUs - m_lastUs, 0, std::numeric_limits<quint32>::max());
+    m_lastUs = nowUs;
+    m_out << static_cast<quint8>(type) << static_cast<quint32>(delta) << static_cast<quint8>(mode);
+}
+
+void InputRecorder::record(const QEvent *event, InteractionMode mode)
+{
+    if (!m_file.isOpen()) {
+        return;
+    }
+
+    switch (event->type()) {
+    case QEvent::MouseButtonPress:
+    case QEvent::MouseButtonRelease:
+    case QEvent::MouseButtonDblClick:
+    case QEvent::MouseMove: {
+        const auto *me = static_cast<const QMouseEvent *>(event);
+        const QPoint p = me->position().toPoint();
+        writeHeader(typeFor(event->type()), mode);
+        m_out << clamp16(p.x()) << clamp16(p.y())
+              << static_cast<quint8>(me->button()) << packButtons(me->buttons())
+              << packModifiers(me->modifiers());
+        break;
+    }
+    case QEvent::Wheel: {
+        const auto *we = static_cast<const QWheelEvent *>(event);
+        const QPoint p = we->position().toPoint();
+        writeHeader(RecordedEvent::Type::Wheel, mode);
+        m_out << clamp16(p.x()) << clamp16(p.y())
+              << clamp16(we->angleDelta().x()) << clamp16(we->angleDelta().y())
+              << packButtons(we->buttons()) << packModifiers(we->modifiers());
+        break;
+    }
+    case QEvent::KeyPress:
+    case QEvent::KeyRelease: {
+        const auto *ke = static_cast<const QKeyEvent *>(event);
+        const QString text = ke->text().left(255);
+        writeHeader(typeFor(event->type()), mode);
+        m_out << static_cast<qint32>(ke->key()) << packModifiers(ke->modifiers())
+              << static_cast<quint8>(ke->isAutoRepeat()) << static_cast<quint8>(text.size());
+        for (const QChar c : text) {
+            m_out << c.unicode();
+        }
+        break;
+    }
+    case QEvent::Resize: {
+        const QSize s = static_cast<const QResizeEvent *>(event)->size();
+        writeHeader(RecordedEvent::Type::Resize, mode);
+        m_out << clamp16(s.width()) << clamp16(s.height());
+        break;
+    }
+    default:
+        break;
+    }
+}
+
+void InputRecorder::recordViewState(double zoom, const QPoint &scroll, InteractionMode mode)
+{
+    if (!m_file.isOpen()) {
+        return;
+    }
+    writeHeader(RecordedEvent::Type::ViewState, mode);
+    m_out << zoom << static_cast<qint32>(scroll.x()) << static_cast<qint32>(scroll.y());
+}
+
+bool InputLog::load(const QString &path, QString *error)
+{
+    auto fail = [error](const QString &msg) {
+        if (error) {
+            *error = msg;
+        }
+        return false;
+    };
+
+    m_events.clear();
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return fail(file.errorString());
+    }
+
+    QDataStream in(&file);
+    in.setByteOrder(QDataStream::LittleEndian);
+
+    char magic[kMagicSize];
+    quint8 version = 0;
+    if (in.readRawData(magic, kMagicSize) != kMagicSize || !std::equal(magic, magic + kMagicSize, kMagic)) {
+        return fail(QStringLiteral("no es un registro de entrada"));
+    }
+    in >> version;
+    if (version != kVersion) {
+        return fail(QStringLiteral("version de registro no soportada: %1").arg(version));
+    }
+
+    m_events.reserve(static_cast<qsizetype>(file.size() / 12));
+    qint64 timestampUs = 0;
+    while (!in.atEnd()) {
+        quint8 type = 0;
+        quint32 delta = 0;
+        quint8 mode = 0;
+        in >> type >> delta >> mode;
+
+        RecordedEvent ev;
+        ev.type = static_cast<RecordedEvent::Type>(type);
+        timestampUs += delta;
+        ev.timestampUs = timestampUs;
+        ev.mode = mode < static_cast<quint8>(InteractionMode::Count) ? static_cast<InteractionMode>(mode)
+                                                                     : InteractionMode::Idle;
+
+        qint16 x = 0, y = 0;
+        switch (ev.type) {
+        case RecordedEvent::Type::MousePress:
+        case RecordedEvent::Type::MouseRelease:
+        case RecordedEvent::Type::MouseMove:
+        case RecordedEvent::Type::MouseDoubleClick:
+            in >> x >> y >> ev.button >> ev.buttons >> ev.modifiers;
+            ev.pos = QPoint(x, y);
+            break;
+        case RecordedEvent::Type::Wheel: {
+            qint16 dx = 0, dy = 0;
+            in >> x >> y >> dx >> dy >> ev.buttons >> ev.modifiers;
+            ev.pos = QPoint(x, y);
+            ev.angleDelta = QPoint(dx, dy);
+            break;
+        }
+        case RecordedEvent::Type::KeyPress:
+        case RecordedEvent::Type::KeyRelease: {
+            quint8 repeat = 0, len = 0;
+            in >> ev.key >> ev.modifiers >> repeat >> len;
+            ev.autoRepeat = repeat != 0;
+            ev.text.resize(len);
+            for (int i = 0; i < len; ++i) {
+                quint16 u = 0;
+                in >> u;
+                ev.text[i] = QChar(u);
+            }
+            break;
+        }
+        case RecordedEvent::Type::Resize:
+            in >> x >> y;
+            ev.size = QSize(x, y);
+            break;
+        case RecordedEvent::Type::ViewState: {
+            qint32 sx = 0, sy = 0;
+            in >> ev.zoom >> sx >> sy;
+            ev.scroll = QPoint(sx, sy);
+            break;
+        }
+        default:
+            return fail(QStringLiteral("tipo de registro desconocido %1 en el evento %2")
+                            .arg(type)
+                            .arg(m_events.size()));
+        }
+
+        if (in.status() != QDataStream::Ok) {
+            // Registro truncado (p.ej. la aplicacion se cerro a la fuerza): se usa lo leido
+            break;
+        }
+        m_events.append(ev);
+    }
+    return true;
+}
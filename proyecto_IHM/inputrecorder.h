@@ -0,0 +1,91 @@
+#ifndef INPUTRECORDER_H
+#define INPUTRECORDER_H
+
+#include "interactionmode.h"
+
+#include <QDataStream>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QPoint>
+#include <QSize>
+#include <QString>
+#include <QVector>
+
+#include <memory>
+
+class QEvent;
+class QWidget;
+
+// Formato binario del registro de entrada (little endian):
+//   cabecera: "PIHMREC" + quint8 version
+//   registro: quint8 tipo | quint32 us desde el registro anterior | quint8 modo | datos del tipo
+// Raton:  qint16 x, qint16 y, quint8 boton, quint8 botones, quint8 modificadores
+// Rueda:  qint16 x, qint16 y, qint16 angulo x, qint16 angulo y, quint8 botones, quint8 modificadores
+// Tecla:  qint32 tecla, quint8 modificadores, quint8 autorepeticion, quint8 n, n x quint16 texto
+// Tamano: qint16 ancho, qint16 alto (del viewport)
+// Vista:  double zoom, qint32 scroll horizontal, qint32 scroll vertical
+struct RecordedEvent {
+    enum class Type : quint8 {
+        MousePress = 1,
+        MouseRelease,
+        MouseMove,
+        MouseDoubleClick,
+        Wheel,
+        KeyPress,
+        KeyRelease,
+        Resize,
+        ViewState
+    };
+
+    Type type = Type::MouseMove;
+    qint64 timestampUs = 0;
+    InteractionMode mode = InteractionMode::Idle;
+
+    QPoint pos;
+    quint8 button = 0;
+    quint8 buttons = 0;
+    quint8 modifiers = 0;
+    QPoint angleDelta;
+    qint32 key = 0;
+    bool autoRepeat = false;
+    QString text;
+    QSize size;
+    double zoom = 1.0;
+    QPoint scroll;
+
+    // Reconstruye el QEvent equivalente (nullptr para Resize y ViewState)
+    std::unique_ptr<QEvent> toEvent(QWidget *viewport) const;
+};
+
+// Graba los eventos que MainWindow::eventFilter ve en el viewport
+class InputRecorder
+{
+public:
+    bool start(const QString &path);
+    void stop();
+    bool isRecording() const { return m_file.isOpen(); }
+
+    // Solo graba raton, rueda, teclado y cambios de tamano; el resto se ignora
+    void record(const QEvent *event, InteractionMode mode);
+    void recordViewState(double zoom, const QPoint &scroll, InteractionMode mode);
+
+private:
+    void writeHeader(RecordedEvent::Type type, InteractionMode mode);
+
+    QFile m_file;
+    QDataStream m_out;
+    QElapsedTimer m_clock;
+    qint64 m_lastUs = 0;
+};
+
+class InputLog
+{
+public:
+    bool load(const QString &path, QString *error = nullptr);
+    const QVector<RecordedEvent> &events() const { return m_events; }
+
+private:
+    QVector<RecordedEvent> m_events;
+};
+
+#endif // INPUTRECORDER_H
@@ -0,0 +1,33 @@
+#ifndef INTERACTIONMODE_H
+#define INTERACTIONMODE_H
+
+#include <QtGlobal>
+
+// Modo de interaccion activo sobre la carta (latencias, grabacion de eventos...)
+enum class InteractionMode : quint8 {
+    Idle = 0,
+    Line,
+    Arc,
+    Point,
+    Eraser,
+    Pan,
+    Text,
+    Count
+};
+
+inline const char *interactionModeName(InteractionMode mode)
+{
+    switch (mode) {
+    case InteractionMode::Idle:   return "idle";
+    case InteractionMode::Line:   return "line";
+    case InteractionMode::Arc:    return "arc";
+    case InteractionMode::Point:  return "point";
+    case InteractionMode::Eraser: return "eraser";
+    case InteractionMode::Pan:    return "pan";
+    case InteractionMode::Text:   return "text";
+    case InteractionMode::Count:  break;
+    }
+    return "unknown";
+}
+
+#endif // INTERACTIONMODE_H
@@ -0,0 +1,245 @@
+#include "intersectionengine.h"
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <queue>
+#include <set>
+#include <utility>
+#include <vector>
+
+namespace {
+constexpr double kBoundsSlack = 1e-6;   // segmentos horizontales/verticales tienen caja degenerada
+
+QRectF arcBox(const ArcPrimitive &arc)
+{
+    return QRectF(arc.center.x() - arc.radius, arc.center.y() - arc.radius, arc.radius * 2.0, arc.radius * 2.0);
+}
+}
+
+IntersectionEngine::IntersectionEngine(const GeoReference &geo)
+    : m_geo(geo)
+{
+}
+
+IntersectionEngine::Id IntersectionEngine::addSegment(const QLineF &segment)
+{
+    Primitive p;
+    p.segment = segment;
+    p.bounds = QRectF(segment.p1(), segment.p2()).normalized();
+    return insert(std::move(p));
+}
+
+IntersectionEngine::Id IntersectionEngine::addArc(const ArcPrimitive &arc)
+{
+    Primitive p;
+    p.isArc = true;
+    p.arc = arc;
+    p.bounds = arcBox(arc);
+    return insert(std::move(p));
+}
+
+IntersectionEngine::Id IntersectionEngine::insert(Primitive primitive)
+{
+    primitive.bounds.adjust(-kBoundsSlack, -kBoundsSlack, kBoundsSlack, kBoundsSlack);
+    primitive.alive = true;
+    primitive.pending = true;
+    m_primitives.append(std::move(primitive));
+    const auto id = static_cast<Id>(m_primitives.size());
+    m_pending.append(id);
+    return id;
+}
+
+void IntersectionEngine::remove(Id id)
+{
+    if (id == kInvalidId || id > static_cast<Id>(m_primitives.size())) {
+        return;
+    }
+    Primitive &p = m_primitives[id - 1];
+    if (!p.alive) {
+        return;
+    }
+    p.alive = false;
+    if (p.pending) {
+        p.pending = false;
+        m_pending.removeOne(id);
+        return; // aun no tenia cortes calculados
+    }
+    m_results.erase(std::remove_if(m_results.begin(), m_results.end(),
+                                   [id](const Intersection &hit) { return hit.first == id || hit.second == id; }),
+                    m_results.end());
+    m_gridDirty = true;
+}
+
+void IntersectionEngine::clear()
+{
+    m_primitives.clear();
+    m_pending.clear();
+    m_results.clear();
+    m_swept = false;
+    m_grid = {};
+    m_gridDirty = true;
+}
+
+void IntersectionEngine::refreshGeo()
+{
+    for (Intersection &hit : m_results) {
+        hit.geo = m_geo.toGeo(hit.scenePos);
+    }
+}
+
+const QVector<IntersectionEngine::Intersection> &IntersectionEngine::intersections()
+{
+    update();
+    return m_results;
+}
+
+const IntersectionEngine::Intersection *IntersectionEngine::nearest(const QPointF &pos, double radius)
+{
+    update();
+    if (m_gridDirty) {
+        rebuildGrid();
+    }
+
+    const auto x0 = static_cast<qint32>(std::floor((pos.x() - radius) / kGridCell));
+    const auto x1 = static_cast<qint32>(std::floor((pos.x() + radius) / kGridCell));
+    const auto y0 = static_cast<qint32>(std::floor((pos.y() - radius) / kGridCell));
+    const auto y1 = static_cast<qint32>(std::floor((pos.y() + radius) / kGridCell));
+    double bestDist2 = radius * radius;
+    const Intersection *best = nullptr;
+    for (qint32 x = x0; x <= x1; ++x) {
+        for (qint32 y = y0; y <= y1; ++y) {
+            const auto it = m_grid.constFind(cellKey(x, y));
+            if (it == m_grid.constEnd()) {
+                continue;
+            }
+            for (int index : it.value()) {
+                const QPointF d = m_results.at(index).scenePos - pos;
+                const double dist2 = QPointF::dotProduct(d, d);
+                if (dist2 <= bestDist2) {
+                    bestDist2 = dist2;
+                    best = &m_results.at(index);
+                }
+            }
+        }
+    }
+    return best;
+}
+
+quint64 IntersectionEngine::cellKey(qint32 x, qint32 y)
+{
+    return (static_cast<quint64>(static_cast<quint32>(x)) << 32) | static_cast<quint32>(y);
+}
+
+void IntersectionEngine::rebuildGrid()
+{
+    m_grid.clear();
+    for (int i = 0; i < m_results.size(); ++i) {
+        const QPointF &p = m_results.at(i).scenePos;
+        m_grid[cellKey(static_cast<qint32>(std::floor(p.x() / kGridCell)),
+                       static_cast<qint32>(std::floor(p.y() / kGridCell)))].append(i);
+    }
+    m_gridDirty = false;
+}
+
+void IntersectionEngine::update()
+{
+    if (m_pending.isEmpty()) {
+        return;
+    }
+    if (!m_swept || m_pending.size() > kIncrementalLimit) {
+        sweep();
+        return;
+    }
+
+    // Cada alta contra todo lo ya resuelto; al terminar pasa a estar resuelta para la siguiente
+    for (Id id : std::as_const(m_pending)) {
+        for (Id other = 1; other <= static_cast<Id>(m_primitives.size()); ++other) {
+            const Primitive &p = m_primitives[other - 1];
+            if (other != id && p.alive && !p.pending) {
+                testPair(id, other);
+            }
+        }
+        m_primitives[id - 1].pending = false;
+    }
+    m_pending.clear();
+}
+
+void IntersectionEngine::sweep()
+{
+    m_results.clear();
+    m_pending.clear();
+    m_swept = true;
+    m_gridDirty = true;
+
+    // Eventos de entrada ordenados por el borde izquierdo de la caja. La lista activa guarda las
+    // primitivas que aun cortan la linea de barrido, ordenadas por el borde superior de su caja:
+    // la que entra solo recorre las activas cuyo borde superior no pasa de su borde inferior.
+    // Las salidas se sacan de un monticulo por borde derecho.
+    QVector<Id> order;
+    order.reserve(m_primitives.size());
+    for (Id id = 1; id <= static_cast<Id>(m_primitives.size()); ++id) {
+        Primitive &p = m_primitives[id - 1];
+        p.pending = false;
+        if (p.alive) {
+            order.append(id);
+        }
+    }
+    std::sort(order.begin(), order.end(), [this](Id a, Id b) {
+        return m_primitives[a - 1].bounds.left() < m_primitives[b - 1].bounds.left();
+    });
+
+    using Key = std::pair<double, Id>;
+    std::set<Key> active;
+    std::priority_queue<Key, std::vector<Key>, std::greater<Key>> exits;
+    for (Id id : std::as_const(order)) {
+        const QRectF &box = m_primitives[id - 1].bounds;
+        while (!exits.empty() && exits.top().first < box.left()) {
+            const Id gone = exits.top().second;
+            exits.pop();
+            active.erase({m_primitives[gone - 1].bounds.top(), gone});
+        }
+        for (auto it = active.begin(); it != active.end() && it->first <= box.bottom(); ++it) {
+            if (box.top() <= m_primitives[it->second - 1].bounds.bottom()) {
+                testPair(it->second, id);
+            }
+        }
+        active.insert({box.top(), id});
+        exits.push({box.right(), id});
+    }
+}
+
+void IntersectionEngine::testPair(Id a, Id b)
+{
+    const Primitive &pa = m_primitives[a - 1];
+    const Primitive &pb = m_primitives[b - 1];
+    if (!pa.bounds.intersects(pb.bounds)) {
+        return;
+    }
+
+    QPointF hits[2];
+    int count = 0;
+    if (!pa.isArc && !pb.isArc) {
+        count = pa.segment.intersects(pb.segment, &hits[0]) == QLineF::BoundedIntersection ? 1 : 0;
+    } else if (!pa.isArc) {
+        count = intersectSegmentArc(pa.segment, pb.arc, hits);
+    } else if (!pb.isArc) {
+        count = intersectSegmentArc(pb.segment, pa.arc, hits);
+    } else {
+        count = intersectArcs(pa.arc, pb.arc, hits);
+    }
+
+    for (int i = 0; i < count; ++i) {
+        Intersection hit;
+        hit.scenePos = hits[i];
+        hit.geo = m_geo.toGeo(hits[i]);
+        hit.first = std::min(a, b);
+        hit.second = std::max(a, b);
+        m_results.append(hit);
+        // Las altas sueltas entran en la rejilla sin rehacerla
+        if (!m_gridDirty) {
+            m_grid[cellKey(static_cast<qint32>(std::floor(hit.scenePos.x() / kGridCell)),
+                           static_cast<qint32>(std::floor(hit.scenePos.y() / kGridCell)))].append(m_results.size() - 1);
+        }
+    }
+}
@@ -0,0 +1,75 @@
+#ifndef INTERSECTIONENGINE_H
+#define INTERSECTIONENGINE_H
+
+#include "arcitem.h"
+#include "georeference.h"
+
+#include <QHash>
+#include <QLineF>
+#include <QPointF>
+#include <QRectF>
+#include <QVector>
+
+// Cortes entre las lineas de posicion y los arcos de la pizarra, con su latitud y longitud.
+// La primera consulta (o una tanda grande de altas) hace un barrido en x de todas las primitivas;
+// despues cada alta solo se cruza con las existentes y cada baja descarta sus cortes.
+class IntersectionEngine
+{
+public:
+    using Id = quint32;
+    static constexpr Id kInvalidId = 0;
+
+    struct Intersection {
+        QPointF scenePos;
+        GeoPoint geo;
+        Id first = kInvalidId;
+        Id second = kInvalidId;
+    };
+
+    // geo debe vivir mas que el motor; si cambia su contenido hay que llamar a refreshGeo()
+    explicit IntersectionEngine(const GeoReference &geo);
+
+    Id addSegment(const QLineF &segment);
+    Id addArc(const ArcPrimitive &arc);
+    void remove(Id id);
+    void clear();
+    // Recalcula la latitud y longitud de los cortes ya resueltos
+    void refreshGeo();
+
+    // Resuelve las altas pendientes antes de devolver
+    const QVector<Intersection> &intersections();
+    // Corte mas cercano a pos a no mas de radius, o nullptr. Busca en una rejilla de los cortes en
+    // vez de recorrerlos todos; el puntero vale hasta el siguiente cambio del motor.
+    const Intersection *nearest(const QPointF &pos, double radius);
+
+private:
+    struct Primitive {
+        bool isArc = false;
+        QLineF segment;
+        ArcPrimitive arc;
+        QRectF bounds;
+        bool alive = false;
+        bool pending = false;
+    };
+
+    // Por encima de este numero de altas pendientes sale mas barato barrer todo de nuevo
+    static constexpr int kIncrementalLimit = 32;
+    static constexpr double kGridCell = 128.0;  // lado de una celda de la rejilla de cortes, en escena
+
+    Id insert(Primitive primitive);
+    void update();
+    void sweep();
+    void testPair(Id a, Id b);
+    static quint64 cellKey(qint32 x, qint32 y);
+    void rebuildGrid();
+
+    const GeoReference &m_geo;
+    QVector<Primitive> m_primitives;    // indice = id - 1
+    QVector<Id> m_pending;
+    QVector<Intersection> m_results;
+    bool m_swept = false;
+    QHash<quint64, QVector<int>> m_grid;    // celda -> indices en m_results
+    bool m_gridDirty = true;                // los indices ya no valen (barrido o bajas)
+};
+
+#endif // INTERSECTIONENGINE_H
@@ -0,0 +1,168 @@
+#include "latencymonitor.h"
+
+#include <QDateTime>
+#include <QFile>
+#include <QJsonDocument>
+#include <QLabel>
+#include <QStringList>
+#include <QVarLengthArray>
+#include <QWidget>
+
+#include <algorithm>
+
+namespace {
+constexpr int kHudRefreshMs = 500;
+
+double percentileOf(QVarLengthArray<float, 512> &values, double q)
+{
+    if (values.isEmpty()) {
+        return 0.0;
+    }
+    const qsizetype idx = std::min<qsizetype>(values.size() - 1,
+                                              static_cast<qsizetype>(q * values.size()));
+    std::nth_element(values.begin(), values.begin() + idx, values.end());
+    return values[idx];
+}
+}
+
+LatencyMonitor::LatencyMonitor(QObject *parent)
+    : QObject(parent)
+{
+    m_clock.start();
+    m_hudTimer.setInterval(kHudRefreshMs);
+    connect(&m_hudTimer, &QTimer::timeout, this, &LatencyMonitor::refreshHud);
+}
+
+void LatencyMonitor::inputArrived(InteractionMode mode)
+{
+    if (m_pendingCount >= kMaxPending) {
+        return;
+    }
+    m_pending[m_pendingCount++] = Pending{m_clock.nsecsElapsed(), mode};
+}
+
+void LatencyMonitor::framePainted()
+{
+    if (m_pendingCount == 0) {
+        return;
+    }
+
+    const qint64 now = m_clock.nsecsElapsed();
+    for (int i = 0; i < m_pendingCount; ++i) {
+        const qint64 latencyNs = now - m_pending[i].arrivalNs;
+        if (latencyNs > kStaleNs) {
+            continue;
+        }
+        Window &w = m_windows[static_cast<int>(m_pending[i].mode)];
+        w.samplesMs[w.next] = static_cast<float>(latencyNs / 1.0e6);
+        w.next = (w.next + 1) % kWindow;
+        w.count = std::min(w.count + 1, kWindow);
+    }
+    m_pendingCount = 0;
+}
+
+LatencyMonitor::Percentiles LatencyMonitor::percentiles(InteractionMode mode) const
+{
+    const Window &w = m_windows[static_cast<int>(mode)];
+    QVarLengthArray<float, 512> values(w.samplesMs.begin(), w.samplesMs.begin() + w.count);
+
+    Percentiles p;
+    p.samples = w.count;
+    p.p50 = percentileOf(values, 0.50);
+    p.p95 = percentileOf(values, 0.95);
+    p.p99 = percentileOf(values, 0.99);
+    return p;
+}
+
+QJsonObject LatencyMonitor::toJson() const
+{
+    QJsonObject modes;
+    for (int m = 0; m < static_cast<int>(InteractionMode::Count); ++m) {
+        const auto mode = static_cast<InteractionMode>(m);
+        const Percentiles p = percentiles(mode);
+        if (p.samples == 0) {
+            continue;
+        }
+        QJsonObject entry;
+        entry.insert(QStringLiteral("samples"), p.samples);
+        entry.insert(QStringLiteral("p50_ms"), p.p50);
+        entry.insert(QStringLiteral("p95_ms"), p.p95);
+        entry.insert(QStringLiteral("p99_ms"), p.p99);
+        modes.insert(QString::fromLatin1(interactionModeName(mode)), entry);
+    }
+
+    QJsonObject root;
+    root.insert(QStringLiteral("timestamp"), QDateTime::currentDateTimeUtc().toString(Qt::ISODate));
+    root.insert(QStringLiteral("window"), kWindow);
+    root.insert(QStringLiteral("modes"), modes);
+    return root;
+}
+
+bool LatencyMonitor::writeJson(const QString &path) const
+{
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        return false;
+    }
+    return file.write(QJsonDocument(toJson()).toJson(QJsonDocument::Indented)) > 0;
+}
+
+void LatencyMonitor::setHudVisible(bool visible, QWidget *parent)
+{
+    if (visible) {
+        if (!m_hud && parent) {
+            m_hud = new QLabel(parent);
+            m_hud->setProperty("role", "latencyHud");
+            // Fondo opaco: refrescar el HUD no debe repintar la carta de debajo
+            m_hud->setAttribute(Qt::WA_StyledBackground, true);
+            m_hud->setAutoFillBackground(true);
+            m_hud->setAttribute(Qt::WA_TransparentForMouseEvents, true);
+            m_hud->move(8, 8);
+        }
+        if (m_hud) {
+            refreshHud();
+            m_hud->show();
+            m_hud->raise();
+            m_hudTimer.start();
+        }
+        return;
+    }
+
+    m_hudTimer.stop();
+    if (m_hud) {
+        m_hud->hide();
+    }
+}
+
+bool LatencyMonitor::hudVisible() const
+{
+    return m_hud && m_hud->isVisible();
+}
+
+void LatencyMonitor::refreshHud()
+{
+    if (!m_hud) {
+        return;
+    }
+
+    QStringList lines;
+    lines << tr("Latencia entrada->pantalla (ms)");
+    for (int m = 0; m < static_cast<int>(InteractionMode::Count); ++m) {
+        const auto mode = static_cast<InteractionMode>(m);
+        const Percentiles p = percentiles(mode);
+        if (p.samples == 0) {
+            continue;
+        }
+        lines << QStringLiteral("%1 p50 %2  p95 %3  p99 %4  n=%5")
+                     .arg(QString::fromLatin1(interactionModeName(mode)), -7)
+                     .arg(p.p50, 5, 'f', 1)
+                     .arg(p.p95, 5, 'f', 1)
+                     .arg(p.p99, 5, 'f', 1)
+                     .arg(p.samples);
+    }
+    if (lines.size() == 1) {
+        lines << tr("(sin muestras todavia)");
+    }
+    m_hud->setText(lines.join(QLatin1Char('\n')));
+    m_hud->adjustSize();
+}
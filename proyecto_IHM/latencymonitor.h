@@ -0,0 +1,76 @@
+#ifndef LATENCYMONITOR_H
+#define LATENCYMONITOR_H
+
+#include "interactionmode.h"
+
+#include <QElapsedTimer>
+#include <QJsonObject>
+#include <QObject>
+#include <QPointer>
+#include <QString>
+#include <QTimer>
+
+#include <array>
+
+class QLabel;
+class QWidget;
+
+// Latencia entrada -> pantalla: cada evento se marca al llegar a MainWindow::eventFilter y se
+// empareja con el siguiente pintado completo del viewport. Mantiene una ventana movil por modo.
+class LatencyMonitor : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct Percentiles {
+        double p50 = 0.0;
+        double p95 = 0.0;
+        double p99 = 0.0;
+        int samples = 0;
+    };
+
+    explicit LatencyMonitor(QObject *parent = nullptr);
+
+    // Llamar al llegar el evento, antes de procesarlo
+    void inputArrived(InteractionMode mode);
+
+    Percentiles percentiles(InteractionMode mode) const;
+    QJsonObject toJson() const;
+    bool writeJson(const QString &path) const;
+
+    // HUD superpuesto en la esquina superior izquierda de parent. Usar la vista, no su viewport:
+    // QWidget::scroll() desplaza los hijos del viewport al hacer panning.
+    void setHudVisible(bool visible, QWidget *parent);
+    bool hudVisible() const;
+
+public slots:
+    void framePainted();
+
+private:
+    static constexpr int kWindow = 512;
+    static constexpr int kMaxPending = 64;
+    static constexpr qint64 kStaleNs = 500'000'000; // eventos sin pintado en 500 ms no se cuentan
+
+    struct Pending {
+        qint64 arrivalNs = 0;
+        InteractionMode mode = InteractionMode::Idle;
+    };
+
+    struct Window {
+        std::array<float, kWindow> samplesMs{};
+        int count = 0;
+        int next = 0;
+    };
+
+    void refreshHud();
+
+    QElapsedTimer m_clock;
+    std::array<Pending, kMaxPending> m_pending{};
+    int m_pendingCount = 0;
+    std::array<Window, static_cast<int>(InteractionMode::Count)> m_windows{};
+
+    QPointer<QLabel> m_hud;
+    QTimer m_hudTimer;
+};
+
+#endif // LATENCYMONITOR_H
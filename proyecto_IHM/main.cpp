@@ -1,4 +1,5 @@
 #include "mainwindow.h"
+#include "trace.h"
 
 #include <QApplication>
 #include <QFile>
@@ -6,20 +7,32 @@
 #include <QFontDatabase>
 #include <QLibraryInfo>
 #include <QLocale>
+#include <QStandardPaths>
 #include <QStyleFactory>
 #include <QTextStream>
+#include <QTimer>
 #include <QTranslator>
 
+#include <optional>
+
 int main(int argc, char *argv[])
 {
+    Trace::initFromEnvironment();
+
+    std::optional<ScopedTrace> startupTrace(std::in_place, "startup");
+    std::optional<ScopedTrace> appTrace(std::in_place, "QApplication");
     QApplication a(argc, argv);
+    appTrace.reset();
     QLocale::setDefault(QLocale(QLocale::Spanish, QLocale::Spain));
     QTranslator qtTranslator;
-    if (qtTranslator.load(QLocale(),
-                          QStringLiteral("qtbase"),
-                          QStringLiteral("_"),
-                          QLibraryInfo::path(QLibraryInfo::TranslationsPath))) {
-        a.installTranslator(&qtTranslator);
+    {
+        TRACE_SCOPE("QTranslator::load");
+        if (qtTranslator.load(QLocale(),
+                              QStringLiteral("qtbase"),
+                              QStringLiteral("_"),
+                              QLibraryInfo::path(QLibraryInfo::TranslationsPath))) {
+            a.installTranslator(&qtTranslator);
+        }
     }
 
 #ifdef Q_OS_WIN
@@ -28,21 +41,60 @@ int main(int argc, char *argv[])
     }
 #endif
 
-    QFontDatabase::addApplicationFont(":/fonts/Inter-Regular.ttf");
-    QFontDatabase::addApplicationFont(":/fonts/Inter-SemiBold.ttf");
-    QFontDatabase::addApplicationFont(":/fonts/Inter-Bold.ttf");
-    a.setFont(QFont(QStringLiteral("Inter")));
+    {
+        TRACE_SCOPE("addApplicationFont");
+        {
+            TRACE_SCOPE("Inter-Regular.ttf");
+            QFontDatabase::addApplicationFont(":/fonts/Inter-Regular.ttf");
+        }
+        {
+            TRACE_SCOPE("Inter-SemiBold.ttf");
+            QFontDatabase::addApplicationFont(":/fonts/Inter-SemiBold.ttf");
+        }
+        {
+            TRACE_SCOPE("Inter-Bold.ttf");
+            QFontDatabase::addApplicationFont(":/fonts/Inter-Bold.ttf");
+        }
+        a.setFont(QFont(QStringLiteral("Inter")));
+    }
 
     // Load and apply stylesheet
-    QFile file(":/stylesheet.qss");
-    if(file.open(QFile::ReadOnly | QFile::Text))
     {
-        QTextStream stream(&file);
-        a.setStyleSheet(stream.readAll());
-        file.close();
+        TRACE_SCOPE("stylesheet");
+        QFile file(":/stylesheet.qss");
+        if(file.open(QFile::ReadOnly | QFile::Text))
+        {
+            QTextStream stream(&file);
+            a.setStyleSheet(stream.readAll());
+            file.close();
+        }
     }
 
+    std::optional<ScopedTrace> windowTrace(std::in_place, "MainWindow::MainWindow");
     MainWindow w;
-    w.show();
-    return a.exec();
+    windowTrace.reset();
+    {
+        TRACE_SCOPE("autosave");
+        QString autosaveDir = qEnvironmentVariable("PROYECTO_IHM_AUTOSAVE_DIR");
+        if (autosaveDir.isEmpty()) {
+            autosaveDir = QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation)
+                          + QStringLiteral("/autosave");
+        }
+        w.startAutosave(autosaveDir);
+    }
+    {
+        TRACE_SCOPE("MainWindow::show");
+        w.show();
+    }
+
+    // El primer ciclo del bucle de eventos incluye el primer pintado de la ventana
+    QTimer::singleShot(0, &w, [&startupTrace]() {
+        startupTrace.reset();
+        Trace::instant("event loop");
+        Trace::flush();
+    });
+
+    const int rc = a.exec();
+    Trace::flush();
+    return rc;
 }
@@ -8,9 +8,21 @@
 #include "historydialog.h"
 #include "helpdialog.h"
 #include "compass_tool.h"
+#include "rulertool.h"
+#include "protractortool.h"
+#include "chartview.h"
+#include "chartcatalogue.h"
+#include "charttiles.h"
+#include "georeference.h"
+#include "latencymonitor.h"
+#include "inputrecorder.h"
+#include "boardfile.h"
+#include "boardjournal.h"
+#include "chartexporter.h"
+#include "vectorexport.h"
+#include "trace.h"
 #include "navdb/lib/include/navigation.h"
 #include "navdb/lib/include/navdaoexception.h"
-#include <QGraphicsPixmapItem>
 #include <QVBoxLayout>
 #include <QHBoxLayout>
 #include <QMessageBox>
@@ -40,6 +52,8 @@
 #include <QFrame>
 #include <QSizePolicy>
 #include <QTextCharFormat>
+#include <QTextDocument>
+#include <QTextBlock>
 #include <QFontMetrics>
 #include <QCursor>
 #include <QPointer>
@@ -53,8 +67,17 @@
 #include <QPainterPath>
 #include <QPainterPathStroker>
 #include <QTimer>
+#include <QDir>
+#include <QAction>
+#include <QKeySequence>
+#include <QFileDialog>
+#include <QTabBar>
+#include <QInputDialog>
+#include <QProgressDialog>
 #include <cmath>
 #include <algorithm>
+#include <optional>
+#include <utility>
 
 namespace {
 class ConstrainedTextProxyWidget final : public QGraphicsProxyWidget
@@ -158,11 +181,14 @@ MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent)
     , ui(new Ui::MainWindow),
       scene(new QGraphicsScene(this)),
-      view(new QGraphicsView(this)),
-      dibujos(scene, view),
+      view(new ChartView(this)),
+      dibujos(createDibujos(scene)),
       userAgent(Navigation::instance())
 {
-    ui->setupUi(this);
+    {
+        TRACE_SCOPE("setupUi");
+        ui->setupUi(this);
+    }
 
     setWindowTitle("Carta Nautica"); // simple title placeholder
     view->setScene(scene);
@@ -174,17 +200,32 @@ MainWindow::MainWindow(QWidget *parent)
     view->viewport()->setFocusPolicy(Qt::StrongFocus);
     view->setMouseTracking(true);
     view->viewport()->setMouseTracking(true);
+    connect(view, &ChartView::zoomChanged, this, [this](double zoom) {
+        currentZoom = zoom;
+        zoomChanged();
+    });
 
     auto *mainLayout = new QVBoxLayout(ui->centralwidget);
     mainLayout->setContentsMargins(8, 8, 8, 8);
     mainLayout->setSpacing(6);
+    m_boardTabs = new QTabBar(ui->centralwidget);
+    m_boardTabs->setDocumentMode(true);
+    m_boardTabs->setExpanding(false);
+    m_boardTabs->setFocusPolicy(Qt::NoFocus);
+    m_boardTabs->addTab(tr("Pizarra 1"));
+    m_boards.resize(1);
+    connect(m_boardTabs, &QTabBar::currentChanged, this, &MainWindow::switchBoard);
+    connect(m_boardTabs, &QTabBar::tabCloseRequested, this, &MainWindow::closeBoard);
+    mainLayout->addWidget(m_boardTabs);
     mainLayout->addWidget(view, 1);
 
-    QPixmap pm(":/images/carta_nautica.jpg");
-    QGraphicsPixmapItem *item = scene->addPixmap(pm);
-    item->setZValue(0);
-    m_chartRect = item->boundingRect();
-    scene->setSceneRect(m_chartRect);
+    {
+        // Solo la cabecera de la imagen: las teselas se decodifican al pintarlas
+        TRACE_SCOPE("chart open");
+        ChartCatalogue &catalogue = ChartCatalogue::instance();
+        m_chart = catalogue.open(catalogue.defaultId());
+        applyChart();
+    }
 
     currentZoom = 0.20;
     applyZoom();
@@ -193,6 +234,7 @@ MainWindow::MainWindow(QWidget *parent)
     statusBar()->showMessage(tr("Pulsa F1 para ver la ayuda."), 7000);
 
     // Configuracion de la Tool Bar
+    std::optional<ScopedTrace> toolbarTrace(std::in_place, "toolbar setup");
     ui->toolBar->setIconSize(QSize(56, 56));
     ui->toolBar->setMovable(false);
     ui->toolBar->setFloatable(false);
@@ -304,20 +346,109 @@ MainWindow::MainWindow(QWidget *parent)
         }
     };
 
-    markToggleButton(ui->actiondibujar_punto);
-    markToggleButton(ui->actiondibujar_linea);
-    markToggleButton(ui->actiondibujar_curva);
-    markToggleButton(ui->actionanadir_texto);
-    markToggleButton(ui->actionborrador);
-    markToggleButton(ui->actionregla);
-    markToggleButton(ui->actioncompas);
-    markToggleButton(ui->actiontransportador);
-    markToggleButton(ui->actionpuntos_mapa);
+    {
+        TRACE_SCOPE("markToggleButton (unpolish/polish)");
+        markToggleButton(ui->actiondibujar_punto);
+        markToggleButton(ui->actiondibujar_linea);
+        markToggleButton(ui->actiondibujar_curva);
+        markToggleButton(ui->actionanadir_texto);
+        markToggleButton(ui->actionborrador);
+        markToggleButton(ui->actionregla);
+        markToggleButton(ui->actioncompas);
+        markToggleButton(ui->actiontransportador);
+        markToggleButton(ui->actionpuntos_mapa);
+    }
+    toolbarTrace.reset();
 
     connect(scene, &QGraphicsScene::selectionChanged,
             this, &MainWindow::onSceneSelectionChanged);
 
+    m_latency = new LatencyMonitor(this);
+    connect(view, &ChartView::framePainted,
+            m_latency, &LatencyMonitor::framePainted);
+    auto *latencyHudAction = new QAction(tr("Latencias"), this);
+    latencyHudAction->setShortcut(QKeySequence(Qt::Key_F12));
+    connect(latencyHudAction, &QAction::triggered, this, &MainWindow::toggleLatencyHud);
+    addAction(latencyHudAction);
+    auto *latencyDumpAction = new QAction(tr("Guardar latencias"), this);
+    latencyDumpAction->setShortcut(QKeySequence(Qt::SHIFT | Qt::Key_F12));
+    connect(latencyDumpAction, &QAction::triggered, this, &MainWindow::dumpLatencyJson);
+    addAction(latencyDumpAction);
+
+    auto *saveBoardAction = new QAction(tr("Guardar pizarra"), this);
+    saveBoardAction->setShortcut(QKeySequence::Save);
+    connect(saveBoardAction, &QAction::triggered, this, &MainWindow::saveBoard);
+    addAction(saveBoardAction);
+    auto *openBoardAction = new QAction(tr("Abrir pizarra"), this);
+    openBoardAction->setShortcut(QKeySequence::Open);
+    connect(openBoardAction, &QAction::triggered, this, &MainWindow::openBoard);
+    addAction(openBoardAction);
+    auto *exportChartAction = new QAction(tr("Exportar carta"), this);
+    exportChartAction->setShortcut(QKeySequence(Qt::CTRL | Qt::Key_E));
+    connect(exportChartAction, &QAction::triggered, this, &MainWindow::exportChart);
+    addAction(exportChartAction);
+    auto *chooseChartAction = new QAction(tr("Cambiar carta"), this);
+    chooseChartAction->setShortcut(QKeySequence(Qt::CTRL | Qt::SHIFT | Qt::Key_C));
+    connect(chooseChartAction, &QAction::triggered, this, &MainWindow::chooseChart);
+    addAction(chooseChartAction);
+
+    // Con el foco en un cuadro de texto el atajo lo atiende el propio editor
+    auto *undoAction = new QAction(tr("Deshacer"), this);
+    undoAction->setShortcut(QKeySequence::Undo);
+    connect(undoAction, &QAction::triggered, this, &MainWindow::undoBoard);
+    addAction(undoAction);
+    auto *redoAction = new QAction(tr("Rehacer"), this);
+    QList<QKeySequence> redoKeys = QKeySequence::keyBindings(QKeySequence::Redo);
+    if (!redoKeys.contains(QKeySequence(Qt::CTRL | Qt::Key_Y))) {
+        redoKeys.append(QKeySequence(Qt::CTRL | Qt::Key_Y));
+    }
+    redoAction->setShortcuts(redoKeys);
+    connect(redoAction, &QAction::triggered, this, &MainWindow::redoBoard);
+    addAction(redoAction);
+
+    auto *newBoardAction = new QAction(tr("Nueva pizarra"), this);
+    newBoardAction->setShortcut(QKeySequence::AddTab);
+    connect(newBoardAction, &QAction::triggered, this, &MainWindow::addBoard);
+    addAction(newBoardAction);
+    auto *closeBoardAction = new QAction(tr("Cerrar pizarra"), this);
+    closeBoardAction->setShortcut(QKeySequence::Close);
+    connect(closeBoardAction, &QAction::triggered, this, [this] { closeBoard(m_activeBoard); });
+    addAction(closeBoardAction);
+    auto *nextBoardAction = new QAction(tr("Pizarra siguiente"), this);
+    nextBoardAction->setShortcut(QKeySequence::NextChild);
+    connect(nextBoardAction, &QAction::triggered, this, [this] {
+        m_boardTabs->setCurrentIndex((m_activeBoard + 1) % m_boardTabs->count());
+    });
+    addAction(nextBoardAction);
+    auto *previousBoardAction = new QAction(tr("Pizarra anterior"), this);
+    previousBoardAction->setShortcut(QKeySequence::PreviousChild);
+    connect(previousBoardAction, &QAction::triggered, this, [this] {
+        m_boardTabs->setCurrentIndex((m_activeBoard + m_boardTabs->count() - 1) % m_boardTabs->count());
+    });
+    addAction(previousBoardAction);
+
+    m_textChangeTimer = new QTimer(this);
+    m_textChangeTimer->setSingleShot(true);
+    m_textChangeTimer->setInterval(400);
+    connect(m_textChangeTimer, &QTimer::timeout, this, &MainWindow::flushTextBoxChanges);
+
+    const QString recordPath = qEnvironmentVariable("PROYECTO_IHM_RECORD");
+    if (!recordPath.isEmpty()) {
+        m_recorder = new InputRecorder;
+        if (m_recorder->start(recordPath)) {
+            const auto markDirty = [this] { m_recordViewStateDirty = true; };
+            connect(view->horizontalScrollBar(), &QScrollBar::valueChanged, this, markDirty);
+            connect(view->verticalScrollBar(), &QScrollBar::valueChanged, this, markDirty);
+        } else {
+            qWarning("No se pudo abrir el registro de entrada %s", qPrintable(recordPath));
+            delete m_recorder;
+            m_recorder = nullptr;
+        }
+    }
+
     view->viewport()->installEventFilter(this);
+    // Las teclas llegan a la vista (tiene el foco), no al viewport
+    view->installEventFilter(this);
 }
 
 void MainWindow::on_actionayuda_triggered()
@@ -359,6 +490,16 @@ void MainWindow::promptLoginOnStartup()
 
 MainWindow::~MainWindow()
 {
+    const QString latencyPath = qEnvironmentVariable("PROYECTO_IHM_LATENCY_JSON");
+    if (!latencyPath.isEmpty() && m_latency) {
+        m_latency->writeJson(latencyPath);
+    }
+    delete m_recorder;
+    flushTextBoxChanges();
+    delete m_journal;
+    for (BoardTab &tab : m_boards) {
+        delete tab.journal;
+    }
     delete ui;
 }
 
@@ -370,37 +511,62 @@ QMenu* MainWindow::createPopupMenu()
 // Acciones del zoom
 void MainWindow::on_actionzoom_in_triggered()
 {
-    double newZoom = std::clamp(currentZoom * 1.2, kMinZoom, kMaxZoom);
-    if (newZoom != currentZoom) {
-        currentZoom = newZoom;
-        applyZoom();
-    }
+    zoomBy(1.2, zoomAnchor());
 }
 void MainWindow::on_actionzoom_out_triggered()
 {
-    double newZoom = std::clamp(currentZoom / 1.2, kMinZoom, kMaxZoom);
-    if (newZoom != currentZoom) {
-        currentZoom = newZoom;
-        applyZoom();
+    zoomBy(1.0 / 1.2, zoomAnchor());
+}
+
+// Bajo el cursor si esta sobre la carta; si no (p. ej. en la barra de herramientas), el centro
+QPoint MainWindow::zoomAnchor() const
+{
+    const QPoint cursor = view->viewport()->mapFromGlobal(QCursor::pos());
+    return view->viewport()->rect().contains(cursor) ? cursor : view->viewport()->rect().center();
+}
+
+void MainWindow::zoomBy(double factor, const QPoint &anchor)
+{
+    // Los pasos se acumulan sobre el destino: varios clics seguidos no esperan a la animacion
+    const double target = std::clamp(view->targetZoom() * factor, kMinZoom, kMaxZoom);
+    if (target != view->targetZoom()) {
+        view->zoomTo(target, anchor);
     }
 }
+
 void MainWindow::applyZoom()
 {
-    view->resetTransform();
-    view->scale(currentZoom, currentZoom);
+    view->setZoom(currentZoom);
+    zoomChanged();
+}
+
+void MainWindow::zoomChanged()
+{
+    m_recordViewStateDirty = true;
+    for (Tool *tool : {static_cast<Tool*>(m_protractor), static_cast<Tool*>(m_ruler)}) {
+        if (tool) {
+            tool->viewTransformChanged();
+        }
+    }
+}
+
+void MainWindow::setZoom(double zoom)
+{
+    currentZoom = std::clamp(zoom, kMinZoom, kMaxZoom);
+    applyZoom();
 }
 
 void MainWindow::on_actioncolores_triggered()
 {
-    const QColor chosen = QColorDialog::getColor(dibujos.lineColor(),
+    const QColor chosen = QColorDialog::getColor(dibujos->lineColor(),
                                                  this,
                                                  tr("Selecciona un color"));
     if (!chosen.isValid()) {
         return;
     }
 
-    dibujos.setLineColor(chosen);
-    dibujos.setPointColor(chosen);
+    dibujos->setLineColor(chosen);
+    dibujos->setPointColor(chosen);
     m_textColor = chosen;
     applyColorToActiveText(chosen);
 }
@@ -416,8 +582,46 @@ void MainWindow::on_actionpuntos_mapa_toggled(bool checked)
 
 void MainWindow::on_actionreset_triggered()
 {
-    dibujos.reset();
+    // Para deshacer el borrado se guardan las altas de todo lo que habia
+    QVector<BoardOp> restore;
+    if (!m_journalSuspended && !m_applyingHistory) {
+        endEraserStroke();
+        BoardData board;
+        collectBoard(&board);
+        restore.reserve(board.points.size() + board.lines.size() + board.arcs.size() + board.texts.size());
+        for (const BoardLine &line : std::as_const(board.lines)) {
+            BoardOp op;
+            op.type = BoardOp::Type::AddLine;
+            op.line = line;
+            restore.append(op);
+        }
+        for (const BoardArc &arc : std::as_const(board.arcs)) {
+            BoardOp op;
+            op.type = BoardOp::Type::AddArc;
+            op.arc = arc;
+            restore.append(op);
+        }
+        for (const BoardPoint &point : std::as_const(board.points)) {
+            BoardOp op;
+            op.type = BoardOp::Type::AddPoint;
+            op.point = point;
+            restore.append(op);
+        }
+        for (const BoardText &text : std::as_const(board.texts)) {
+            BoardOp op;
+            op.type = BoardOp::Type::AddText;
+            op.text = text;
+            restore.append(op);
+        }
+    }
+
+    dibujos->reset();
     clearTextBoxes();
+    m_dirtyTextBoxes.clear();
+    boardChanged(BoardOp());
+    if (!restore.isEmpty()) {
+        m_undo.record(BoardOp(), restore);
+    }
     markAddTextInactive();
     ui->actionpuntos_mapa->setChecked(false);
     clearPointPopups();
@@ -649,9 +853,9 @@ void MainWindow::setAddTextMode(bool enabled)
             const QSignalBlocker blocker(ui->actiondibujar_curva);
             ui->actiondibujar_curva->setChecked(false);
         }
-        dibujos.setDrawLineMode(false);
-        dibujos.setDrawPointMode(false);
-        dibujos.setDrawArcMode(false);
+        dibujos->setDrawLineMode(false);
+        dibujos->setDrawPointMode(false);
+        dibujos->setDrawArcMode(false);
 
         if (ui->actionborrador->isChecked()) {
             const QSignalBlocker blocker(ui->actionborrador);
@@ -721,7 +925,12 @@ bool MainWindow::eraseTextBoxItem(QGraphicsItem *item)
                     if (m_activeTextBox == proxy) {
                         m_activeTextBox = nullptr;
                     }
+                    BoardOp op;
+                    op.type = BoardOp::Type::EraseText;
+                    op.text = textRecord(m_textBoxes.at(i));
+                    m_dirtyTextBoxes.remove(op.text.id);
                     m_textBoxes.removeAt(i);
+                    boardChanged(op);
 
                     const QSignalBlocker blocker(scene);
                     scene->removeItem(proxy);
@@ -774,6 +983,7 @@ void MainWindow::applyColorToActiveText(const QColor &color)
     }
 
     box->textColor = color;
+    markTextBoxDirty(box->id);
 
     QTextCursor cursor = box->editor->textCursor();
     cursor.select(QTextCursor::Document);
@@ -920,12 +1130,14 @@ QGraphicsProxyWidget *MainWindow::createTextBoxAt(const QPointF &scenePos)
     proxy->setPos(scenePos);
     proxy->resize(container->size());
 
-    m_textBoxes.append(TextBoxWidgets{
+    TextBoxWidgets created{
         proxy,
         container,
         editor,
         m_textColor
-    });
+    };
+    created.id = m_nextTextId++;
+    m_textBoxes.append(created);
 
     {
         QPointer<QGraphicsProxyWidget> proxyPtr(proxy);
@@ -933,13 +1145,29 @@ QGraphicsProxyWidget *MainWindow::createTextBoxAt(const QPointF &scenePos)
             if (!proxyPtr) {
                 return;
             }
-            autoResizeTextBox(findTextBox(proxyPtr));
+            TextBoxWidgets *box = findTextBox(proxyPtr);
+            autoResizeTextBox(box);
+            if (box) {
+                markTextBoxDirty(box->id);
+            }
+        });
+        // Movido o redimensionado
+        connect(proxy, &QGraphicsWidget::geometryChanged, this, [this, proxyPtr]() {
+            if (TextBoxWidgets *box = proxyPtr ? findTextBox(proxyPtr) : nullptr) {
+                markTextBoxDirty(box->id);
+            }
         });
     }
 
     selectTextBox(proxy);
     editor->setFocus();
     autoResizeTextBox(findTextBox(proxy));
+
+    BoardOp op;
+    op.type = BoardOp::Type::AddText;
+    op.text = textRecord(*findTextBox(proxy));
+    m_dirtyTextBoxes.remove(op.text.id);
+    boardChanged(op);
     return proxy;
 }
 
@@ -974,7 +1202,7 @@ void MainWindow::showPointPopups()
 {
     clearPointPopups();
 
-    const auto &points = dibujos.pointCoordinates();
+    const auto &points = dibujos->pointCoordinates();
     for (int i = 0; i < points.size(); ++i) {
         const QPointF &scenePos = points.at(i);
         const double safeZoom = std::max(currentZoom, 0.01);
@@ -1015,6 +1243,20 @@ void MainWindow::showPointPopups()
     }
 }
 
+void MainWindow::updateCrossingReadout(const QPointF &scenePos)
+{
+    IntersectionEngine::Intersection crossing;
+    if (dibujos->crossingNear(scenePos, &crossing)) {
+        statusBar()->showMessage(tr("Corte: %1  %2")
+                                     .arg(dibujos->formatDMS(crossing.geo.lat, true))
+                                     .arg(dibujos->formatDMS(crossing.geo.lon, false)));
+        m_crossingReadoutShown = true;
+    } else if (m_crossingReadoutShown) {
+        statusBar()->clearMessage();
+        m_crossingReadoutShown = false;
+    }
+}
+
 void MainWindow::clearPointPopups()
 {
     for (QGraphicsItem *leader : m_pointPopups) {
@@ -1061,19 +1303,19 @@ void MainWindow::setDrawLineMode(bool enabled)
         ui->actionborrador->setChecked(false);
     }
 
-    dibujos.setDrawLineMode(enabled);
+    dibujos->setDrawLineMode(enabled);
 
-    if (!dibujos.drawPointMode() && ui->actiondibujar_punto->isChecked()) {
+    if (!dibujos->drawPointMode() && ui->actiondibujar_punto->isChecked()) {
         const QSignalBlocker blocker(ui->actiondibujar_punto);
         ui->actiondibujar_punto->setChecked(false);
     }
-    if (!dibujos.drawArcMode() && ui->actiondibujar_curva->isChecked()) {
+    if (!dibujos->drawArcMode() && ui->actiondibujar_curva->isChecked()) {
         const QSignalBlocker blocker(ui->actiondibujar_curva);
         ui->actiondibujar_curva->setChecked(false);
     }
 
     const QSignalBlocker blocker(ui->actiondibujar_linea);
-    ui->actiondibujar_linea->setChecked(dibujos.drawLineMode());
+    ui->actiondibujar_linea->setChecked(dibujos->drawLineMode());
     updateViewCursor();
 }
 
@@ -1086,19 +1328,19 @@ void MainWindow::setDrawPointMode(bool enabled)
         ui->actionborrador->setChecked(false);
     }
 
-    dibujos.setDrawPointMode(enabled);
+    dibujos->setDrawPointMode(enabled);
 
-    if (!dibujos.drawLineMode() && ui->actiondibujar_linea->isChecked()) {
+    if (!dibujos->drawLineMode() && ui->actiondibujar_linea->isChecked()) {
         const QSignalBlocker blocker(ui->actiondibujar_linea);
         ui->actiondibujar_linea->setChecked(false);
     }
-    if (!dibujos.drawArcMode() && ui->actiondibujar_curva->isChecked()) {
+    if (!dibujos->drawArcMode() && ui->actiondibujar_curva->isChecked()) {
         const QSignalBlocker blocker(ui->actiondibujar_curva);
         ui->actiondibujar_curva->setChecked(false);
     }
 
     const QSignalBlocker blocker(ui->actiondibujar_punto);
-    ui->actiondibujar_punto->setChecked(dibujos.drawPointMode());
+    ui->actiondibujar_punto->setChecked(dibujos->drawPointMode());
     updateViewCursor();
 }
 
@@ -1111,19 +1353,19 @@ void MainWindow::setDrawArcMode(bool enabled)
         ui->actionborrador->setChecked(false);
     }
 
-    dibujos.setDrawArcMode(enabled);
+    dibujos->setDrawArcMode(enabled);
 
-    if (!dibujos.drawLineMode() && ui->actiondibujar_linea->isChecked()) {
+    if (!dibujos->drawLineMode() && ui->actiondibujar_linea->isChecked()) {
         const QSignalBlocker blocker(ui->actiondibujar_linea);
         ui->actiondibujar_linea->setChecked(false);
     }
-    if (!dibujos.drawPointMode() && ui->actiondibujar_punto->isChecked()) {
+    if (!dibujos->drawPointMode() && ui->actiondibujar_punto->isChecked()) {
         const QSignalBlocker blocker(ui->actiondibujar_punto);
         ui->actiondibujar_punto->setChecked(false);
     }
 
     const QSignalBlocker blocker(ui->actiondibujar_curva);
-    ui->actiondibujar_curva->setChecked(dibujos.drawArcMode());
+    ui->actiondibujar_curva->setChecked(dibujos->drawArcMode());
     updateViewCursor();
 }
 
@@ -1133,6 +1375,9 @@ void MainWindow::setEraserMode(bool enabled)
         markAddTextInactive();
     }
     m_eraserMode = enabled;
+    if (!enabled) {
+        endEraserStroke();
+    }
     m_leftPanPressed = false;
     m_leftPanInProgress = false;
 
@@ -1152,9 +1397,9 @@ void MainWindow::setEraserMode(bool enabled)
             const QSignalBlocker blocker(ui->actiondibujar_curva);
             ui->actiondibujar_curva->setChecked(false);
         }
-        dibujos.setDrawLineMode(false);
-        dibujos.setDrawPointMode(false);
-        dibujos.setDrawArcMode(false);
+        dibujos->setDrawLineMode(false);
+        dibujos->setDrawPointMode(false);
+        dibujos->setDrawArcMode(false);
 
     }
 
@@ -1194,16 +1439,927 @@ void MainWindow::updateViewCursor()
         return;
     }
 
-    if (dibujos.drawLineMode() || dibujos.drawPointMode() || dibujos.drawArcMode()) {
+    if (dibujos->drawLineMode() || dibujos->drawPointMode() || dibujos->drawArcMode()) {
         view->viewport()->setCursor(Qt::CrossCursor);
         return;
     }
 
     view->viewport()->unsetCursor();
 }
+InteractionMode MainWindow::currentInteractionMode() const
+{
+    if (m_addTextMode) {
+        return InteractionMode::Text;
+    }
+    if (m_eraserMode) {
+        return InteractionMode::Eraser;
+    }
+    if (dibujos->drawLineMode()) {
+        return InteractionMode::Line;
+    }
+    if (dibujos->drawArcMode()) {
+        return InteractionMode::Arc;
+    }
+    if (dibujos->drawPointMode()) {
+        return InteractionMode::Point;
+    }
+    return InteractionMode::Idle;
+}
+
+void MainWindow::noteInputArrival(QObject *obj, QEvent *event)
+{
+    // Teclas dentro de un cuadro de texto (el filtro esta instalado en cada editor)
+    if (event->type() == QEvent::KeyPress) {
+        if (qobject_cast<QTextEdit*>(obj)) {
+            m_latency->inputArrived(InteractionMode::Text);
+        } else if (obj == view) {
+            m_latency->inputArrived(currentInteractionMode());
+        }
+        return;
+    }
+
+    if (obj != view->viewport()) {
+        return;
+    }
+
+    switch (event->type()) {
+    case QEvent::MouseMove:
+        // El movimiento sin botones no cambia nada en pantalla: no habra pintado con el que emparejarlo
+        if (static_cast<QMouseEvent*>(event)->buttons() == Qt::NoButton) {
+            return;
+        }
+        break;
+    case QEvent::MouseButtonPress:
+    case QEvent::MouseButtonRelease:
+    case QEvent::Wheel:
+        break;
+    default:
+        return;
+    }
+
+    m_latency->inputArrived((m_leftPanPressed || m_leftPanInProgress)
+                                ? InteractionMode::Pan
+                                : currentInteractionMode());
+}
+
+void MainWindow::setInteractionMode(InteractionMode mode)
+{
+    if (mode == currentInteractionMode()) {
+        return;
+    }
+
+    // Se pasa por las acciones de la barra para que sus slots mantengan la exclusion entre modos
+    QAction *target = nullptr;
+    switch (mode) {
+    case InteractionMode::Line:
+        target = ui->actiondibujar_linea;
+        break;
+    case InteractionMode::Arc:
+        target = ui->actiondibujar_curva;
+        break;
+    case InteractionMode::Point:
+        target = ui->actiondibujar_punto;
+        break;
+    case InteractionMode::Eraser:
+        target = ui->actionborrador;
+        break;
+    case InteractionMode::Text:
+        target = ui->actionanadir_texto;
+        break;
+    default:
+        break;
+    }
+
+    if (target) {
+        target->setChecked(true);
+        return;
+    }
+    for (QAction *action : {ui->actiondibujar_linea, ui->actiondibujar_curva, ui->actiondibujar_punto,
+                            ui->actionborrador, ui->actionanadir_texto}) {
+        if (action->isChecked()) {
+            action->setChecked(false);
+        }
+    }
+}
+
+void MainWindow::recordInput(QObject *obj, QEvent *event)
+{
+    if (!m_recorder) {
+        return;
+    }
+    // Del viewport se graba el raton y el redimensionado; de la vista, solo el teclado
+    if (obj == view) {
+        if (event->type() != QEvent::KeyPress && event->type() != QEvent::KeyRelease) {
+            return;
+        }
+    } else if (obj != view->viewport()) {
+        return;
+    }
+
+    switch (event->type()) {
+    case QEvent::MouseButtonPress:
+    case QEvent::MouseButtonRelease:
+    case QEvent::MouseButtonDblClick:
+    case QEvent::MouseMove:
+    case QEvent::Wheel:
+    case QEvent::KeyPress:
+    case QEvent::KeyRelease:
+        // Zoom y scroll previos al evento, para que la reproduccion mapee a las mismas coordenadas de escena
+        if (m_recordViewStateDirty) {
+            m_recorder->recordViewState(currentZoom,
+                                        QPoint(view->horizontalScrollBar()->value(),
+                                               view->verticalScrollBar()->value()),
+                                        currentInteractionMode());
+            m_recordViewStateDirty = false;
+        }
+        break;
+    case QEvent::Resize:
+        m_recordViewStateDirty = true;
+        break;
+    default:
+        return;
+    }
+    m_recorder->record(event, currentInteractionMode());
+}
+
+void MainWindow::toggleLatencyHud()
+{
+    m_latency->setHudVisible(!m_latency->hudVisible(), view);
+}
+
+void MainWindow::dumpLatencyJson()
+{
+    QString path = qEnvironmentVariable("PROYECTO_IHM_LATENCY_JSON");
+    if (path.isEmpty()) {
+        path = QDir::temp().filePath(QStringLiteral("proyecto_IHM_latencias.json"));
+    }
+    if (m_latency->writeJson(path)) {
+        statusBar()->showMessage(tr("Latencias guardadas en %1").arg(QDir::toNativeSeparators(path)), 5000);
+    } else {
+        statusBar()->showMessage(tr("No se pudieron guardar las latencias en %1").arg(path), 5000);
+    }
+}
+
+void MainWindow::saveBoard()
+{
+    QString path = QFileDialog::getSaveFileName(this,
+                                                tr("Guardar pizarra"),
+                                                QString(),
+                                                tr("Pizarras (*.pihm)"));
+    if (path.isEmpty()) {
+        return;
+    }
+    if (!path.endsWith(QStringLiteral(".pihm"), Qt::CaseInsensitive)) {
+        path += QStringLiteral(".pihm");
+    }
+
+    BoardData board;
+    collectBoard(&board);
+    QString error;
+    if (!BoardFile::save(path, board, &error)) {
+        QMessageBox::warning(this, tr("Guardar pizarra"),
+                             tr("No se pudo guardar la pizarra:\n%1").arg(error));
+        return;
+    }
+    statusBar()->showMessage(tr("Pizarra guardada en %1").arg(QDir::toNativeSeparators(path)), 5000);
+}
+
+void MainWindow::openBoard()
+{
+    const QString path = QFileDialog::getOpenFileName(this,
+                                                      tr("Abrir pizarra"),
+                                                      QString(),
+                                                      tr("Pizarras (*.pihm);;Todos los archivos (*)"));
+    if (path.isEmpty()) {
+        return;
+    }
+
+    BoardData board;
+    QString error;
+    if (!BoardFile::load(path, &board, &error)) {
+        QMessageBox::warning(this, tr("Abrir pizarra"),
+                             tr("No se pudo abrir la pizarra:\n%1").arg(error));
+        return;
+    }
+    applyBoard(board);
+}
+
+void MainWindow::exportChart()
+{
+    if (!m_chart) {
+        return;
+    }
+    const QString chartPath = m_chart->info().imagePath;
+    const QString pngFilter = tr("Imagen PNG (*.png)");
+    const QString pdfFilter = tr("Documento PDF (*.pdf)");
+    const QString vectorPdfFilter = tr("PDF vectorial (*.pdf)");
+    const QString svgFilter = tr("Dibujo SVG (*.svg)");
+    QString filter;
+    QString path = QFileDialog::getSaveFileName(this,
+                                                tr("Exportar carta"),
+                                                QString(),
+                                                QStringList{pngFilter, pdfFilter, vectorPdfFilter, svgFilter}
+                                                    .join(QStringLiteral(";;")),
+                                                &filter);
+    if (path.isEmpty()) {
+        return;
+    }
+    // La extension escrita manda; si no hay, el filtro elegido
+    if (path.endsWith(QStringLiteral(".png"), Qt::CaseInsensitive)) {
+        filter = pngFilter;
+    } else if (path.endsWith(QStringLiteral(".svg"), Qt::CaseInsensitive)) {
+        filter = svgFilter;
+    } else if (path.endsWith(QStringLiteral(".pdf"), Qt::CaseInsensitive)) {
+        filter = filter == vectorPdfFilter ? vectorPdfFilter : pdfFilter;
+    } else {
+        if (filter.isEmpty()) {
+            filter = pngFilter;
+        }
+        path += filter == svgFilter ? QStringLiteral(".svg")
+                : filter == pngFilter ? QStringLiteral(".png") : QStringLiteral(".pdf");
+    }
+    const bool vector = filter == svgFilter || filter == vectorPdfFilter;
+    const bool pdf = filter == pdfFilter;
+
+    const QStringList regions{tr("Zona visible"), tr("Carta completa")};
+    bool ok = false;
+    const QString region = QInputDialog::getItem(this, tr("Exportar carta"), tr("Zona:"), regions, 0, false, &ok);
+    if (!ok) {
+        return;
+    }
+    const QRectF visibleRegion = region == regions.first()
+            ? view->mapToScene(view->viewport()->rect()).boundingRect() : QRectF();
+
+    if (vector) {
+        flushTextBoxChanges();
+        BoardData board;
+        collectBoard(&board);
+        VectorExport::Options options;
+        options.region = visibleRegion;
+        QString error;
+        const bool exported = filter == svgFilter
+                ? VectorExport::writeSvg(path, chartPath, m_chartRect, board, options, &error)
+                : VectorExport::writePdf(path, chartPath, m_chartRect, board, options, &error);
+        if (!exported) {
+            QMessageBox::warning(this, tr("Exportar carta"),
+                                 tr("No se pudo exportar la carta:\n%1").arg(error));
+            return;
+        }
+        statusBar()->showMessage(tr("Carta exportada en %1").arg(QDir::toNativeSeparators(path)), 5000);
+        return;
+    }
+
+    const int dpi = QInputDialog::getInt(this, tr("Exportar carta"), tr("Resolución (ppp):"),
+                                         150, 50, 600, 50, &ok);
+    if (!ok) {
+        return;
+    }
+
+    flushTextBoxChanges();
+    BoardData board;
+    collectBoard(&board);
+    ChartExporter exporter(chartPath, m_chartRect, board);
+
+    ChartExporter::Options options;
+    options.dpi = dpi;
+    options.format = pdf ? ChartExporter::Format::Pdf : ChartExporter::Format::Png;
+    options.region = visibleRegion;
+
+    QProgressDialog progress(tr("Exportando carta..."), tr("Cancelar"), 0, 1, this);
+    progress.setWindowModality(Qt::WindowModal);
+    progress.setMinimumDuration(300);
+    // Con la ventana modal, setValue atiende los eventos: el boton Cancelar llega durante la exportacion
+    connect(&exporter, &ChartExporter::progress, &progress, [&progress](int done, int total) {
+        progress.setMaximum(total);
+        progress.setValue(done);
+    });
+    connect(&progress, &QProgressDialog::canceled, &exporter, &ChartExporter::cancel);
+
+    QString error;
+    const bool exported = exporter.exportTo(path, options, &error);
+    const bool canceled = progress.wasCanceled();
+    progress.reset();
+    if (!exported) {
+        if (!canceled) {
+            QMessageBox::warning(this, tr("Exportar carta"),
+                                 tr("No se pudo exportar la carta:\n%1").arg(error));
+        }
+        return;
+    }
+    statusBar()->showMessage(tr("Carta exportada en %1").arg(QDir::toNativeSeparators(path)), 5000);
+}
+
+void MainWindow::collectBoard(BoardData *board) const
+{
+    dibujos->exportBoard(board);
+    board->chartId = m_chart ? m_chart->info().id : QString();
+
+    board->texts.clear();
+    board->texts.reserve(m_textBoxes.size());
+    for (const auto &box : m_textBoxes) {
+        if (!box.proxy || !box.container || !box.editor) {
+            continue;
+        }
+        board->texts.append(textRecord(box));
+    }
+
+    board->tools.clear();
+    if (m_ruler) {
+        board->tools.append({BoardToolPose::Tool::Ruler, m_ruler->isVisible(), m_ruler->pos(),
+                             m_ruler->toolRotation(), 0.0});
+    }
+    if (m_protractor) {
+        board->tools.append({BoardToolPose::Tool::Protractor, m_protractor->isVisible(), m_protractor->pos(),
+                             m_protractor->toolRotation(), 0.0});
+    }
+    if (m_compass) {
+        board->tools.append({BoardToolPose::Tool::Compass, m_compass->isVisible(), m_compass->pos(),
+                             m_compass->rotationDeg(), m_compass->openingDeg()});
+    }
+}
+
+void MainWindow::applyBoard(const BoardData &board)
+{
+    // Lo dibujado esta en coordenadas de su carta: se abre antes de restaurarlo. Las pizarras
+    // anteriores a la v3 no la guardan y son de la carta por defecto.
+    ChartCatalogue &catalogue = ChartCatalogue::instance();
+    const QString chartId = board.chartId.isEmpty() ? catalogue.defaultId() : board.chartId;
+    if (!chartId.isEmpty() && (!m_chart || m_chart->info().id != chartId)) {
+        std::shared_ptr<ChartTiles> chart = catalogue.open(chartId);
+        if (chart && !chart->isNull()) {
+            m_chart = std::move(chart);
+            applyChart();
+            view->centerOn(m_chartRect.center());
+        } else {
+            statusBar()->showMessage(tr("La carta «%1» de la pizarra no está en el catálogo").arg(chartId), 5000);
+        }
+    }
+
+    // La pizarra entera va al diario como instantanea al terminar, no cambio a cambio
+    m_journalSuspended = true;
+    on_actionreset_triggered();
+    dibujos->importBoard(board);
+
+    for (const BoardText &text : board.texts) {
+        restoreTextBox(text);
+    }
+    selectTextBox(nullptr);
+
+    for (const BoardToolPose &pose : board.tools) {
+        switch (pose.tool) {
+        case BoardToolPose::Tool::Ruler:
+            ui->actionregla->setChecked(pose.visible);
+            if (m_ruler) {
+                m_ruler->setPos(pose.pos);
+                m_ruler->setToolRotation(pose.rotationDeg);
+            }
+            break;
+        case BoardToolPose::Tool::Protractor:
+            ui->actiontransportador->setChecked(pose.visible);
+            if (m_protractor) {
+                m_protractor->setPos(pose.pos);
+                m_protractor->setToolRotation(pose.rotationDeg);
+            }
+            break;
+        case BoardToolPose::Tool::Compass:
+            ui->actioncompas->setChecked(pose.visible);
+            if (m_compass) {
+                m_compass->setPos(pose.pos);
+                m_compass->setPose(pose.rotationDeg, pose.openingDeg);
+            }
+            break;
+        }
+    }
+
+    m_dirtyTextBoxes.clear();
+    m_journalSuspended = false;
+
+    // El historial anterior se refiere a otra pizarra
+    endEraserStroke();
+    m_undo.clear();
+    BoardData current;
+    collectBoard(&current);
+    m_textState.clear();
+    for (const BoardText &text : std::as_const(current.texts)) {
+        m_textState.insert(text.id, text);
+    }
+    if (m_journal) {
+        m_journal->snapshot(current);
+    }
+}
+
+QGraphicsProxyWidget *MainWindow::restoreTextBox(const BoardText &text)
+{
+    QGraphicsProxyWidget *proxy = createTextBoxAt(text.pos);
+    TextBoxWidgets *box = findTextBox(proxy);
+    if (!box) {
+        return proxy;
+    }
+
+    if (text.id != 0) {
+        box->id = text.id;
+        m_nextTextId = std::max(m_nextTextId, text.id + 1);
+    }
+    applyTextRecord(box, text);
+    return proxy;
+}
+
+void MainWindow::applyTextRecord(TextBoxWidgets *box, const BoardText &text)
+{
+    box->textColor = QColor::fromRgba(text.color);
+    if (box->editor->toPlainText() != text.text) {
+        box->editor->setPlainText(text.text);
+    }
+
+    QTextCursor cursor(box->editor->document());
+    cursor.select(QTextCursor::Document);
+    QTextCharFormat fmt;
+    fmt.setForeground(box->textColor);
+    fmt.setFontPointSize(text.fontSize);
+    cursor.mergeCharFormat(fmt);
+    box->editor->mergeCurrentCharFormat(fmt);
+
+    box->proxy->setPos(text.pos);
+    const QSize size = text.size.toSize();
+    if (size.isValid()) {
+        box->container->resize(size.expandedTo(box->container->minimumSize()));
+        box->proxy->resize(box->container->size());
+    }
+}
+
+MainWindow::TextBoxWidgets *MainWindow::findTextBoxById(quint32 id)
+{
+    for (auto &box : m_textBoxes) {
+        if (box.id == id) {
+            return &box;
+        }
+    }
+    return nullptr;
+}
+
+BoardText MainWindow::textRecord(const TextBoxWidgets &box) const
+{
+    BoardText text;
+    text.id = box.id;
+    if (box.proxy) {
+        text.pos = box.proxy->pos();
+    }
+    if (box.container) {
+        text.size = box.container->size();
+    }
+    text.color = box.textColor.rgba();
+    if (box.editor) {
+        // Tamano del primer fragmento del documento: fontPointSize() es el del cursor del editor,
+        // que no cambia al redimensionar la caja si el editor no tiene el foco
+        const QTextDocument *document = box.editor->document();
+        const QTextBlock::iterator first = document->begin().begin();
+        double fontSize = first.atEnd() ? 0.0 : first.fragment().charFormat().fontPointSize();
+        if (fontSize <= 0.0) {
+            fontSize = document->defaultFont().pointSizeF();
+        }
+        text.fontSize = static_cast<float>(fontSize > 0.0 ? fontSize : 64.0);
+        text.text = box.editor->toPlainText();
+    }
+    return text;
+}
+
+void MainWindow::startAutosave(const QString &directory)
+{
+    if (!m_autosaveDir.isEmpty() || directory.isEmpty()) {
+        return;
+    }
+
+    // Una carpeta por pizarra; se recuperan todas en el orden en que se crearon
+    QVector<quint32> ids;
+    const QStringList entries = QDir(directory).entryList({QStringLiteral("board-*")},
+                                                          QDir::Dirs | QDir::NoDotAndDotDot);
+    for (const QString &entry : entries) {
+        bool ok = false;
+        const quint32 id = entry.mid(6).toUInt(&ok);
+        if (ok && id > 0) {
+            ids.append(id);
+        }
+    }
+    std::sort(ids.begin(), ids.end());
+
+    // m_autosaveDir sigue vacio durante la recuperacion para que addBoard no abra diarios nuevos
+    bool first = true;
+    for (quint32 id : std::as_const(ids)) {
+        const QString boardDir = journalDirectory(directory, id);
+        auto journal = std::make_unique<BoardJournal>(boardDir);
+        BoardData recovered;
+        if (!journal->recover(&recovered)) {
+            journal.reset();
+            QDir(boardDir).removeRecursively();
+            continue;
+        }
+        if (first) {
+            m_boardId = id;
+            m_boardsCreated = std::max(m_boardsCreated, id);
+            m_boardTabs->setTabText(m_activeBoard, tr("Pizarra %1").arg(id));
+            first = false;
+        } else {
+            addBoard(id);
+        }
+        // El diario se arranca despues: applyBoard no debe escribir en el de otra pizarra
+        applyBoard(recovered);
+        m_journal = journal.release();
+        BoardData current;
+        collectBoard(&current);
+        m_journal->start(current);
+    }
+
+    m_autosaveDir = directory;
+    startBoardJournal();
+}
+
+QString MainWindow::journalDirectory(const QString &autosaveDir, quint32 boardId)
+{
+    return QDir(autosaveDir).filePath(QStringLiteral("board-%1").arg(boardId));
+}
+
+void MainWindow::startBoardJournal()
+{
+    if (m_journal || m_autosaveDir.isEmpty()) {
+        return;
+    }
+    m_journal = new BoardJournal(journalDirectory(m_autosaveDir, m_boardId));
+    BoardData current;
+    collectBoard(&current);
+    m_journal->start(current);
+}
+
+void MainWindow::boardChanged(const BoardOp &op)
+{
+    if (m_journalSuspended) {
+        return;
+    }
+    if (!m_applyingHistory) {
+        recordUndo(op);
+    }
+    switch (op.type) {
+    case BoardOp::Type::AddText:
+    case BoardOp::Type::UpdateText:
+        m_textState.insert(op.text.id, op.text);
+        break;
+    case BoardOp::Type::EraseText:
+        m_textState.remove(op.text.id);
+        break;
+    case BoardOp::Type::Clear:
+        m_textState.clear();
+        break;
+    default:
+        break;
+    }
+
+    if (!m_journal) {
+        return;
+    }
+    m_journal->append(op);
+    if (m_journal->wantsSnapshot()) {
+        BoardData current;
+        collectBoard(&current);
+        m_journal->snapshot(current);
+    }
+}
+
+void MainWindow::recordUndo(const BoardOp &op)
+{
+    switch (op.type) {
+    case BoardOp::Type::Clear:
+        break; // lo registra on_actionreset_triggered, que conoce lo borrado
+    case BoardOp::Type::UpdateText: {
+        const auto it = m_textState.constFind(op.text.id);
+        if (it == m_textState.constEnd()) {
+            break;
+        }
+        const BoardText &before = it.value();
+        if (before.pos == op.text.pos && before.size == op.text.size && before.color == op.text.color
+            && before.fontSize == op.text.fontSize && before.text == op.text.text) {
+            break;
+        }
+        BoardOp inverse = op;
+        inverse.text = before;
+        m_undo.record(op, {inverse});
+        break;
+    }
+    default:
+        m_undo.record(op, {UndoStack::inverseOf(op)});
+        break;
+    }
+}
+
+void MainWindow::undoBoard()
+{
+    // Una edicion de texto pendiente es el ultimo paso y se deshace primero
+    flushTextBoxChanges();
+    endEraserStroke();
+    applyHistory(m_undo.undo());
+}
+
+void MainWindow::redoBoard()
+{
+    flushTextBoxChanges();
+    endEraserStroke();
+    applyHistory(m_undo.redo());
+}
+
+void MainWindow::applyHistory(const QVector<BoardOp> &ops)
+{
+    if (ops.isEmpty()) {
+        return;
+    }
+    m_applyingHistory = true;
+    for (const BoardOp &op : ops) {
+        applyBoardOp(op);
+    }
+    m_applyingHistory = false;
+    refreshPointPopups();
+}
+
+void MainWindow::applyBoardOp(const BoardOp &op)
+{
+    // Los cambios aplicados pasan por boardChanged para que tambien lleguen al diario
+    switch (op.type) {
+    case BoardOp::Type::AddText:
+        if (findTextBoxById(op.text.id)) {
+            return;
+        }
+        m_journalSuspended = true;
+        restoreTextBox(op.text);
+        selectTextBox(nullptr);
+        m_journalSuspended = false;
+        boardChanged(op);
+        break;
+    case BoardOp::Type::UpdateText:
+        if (TextBoxWidgets *box = findTextBoxById(op.text.id)) {
+            m_journalSuspended = true;
+            applyTextRecord(box, op.text);
+            m_journalSuspended = false;
+            m_dirtyTextBoxes.remove(op.text.id);
+            boardChanged(op);
+        }
+        break;
+    case BoardOp::Type::EraseText:
+        if (TextBoxWidgets *box = findTextBoxById(op.text.id)) {
+            eraseTextBoxItem(box->proxy);
+        }
+        break;
+    case BoardOp::Type::Clear:
+        on_actionreset_triggered();
+        break;
+    default:
+        if (dibujos->applyOp(op)) {
+            boardChanged(op);
+        }
+        break;
+    }
+}
+
+void MainWindow::endEraserStroke()
+{
+    if (m_eraserStroke) {
+        m_eraserStroke = false;
+        m_undo.endGroup();
+    }
+}
+
+std::unique_ptr<Dibujos> MainWindow::createDibujos(QGraphicsScene *boardScene)
+{
+    auto created = std::make_unique<Dibujos>(boardScene, view);
+    if (m_chart) {
+        created->setGeoReference(m_chart->info().geoReference());
+    }
+    // Solo la pizarra activa recibe eventos, asi que sus cambios van al historial y al diario actuales
+    created->setChangeListener([this](const BoardOp &op) { boardChanged(op); });
+    return created;
+}
+
+void MainWindow::addBoard(quint32 boardId)
+{
+    if (boardId == 0) {
+        boardId = ++m_boardsCreated;
+    } else {
+        m_boardsCreated = std::max(m_boardsCreated, boardId);
+    }
+
+    BoardTab tab;
+    tab.boardId = boardId;
+    tab.scene = new QGraphicsScene(this);
+    tab.scene->setSceneRect(m_chartRect);
+    tab.chart = m_chart;
+    connect(tab.scene, &QGraphicsScene::selectionChanged,
+            this, &MainWindow::onSceneSelectionChanged);
+    tab.dibujos = createDibujos(tab.scene);
+    tab.viewCenter = view->mapToScene(view->viewport()->rect().center());
+    m_boards.push_back(std::move(tab));
+
+    const int index = m_boardTabs->addTab(tr("Pizarra %1").arg(boardId));
+    m_boardTabs->setTabsClosable(true);
+    m_boardTabs->setCurrentIndex(index);
+}
+
+void MainWindow::closeBoard(int index)
+{
+    if (m_boards.size() <= 1 || index < 0 || index >= static_cast<int>(m_boards.size())) {
+        return;
+    }
+    const QMessageBox::StandardButton answer = QMessageBox::question(
+        this, tr("Cerrar pizarra"),
+        tr("¿Cerrar «%1»? Lo dibujado en ella se perderá.").arg(m_boardTabs->tabText(index)));
+    if (answer != QMessageBox::Yes) {
+        return;
+    }
+
+    if (index == m_activeBoard) {
+        m_boardTabs->setCurrentIndex(index > 0 ? index - 1 : 1);
+    }
+    // La escena se lleva los items (textos y herramientas incluidos)
+    BoardTab &tab = m_boards[index];
+    if (tab.journal) {
+        // Cerrar es descartar: su diario no debe volver en la siguiente recuperacion
+        delete tab.journal;
+        QDir(journalDirectory(m_autosaveDir, tab.boardId)).removeRecursively();
+    }
+    tab.dibujos.reset();
+    delete tab.scene;
+    m_boards.erase(m_boards.begin() + index);
+    if (index < m_activeBoard) {
+        --m_activeBoard;
+    }
+    {
+        const QSignalBlocker blocker(m_boardTabs);
+        m_boardTabs->removeTab(index);
+    }
+    m_boardTabs->setTabsClosable(m_boards.size() > 1);
+}
+
+void MainWindow::switchBoard(int index)
+{
+    if (index == m_activeBoard || index < 0 || index >= static_cast<int>(m_boards.size())) {
+        return;
+    }
+
+    // Nada a medias en la pizarra que se deja
+    flushTextBoxChanges();
+    endEraserStroke();
+    setDrawLineMode(false);
+    setDrawPointMode(false);
+    setDrawArcMode(false);
+    markAddTextInactive();
+    selectTextBox(nullptr);
+    clearPointPopups();
+    m_leftPanPressed = false;
+    m_leftPanInProgress = false;
+    view->endPan();
+    updateViewCursor();
+
+    BoardTab &previous = m_boards[m_activeBoard];
+    previous.viewCenter = view->mapToScene(view->viewport()->rect().center());
+    swapBoardState(previous);
+    BoardTab &next = m_boards[index];
+    swapBoardState(next);
+    m_activeBoard = index;
+
+    view->setScene(scene);
+    if (view->chart() != m_chart) {
+        applyChart();
+    }
+    view->centerOn(next.viewCenter);
+
+    const auto syncToolAction = [](QAction *action, const QGraphicsItem *tool) {
+        const QSignalBlocker blocker(action);
+        action->setChecked(tool && tool->isVisible());
+    };
+    syncToolAction(ui->actionregla, m_ruler);
+    syncToolAction(ui->actiontransportador, m_protractor);
+    syncToolAction(ui->actioncompas, m_compass);
+    if (ui->actionpuntos_mapa->isChecked()) {
+        showPointPopups();
+    }
+    updateViewCursor();
+
+    // Una pizarra nueva empieza su diario al mostrarse por primera vez
+    startBoardJournal();
+}
+
+void MainWindow::swapBoardState(BoardTab &tab)
+{
+    std::swap(scene, tab.scene);
+    std::swap(dibujos, tab.dibujos);
+    std::swap(m_textBoxes, tab.textBoxes);
+    std::swap(m_ruler, tab.ruler);
+    std::swap(m_protractor, tab.protractor);
+    std::swap(m_compass, tab.compass);
+    std::swap(m_undo, tab.undo);
+    std::swap(m_textState, tab.textState);
+    std::swap(m_nextTextId, tab.nextTextId);
+    std::swap(m_chart, tab.chart);
+    std::swap(m_boardId, tab.boardId);
+    std::swap(m_journal, tab.journal);
+}
+
+void MainWindow::applyChart()
+{
+    view->setChart(m_chart);
+    m_chartRect = view->chartRect();
+    scene->setSceneRect(m_chartRect);
+    if (m_chart) {
+        dibujos->setGeoReference(m_chart->info().geoReference());
+        // La regla y el transportador apuntan a esa misma georreferencia: rehacer su lectura
+        for (Tool *tool : {static_cast<Tool*>(m_protractor), static_cast<Tool*>(m_ruler)}) {
+            if (tool) {
+                tool->viewTransformChanged();
+            }
+        }
+    }
+}
+
+void MainWindow::chooseChart()
+{
+    ChartCatalogue &catalogue = ChartCatalogue::instance();
+    const QVector<ChartInfo> &charts = catalogue.charts();
+    if (charts.isEmpty()) {
+        return;
+    }
+    QStringList names;
+    int current = 0;
+    for (int i = 0; i < charts.size(); ++i) {
+        names.append(charts[i].name);
+        if (m_chart && charts[i].id == m_chart->info().id) {
+            current = i;
+        }
+    }
+    bool ok = false;
+    const QString name = QInputDialog::getItem(this, tr("Cambiar carta"), tr("Carta:"), names, current, false, &ok);
+    const int index = names.indexOf(name);
+    if (!ok || index < 0 || (m_chart && charts[index].id == m_chart->info().id)) {
+        return;
+    }
+
+    std::shared_ptr<ChartTiles> chart = catalogue.open(charts[index].id);
+    if (!chart || chart->isNull()) {
+        QMessageBox::warning(this, tr("Cambiar carta"),
+                             tr("No se pudo abrir la carta «%1».").arg(charts[index].name));
+        return;
+    }
+
+    // Lo dibujado esta en coordenadas de la carta actual: si hay algo, la nueva va en otra pizarra
+    flushTextBoxChanges();
+    BoardData board;
+    collectBoard(&board);
+    if (!board.points.isEmpty() || !board.lines.isEmpty() || !board.arcs.isEmpty() || !board.texts.isEmpty()) {
+        addBoard();
+    }
+    m_chart = std::move(chart);
+    applyChart();
+    view->centerOn(m_chartRect.center());
+    // Rehacer traeria trazos de la carta anterior
+    m_undo.clear();
+    m_textState.clear();
+    if (m_journal) {
+        BoardData current;
+        collectBoard(&current);
+        m_journal->snapshot(current);
+    }
+}
+
+void MainWindow::markTextBoxDirty(quint32 id)
+{
+    if (m_journalSuspended || id == 0) {
+        return;
+    }
+    m_dirtyTextBoxes.insert(id);
+    m_textChangeTimer->start();
+}
+
+void MainWindow::flushTextBoxChanges()
+{
+    if (m_dirtyTextBoxes.isEmpty()) {
+        return;
+    }
+    m_textChangeTimer->stop();
+    const QSet<quint32> dirty = std::exchange(m_dirtyTextBoxes, {});
+    for (const auto &box : m_textBoxes) {
+        if (dirty.contains(box.id)) {
+            BoardOp op;
+            op.type = BoardOp::Type::UpdateText;
+            op.text = textRecord(box);
+            boardChanged(op);
+        }
+    }
+}
+
 bool MainWindow::eventFilter(QObject *obj, QEvent *event)
 {
-    const int previousPointCount = dibujos.pointCoordinates().size();
+    noteInputArrival(obj, event);
+    recordInput(obj, event);
+
+    if (obj == view) {
+        return QMainWindow::eventFilter(obj, event);
+    }
+
+    const int previousPointCount = dibujos->pointCoordinates().size();
 
     if (obj == view->viewport()) {
         if (event->type() == QEvent::Wheel) {
@@ -1213,46 +2369,7 @@ bool MainWindow::eventFilter(QObject *obj, QEvent *event)
                 const double safeZoom = std::max(currentZoom, 0.01);
                 const double padding = 18.0 / safeZoom;
 
-                bool overCompass = false;
-                const QList<QGraphicsItem*> hitItems = scene->items(
-                    scenePos,
-                    Qt::IntersectsItemShape,
-                    Qt::DescendingOrder,
-                    view->transform());
-                for (QGraphicsItem *item : hitItems) {
-                    for (QGraphicsItem *it = item; it; it = it->parentItem()) {
-                        if (it == m_compass) {
-                            overCompass = true;
-                            break;
-                        }
-                    }
-                    if (overCompass) {
-                        break;
-                    }
-                }
-
-                if (!overCompass) {
-                    const QRectF area(scenePos.x() - padding,
-                                      scenePos.y() - padding,
-                                      padding * 2.0,
-                                      padding * 2.0);
-                    const QList<QGraphicsItem*> nearItems = scene->items(
-                        area,
-                        Qt::IntersectsItemShape,
-                        Qt::DescendingOrder,
-                        view->transform());
-                    for (QGraphicsItem *item : nearItems) {
-                        for (QGraphicsItem *it = item; it; it = it->parentItem()) {
-                            if (it == m_compass) {
-                                overCompass = true;
-                                break;
-                            }
-                        }
-                        if (overCompass) {
-                            break;
-                        }
-                    }
-                }
+                const bool overCompass = m_compass->hitTest(scenePos, padding);
 
                 if (overCompass) {
                     double steps = 0.0;
@@ -1269,17 +2386,37 @@ bool MainWindow::eventFilter(QObject *obj, QEvent *event)
             }
         }
 
-        if (event->type() == QEvent::Leave || event->type() == QEvent::FocusOut) {
-            if (m_leftPanPressed || m_leftPanInProgress) {
-                m_leftPanPressed = false;
-                m_leftPanInProgress = false;
-                updateViewCursor();
+        // Ctrl + rueda: zoom animado bajo el cursor
+        if (event->type() == QEvent::Wheel) {
+            auto *e = static_cast<QWheelEvent*>(event);
+            if (e->modifiers() & Qt::ControlModifier) {
+                double steps = 0.0;
+                if (!e->angleDelta().isNull()) {
+                    steps = static_cast<double>(e->angleDelta().y()) / 120.0;
+                } else if (!e->pixelDelta().isNull()) {
+                    steps = static_cast<double>(e->pixelDelta().y()) / 15.0;
+                }
+                if (!qFuzzyIsNull(steps)) {
+                    zoomBy(std::pow(1.2, steps), e->position().toPoint());
+                }
+                e->accept();
+                return true;
             }
         }
 
+        if (event->type() == QEvent::Leave || event->type() == QEvent::FocusOut) {
+            // Salir con el boton suelto tambien corta un deslizamiento que seguia en marcha
+            m_leftPanPressed = false;
+            m_leftPanInProgress = false;
+            view->endPan();
+            updateViewCursor();
+        }
+
         if (event->type() == QEvent::MouseButtonPress) {
             auto *e = static_cast<QMouseEvent*>(event);
             if (e->button() == Qt::LeftButton) {
+                // Pulsar para la carta si aun se deslizaba
+                view->endPan();
                 const QPointF scenePos = view->mapToScene(e->pos());
                 const QList<QGraphicsItem*> hitItems = scene->items(
                     scenePos,
@@ -1322,6 +2459,9 @@ bool MainWindow::eventFilter(QObject *obj, QEvent *event)
             }
         } else if (event->type() == QEvent::MouseMove) {
             auto *e = static_cast<QMouseEvent*>(event);
+            if (e->buttons() == Qt::NoButton) {
+                updateCrossingReadout(view->mapToScene(e->pos()));
+            }
             if (m_leftPanPressed && (e->buttons() & Qt::LeftButton)) {
                 if (!m_leftPanInProgress) {
                     const QPoint deltaFromStart = e->pos() - m_leftPanStartPos;
@@ -1332,15 +2472,14 @@ bool MainWindow::eventFilter(QObject *obj, QEvent *event)
                 }
 
                 if (m_leftPanInProgress) {
-                    const QPoint delta = e->pos() - m_leftPanLastPos;
-                    view->horizontalScrollBar()->setValue(view->horizontalScrollBar()->value() - delta.x());
-                    view->verticalScrollBar()->setValue(view->verticalScrollBar()->value() - delta.y());
+                    view->panBy(e->pos() - m_leftPanLastPos, e->timestamp());
                     m_leftPanLastPos = e->pos();
                     return true;
                 }
             } else if (m_leftPanPressed || m_leftPanInProgress) {
                 m_leftPanPressed = false;
                 m_leftPanInProgress = false;
+                view->endPan();
                 updateViewCursor();
             }
         } else if (event->type() == QEvent::MouseButtonRelease) {
@@ -1349,6 +2488,11 @@ bool MainWindow::eventFilter(QObject *obj, QEvent *event)
                 const bool wasPanning = m_leftPanInProgress;
                 m_leftPanPressed = false;
                 m_leftPanInProgress = false;
+                if (wasPanning) {
+                    view->releasePan(e->timestamp());
+                } else {
+                    view->endPan();
+                }
                 updateViewCursor();
                 if (wasPanning) {
                     return true;
@@ -1415,6 +2559,13 @@ bool MainWindow::eventFilter(QObject *obj, QEvent *event)
             const bool rightDrag  =
                 (event->type() == QEvent::MouseMove && (e->buttons() & Qt::RightButton));
 
+            if (rightPress && !m_eraserStroke) {
+                m_eraserStroke = true;
+                m_undo.beginGroup();
+            } else if (event->type() == QEvent::MouseButtonRelease && e->button() == Qt::RightButton) {
+                endEraserStroke();
+            }
+
             if (rightPress || rightDrag) {
                 const QPointF scenePos = view->mapToScene(e->pos());
                 const QList<QGraphicsItem*> hitItems = scene->items(
@@ -1427,15 +2578,15 @@ bool MainWindow::eventFilter(QObject *obj, QEvent *event)
                     if (eraseTextBoxItem(hitItem)) {
                         return true;
                     }
-                    if (dibujos.eraseArcItem(hitItem, scenePos)) {
+                    if (dibujos->eraseArcItem(hitItem, scenePos)) {
                         refreshPointPopups();
                         return true;
                     }
-                    if (dibujos.eraseLineItem(hitItem)) {
+                    if (dibujos->eraseLineItem(hitItem)) {
                         refreshPointPopups();
                         return true;
                     }
-                    if (dibujos.erasePointItem(hitItem)) {
+                    if (dibujos->erasePointItem(hitItem)) {
                         refreshPointPopups();
                         return true;
                     }
@@ -1522,10 +2673,10 @@ bool MainWindow::eventFilter(QObject *obj, QEvent *event)
         }
     }
 
-    const bool handled = dibujos.handleEvent(obj, event);
+    const bool handled = dibujos->handleEvent(obj, event);
 
     if (ui->actionpuntos_mapa->isChecked() &&
-            dibujos.pointCoordinates().size() != previousPointCount) {
+            dibujos->pointCoordinates().size() != previousPointCount) {
         showPointPopups();
     }
 
@@ -1540,15 +2691,15 @@ void MainWindow::keyPressEvent(QKeyEvent *event)
 {
     if (event->key() == Qt::Key_Escape) {
         bool handled = false;
-        if (dibujos.drawLineMode()) {
+        if (dibujos->drawLineMode()) {
             setDrawLineMode(false);
             handled = true;
         }
-        if (dibujos.drawPointMode()) {
+        if (dibujos->drawPointMode()) {
             setDrawPointMode(false);
             handled = true;
         }
-        if (dibujos.drawArcMode()) {
+        if (dibujos->drawArcMode()) {
             setDrawArcMode(false);
             handled = true;
         }
@@ -1574,6 +2725,7 @@ void MainWindow::keyPressEvent(QKeyEvent *event)
 void MainWindow::setProtractorVisible(bool visible)
 {
     static const QSizeF kProtractorSize(580.0, 380.0);
+    const bool created = !m_protractor;
     Tool::toggleTool(m_protractor,
                      scene,
                      view,
@@ -1581,10 +2733,19 @@ void MainWindow::setProtractorVisible(bool visible)
                      kProtractorSize,
                      QPoint(20, 20),
                      visible);
+
+    if (created && m_protractor) {
+        m_protractor->setLineFinder([this](const QPointF &scenePos, double radius, QLineF *line) {
+            return dibujos->nearestLine(scenePos, radius, line);
+        });
+        // El transportador vive en la escena de la pizarra activa, igual que su Dibujos
+        m_protractor->setGeoReference(&dibujos->geoReference());
+    }
 }
 void MainWindow::setRulerVisible(bool visible)
 {
     static const QSizeF kRulerSize(600.0, 100.0);
+    const bool created = !m_ruler;
     Tool::toggleTool(m_ruler,
                      scene,
                      view,
@@ -1592,10 +2753,15 @@ void MainWindow::setRulerVisible(bool visible)
                      kRulerSize,
                      QPoint(20, 150),
                      visible);
+
+    if (created && m_ruler) {
+        m_ruler->setGeoReference(&dibujos->geoReference());
+    }
 }
 void MainWindow::setCompassVisible(bool visible)
 {
     static const QSizeF kCompassSize(220.0, 360.0);
+    const bool created = !m_compass;
     CompassTool::toggleTool(m_compass,
                             scene,
                             view,
@@ -1603,6 +2769,16 @@ void MainWindow::setCompassVisible(bool visible)
                             kCompassSize,
                             QPoint(20, 280),
                             visible);
+
+    if (created && m_compass) {
+        connect(m_compass, &CompassTool::arcScribing, this, [this](const ArcPrimitive &arc) {
+            dibujos->setScribePreview(arc);
+        });
+        connect(m_compass, &CompassTool::arcScribed, this, [this](const ArcPrimitive &arc) {
+            dibujos->clearScribePreview();
+            dibujos->addArc(arc);
+        });
+    }
 }
 
 void MainWindow::on_actioncerrar_sesion_triggered()
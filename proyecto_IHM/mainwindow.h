@@ -9,10 +9,16 @@
 #include <QSize>
 #include <QRectF>
 #include <QPair>
+#include <QSet>
+#include <QHash>
 #include "useragent.h"
 #include "profiledialog.h"
 #include "tool.h"
 #include "dibujos.h"
+#include "interactionmode.h"
+#include "undostack.h"
+#include <memory>
+#include <vector>
 
 QT_BEGIN_NAMESPACE
 namespace Ui {
@@ -30,6 +36,15 @@ class QWidget;
 class QToolButton;
 class QAction;
 class CompassTool;
+class RulerTool;
+class ProtractorTool;
+class ChartView;
+class LatencyMonitor;
+class InputRecorder;
+class BoardJournal;
+class QTimer;
+class QTabBar;
+class ChartTiles;
 
 class MainWindow : public QMainWindow
 {
@@ -39,6 +54,14 @@ public:
     MainWindow(QWidget *parent = nullptr);
     ~MainWindow();
 
+    // Usados por proyecto_IHM_replay para reproducir un registro de entrada
+    void setInteractionMode(InteractionMode mode);
+    void setZoom(double zoom);
+    void suppressStartupLoginPrompt() { m_startupLoginPromptShown = true; }
+
+    // Recupera la ultima pizarra del diario de directory y empieza a registrar los cambios
+    void startAutosave(const QString &directory);
+
 private slots:
 
     // Zoom
@@ -71,11 +94,16 @@ private slots:
 private:
     Ui::MainWindow *ui;
     QGraphicsScene *scene;
-    QGraphicsView *view;
+    ChartView *view;
     QRectF m_chartRect;
-    Dibujos dibujos;
+    std::shared_ptr<ChartTiles> m_chart;    // la de la pizarra activa
+    std::unique_ptr<Dibujos> dibujos;    // el de la pizarra activa
     UserAgent userAgent;
     void applyZoom();
+    // Zoom animado (botones y Ctrl + rueda) hacia destino * factor, con anchor quieto en pantalla
+    void zoomBy(double factor, const QPoint &anchor);
+    QPoint zoomAnchor() const;
+    void zoomChanged();
     void updateUserActionIcon();
     double currentZoom = 0.2;
     static constexpr double kMinZoom = 0.09;
@@ -85,8 +113,8 @@ private:
     bool m_eraserMode = false;
 
     // Display de herramientas
-    Tool* m_protractor = nullptr;
-    Tool* m_ruler = nullptr;
+    ProtractorTool* m_protractor = nullptr;
+    RulerTool* m_ruler = nullptr;
     CompassTool* m_compass = nullptr;
     QToolButton *m_logoutButton = nullptr;
     QAction *m_logoutSpacerAction = nullptr;
@@ -113,6 +141,7 @@ private:
         double resizeStartFontSize = 16.0;
         QPointF dragStartScenePos;
         QPointF dragStartProxyPos;
+        quint32 id = 0;
     };
     QVector<TextBoxWidgets> m_textBoxes;
     QGraphicsProxyWidget *m_activeTextBox = nullptr;
@@ -125,6 +154,9 @@ private:
     bool m_leftPanInProgress = false;
     QPoint m_leftPanStartPos;
     QPoint m_leftPanLastPos;
+    // Latitud y longitud del corte bajo el cursor en la barra de estado
+    void updateCrossingReadout(const QPointF &scenePos);
+    bool m_crossingReadoutShown = false;
     TextBoxWidgets *findTextBox(QGraphicsProxyWidget *proxy);
     TextBoxWidgets *findTextBox(QWidget *container);
     bool eraseTextBoxItem(QGraphicsItem *item);
@@ -140,6 +172,92 @@ private:
     bool m_startupLoginPromptShown = false;
     bool attemptLogin(const QString &username, const QString &password);
 
+    // Latencia entrada -> pantalla (F12 muestra el HUD, Mayus+F12 guarda el JSON)
+    InteractionMode currentInteractionMode() const;
+    void noteInputArrival(QObject *obj, QEvent *event);
+    void toggleLatencyHud();
+    void dumpLatencyJson();
+    LatencyMonitor *m_latency = nullptr;
+
+    // Grabacion de la entrada del viewport (PROYECTO_IHM_RECORD=ruta)
+    void recordInput(QObject *obj, QEvent *event);
+    InputRecorder *m_recorder = nullptr;
+    bool m_recordViewStateDirty = true;
+
+    // Guardar y abrir pizarras (Ctrl+S / Ctrl+O)
+    void saveBoard();
+    void openBoard();
+    // Exportar la carta con lo dibujado a PNG/PDF por teselas o a SVG/PDF vectorial (Ctrl+E)
+    void exportChart();
+    // Carta de la pizarra activa, elegida del catalogo (Ctrl+Mayus+C)
+    void chooseChart();
+    void applyChart();
+    void collectBoard(BoardData *board) const;
+    void applyBoard(const BoardData &board);
+    QGraphicsProxyWidget *restoreTextBox(const BoardText &text);
+    void applyTextRecord(TextBoxWidgets *box, const BoardText &text);
+    BoardText textRecord(const TextBoxWidgets &box) const;
+    TextBoxWidgets *findTextBoxById(quint32 id);
+
+    // Cambios de la pizarra hacia el diario. Las ediciones de texto se agrupan y se envian
+    // como UpdateText cuando el cuadro deja de cambiar.
+    void boardChanged(const BoardOp &op);
+    void markTextBoxDirty(quint32 id);
+    void flushTextBoxChanges();
+    BoardJournal *m_journal = nullptr;      // el de la pizarra activa
+    bool m_journalSuspended = false;
+    QString m_autosaveDir;                  // vacio mientras no hay autoguardado
+    static QString journalDirectory(const QString &autosaveDir, quint32 boardId);
+    void startBoardJournal();
+    QSet<quint32> m_dirtyTextBoxes;
+    QTimer *m_textChangeTimer = nullptr;
+    quint32 m_nextTextId = 1;
+
+    // Deshacer/rehacer (Ctrl+Z / Ctrl+Y). Se registra cada cambio que llega a boardChanged con su
+    // inverso; un trazo del borrador con el boton derecho pulsado es un unico paso.
+    void undoBoard();
+    void redoBoard();
+    void applyHistory(const QVector<BoardOp> &ops);
+    void applyBoardOp(const BoardOp &op);
+    void recordUndo(const BoardOp &op);
+    void endEraserStroke();
+    UndoStack m_undo;
+    bool m_applyingHistory = false;
+    bool m_eraserStroke = false;
+    QHash<quint32, BoardText> m_textState;  // ultimo estado registrado de cada texto, para invertir UpdateText
+
+    // Pizarras en pestanas. Todas usan la misma vista; cada una tiene su carta, compartida con las
+    // demas pizarras que usan la misma (y con sus teselas ya decodificadas), y su escena con lo
+    // dibujado. La activa vive en los miembros de siempre (scene, dibujos, m_textBoxes,
+    // herramientas, historial, carta); las demas esperan en su BoardTab. Cambiar es intercambiar punteros.
+    // Cada pizarra tiene su diario en <autoguardado>/board-<id>, asi que se recuperan todas.
+    struct BoardTab {
+        QGraphicsScene *scene = nullptr;
+        std::unique_ptr<Dibujos> dibujos;
+        QVector<TextBoxWidgets> textBoxes;
+        RulerTool *ruler = nullptr;
+        ProtractorTool *protractor = nullptr;
+        CompassTool *compass = nullptr;
+        UndoStack undo;
+        QHash<quint32, BoardText> textState;
+        quint32 nextTextId = 1;
+        QPointF viewCenter;         // centro de la vista al dejar la pizarra
+        std::shared_ptr<ChartTiles> chart;
+        quint32 boardId = 0;        // numero de la pestana y carpeta de su diario
+        BoardJournal *journal = nullptr;
+    };
+    // boardId 0 = numero nuevo; la recuperacion pasa el de la carpeta del diario
+    void addBoard(quint32 boardId = 0);
+    void closeBoard(int index);
+    void switchBoard(int index);
+    void swapBoardState(BoardTab &tab);
+    std::unique_ptr<Dibujos> createDibujos(QGraphicsScene *boardScene);
+    QTabBar *m_boardTabs = nullptr;
+    std::vector<BoardTab> m_boards;     // por indice de pestana; la entrada de la activa esta vacia
+    int m_activeBoard = 0;
+    quint32 m_boardId = 1;              // de la pizarra activa
+    quint32 m_boardsCreated = 1;
+
 protected:
     QMenu *createPopupMenu() override; // Para que no se pueda quitar el toolbar
     bool eventFilter(QObject *obj, QEvent *event) override;
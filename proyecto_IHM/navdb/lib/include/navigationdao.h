@@ -10,27 +10,43 @@
 #include <QBuffer>
 #include <QMap>
 
+#include <functional>
+
 class NavigationDAO
 {
 public:
-    explicit NavigationDAO(const QString &dbFilePath);
+    // busyTimeoutMs > 0: espera ese tiempo al bloqueo de escritura de otra conexion en vez de
+    // fallar en el acto (herramientas por lotes con varias conexiones a la vez)
+    explicit NavigationDAO(const QString &dbFilePath, int busyTimeoutMs = 0);
     ~NavigationDAO();
 
     QMap<QString, User> loadUsers();
     QVector<Problem>    loadProblems();
 
     void saveUser(User &user);
+    // Con el avatar ya en PNG: la codificacion puede hacerse fuera de la transaccion
+    void saveUser(User &user, const QByteArray &avatarPng);
+    static QByteArray imageToPng(const QImage &img);
     void updateUser(const User &user);
     void deleteUser(const QString &nickName);
 
     QVector<Session> loadSessionsFor(const QString &nickName);
     void addSession(const QString &nickName, const Session &session);
 
+    // Recorre todas las sesiones sin cargarlas en memoria (exportaciones por lotes)
+    void forEachSession(const std::function<void(const QString &nickName, const Session &session)> &fn);
+
+    void addProblems(const QVector<Problem> &problems);
     void replaceAllProblems(const QVector<Problem> &problems);
 
+    void beginTransaction();
+    void commitTransaction();
+    void rollbackTransaction();
+
 private:
     QString      m_dbFilePath;
     QString      m_connectionName;
+    int          m_busyTimeoutMs = 0;
     QSqlDatabase m_db;
 
     void open();
@@ -45,7 +61,6 @@ private:
     Session buildSessionFromQuery(QSqlQuery &q);
     Problem buildProblemFromQuery(QSqlQuery &q);
 
-    QByteArray imageToPng(const QImage &img);
     QImage     imageFromPng(const QByteArray &bytes);
 
     QString    dateToDb(const QDate &date) const;
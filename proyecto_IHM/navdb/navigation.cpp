@@ -1,4 +1,5 @@
 #include "navigation.h"
+#include "trace.h"
 
 #include <QCoreApplication>
 
@@ -73,6 +74,13 @@ void Navigation::reload()
 
 void Navigation::loadFromDb()
 {
-    m_users    = m_dao.loadUsers();
-    m_problems = m_dao.loadProblems();
+    TRACE_SCOPE("Navigation::loadFromDb");
+    {
+        TRACE_SCOPE("NavigationDAO::loadUsers");
+        m_users = m_dao.loadUsers();
+    }
+    {
+        TRACE_SCOPE("NavigationDAO::loadProblems");
+        m_problems = m_dao.loadProblems();
+    }
 }
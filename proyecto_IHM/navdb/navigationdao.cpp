@@ -9,9 +9,10 @@
 #include <QUuid>
 #include <algorithm>
 
-NavigationDAO::NavigationDAO(const QString &dbFilePath)
+NavigationDAO::NavigationDAO(const QString &dbFilePath, int busyTimeoutMs)
     : m_dbFilePath(dbFilePath),
-      m_connectionName(QStringLiteral("navdb-%1").arg(QUuid::createUuid().toString()))
+      m_connectionName(QStringLiteral("navdb-%1").arg(QUuid::createUuid().toString())),
+      m_busyTimeoutMs(busyTimeoutMs)
 {
     open();
     createTablesIfNeeded();
@@ -35,6 +36,9 @@ void NavigationDAO::open()
     }
 
     m_db.setDatabaseName(m_dbFilePath);
+    if (m_busyTimeoutMs > 0) {
+        m_db.setConnectOptions(QStringLiteral("QSQLITE_BUSY_TIMEOUT=%1").arg(m_busyTimeoutMs));
+    }
     if (!m_db.open()) {
         throwSqlError(QStringLiteral("open"), m_db.lastError());
     }
@@ -137,6 +141,11 @@ QVector<Problem> NavigationDAO::loadProblems()
 }
 
 void NavigationDAO::saveUser(User &user)
+{
+    saveUser(user, imageToPng(user.avatar()));
+}
+
+void NavigationDAO::saveUser(User &user, const QByteArray &avatarPng)
 {
     QSqlQuery q(m_db);
     q.prepare("INSERT INTO user (nickName, password, email, birthDate, avatar)"
@@ -145,7 +154,7 @@ void NavigationDAO::saveUser(User &user)
     q.addBindValue(user.password());
     q.addBindValue(user.email());
     q.addBindValue(dateToDb(user.birthdate()));
-    q.addBindValue(imageToPng(user.avatar()));
+    q.addBindValue(avatarPng);
 
     if (!q.exec()) {
         throwSqlError(QStringLiteral("insert user"), q.lastError());
@@ -221,13 +230,22 @@ void NavigationDAO::addSession(const QString &nickName, const Session &session)
     }
 }
 
-void NavigationDAO::replaceAllProblems(const QVector<Problem> &problems)
+void NavigationDAO::forEachSession(const std::function<void(const QString &, const Session &)> &fn)
 {
-    QSqlQuery clear(m_db);
-    if (!clear.exec("DELETE FROM problem")) {
-        throwSqlError(QStringLiteral("clear problems"), clear.lastError());
+    QSqlQuery q(m_db);
+    q.setForwardOnly(true);
+    if (!q.exec("SELECT timeStamp, hits, faults, userNickName FROM session"
+                " ORDER BY userNickName, timeStamp")) {
+        throwSqlError(QStringLiteral("iterate sessions"), q.lastError());
     }
 
+    while (q.next()) {
+        fn(q.value(3).toString(), buildSessionFromQuery(q));
+    }
+}
+
+void NavigationDAO::addProblems(const QVector<Problem> &problems)
+{
     QSqlQuery q(m_db);
     q.prepare("INSERT INTO problem (text, answer1, val1, answer2, val2, answer3, val3, answer4, val4)"
               " VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?)");
@@ -254,6 +272,37 @@ void NavigationDAO::replaceAllProblems(const QVector<Problem> &problems)
     }
 }
 
+void NavigationDAO::replaceAllProblems(const QVector<Problem> &problems)
+{
+    QSqlQuery clear(m_db);
+    if (!clear.exec("DELETE FROM problem")) {
+        throwSqlError(QStringLiteral("clear problems"), clear.lastError());
+    }
+
+    addProblems(problems);
+}
+
+void NavigationDAO::beginTransaction()
+{
+    if (!m_db.transaction()) {
+        throwSqlError(QStringLiteral("begin transaction"), m_db.lastError());
+    }
+}
+
+void NavigationDAO::commitTransaction()
+{
+    if (!m_db.commit()) {
+        throwSqlError(QStringLiteral("commit"), m_db.lastError());
+    }
+}
+
+void NavigationDAO::rollbackTransaction()
+{
+    if (!m_db.rollback()) {
+        throwSqlError(QStringLiteral("rollback"), m_db.lastError());
+    }
+}
+
 User NavigationDAO::buildUserFromQuery(QSqlQuery &q)
 {
     const auto nick      = q.value(0).toString();
@@ -0,0 +1,158 @@
+#include "protractortool.h"
+#include "georeference.h"
+
+#include <QFont>
+#include <QGraphicsSceneMouseEvent>
+#include <QPainter>
+#include <QPen>
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+constexpr double kSnapPx = 30.0; // distancia en pantalla a la que engancha
+const QColor kSnappedColor(200, 30, 30);
+const QColor kFreeColor(20, 20, 20);
+}
+
+ProtractorTool::ProtractorTool(const QString &svgResourcePath, QGraphicsItem *parent)
+    : Tool(svgResourcePath, parent)
+{
+    updateReadout();
+}
+
+void ProtractorTool::setGeoReference(const GeoReference *geo)
+{
+    m_geo = geo;
+    updateReadout();
+}
+
+void ProtractorTool::viewTransformChanged()
+{
+    updateReadout();
+}
+
+QPointF ProtractorTool::snapPosition(const QPointF &newPos)
+{
+    m_snapped = false;
+    if (!m_lineFinder || !view()) {
+        return newPos;
+    }
+
+    const double zoom = std::max(view()->transform().m11(), 0.01);
+    // El centro guarda el mismo desplazamiento respecto a pos() al trasladar el item
+    const QPointF centerOffset = itemToSceneTransform().map(boundingRect().center()) - pos();
+    const QPointF center = newPos + centerOffset;
+
+    QLineF line;
+    if (!m_lineFinder(center, kSnapPx / zoom, &line) || line.length() <= 0.0) {
+        return newPos;
+    }
+
+    // Centro proyectado sobre la linea (como recta, para poder deslizar a lo largo de ella)
+    const QPointF d = line.p2() - line.p1();
+    const double t = QPointF::dotProduct(center - line.p1(), d) / QPointF::dotProduct(d, d);
+    const QPointF onLine = line.p1() + d * t;
+
+    // Eje paralelo a la linea, eligiendo el sentido mas proximo al giro actual
+    double target = -line.angle();
+    const double diff = std::fmod(target - toolRotation() + 540.0, 360.0) - 180.0;
+    if (std::fabs(diff) > 90.0) {
+        target += diff > 0.0 ? -180.0 : 180.0;
+    }
+
+    m_applyingSnap = true;
+    setToolRotation(toolRotation() + (std::fmod(target - toolRotation() + 540.0, 360.0) - 180.0));
+    m_applyingSnap = false;
+
+    m_snapped = true;
+    m_snapLine = line;
+    return onLine - centerOffset;
+}
+
+QVariant ProtractorTool::itemChange(GraphicsItemChange change, const QVariant &value)
+{
+    switch (change) {
+    case ItemPositionChange:
+        if (m_dragging && !m_applyingSnap) {
+            return Tool::itemChange(change, snapPosition(value.toPointF()));
+        }
+        break;
+    case ItemRotationHasChanged:
+        if (!m_applyingSnap) {
+            // Girado a mano: deja de estar alineado con la linea
+            m_snapped = false;
+        }
+        break;
+    default:
+        break;
+    }
+
+    const QVariant result = Tool::itemChange(change, value);
+    if (change == ItemPositionHasChanged || change == ItemRotationHasChanged || change == ItemScaleHasChanged) {
+        updateReadout();
+    }
+    return result;
+}
+
+void ProtractorTool::mousePressEvent(QGraphicsSceneMouseEvent *event)
+{
+    if (event && event->button() == Qt::LeftButton) {
+        m_dragging = true;
+    }
+    Tool::mousePressEvent(event);
+}
+
+void ProtractorTool::mouseReleaseEvent(QGraphicsSceneMouseEvent *event)
+{
+    if (event && event->button() == Qt::LeftButton) {
+        m_dragging = false;
+    }
+    Tool::mouseReleaseEvent(event);
+}
+
+void ProtractorTool::updateReadout()
+{
+    if (!m_geo) {
+        return;
+    }
+
+    QLineF axis = m_snapLine;
+    if (!m_snapped) {
+        const QTransform toScene = itemToSceneTransform();
+        const QPointF c = boundingRect().center();
+        axis = QLineF(toScene.map(c), toScene.map(c + QPointF(100.0, 0.0)));
+    }
+
+    // Una linea no tiene sentido: el rumbo se da en [0, 180) junto con su reciproco
+    m_bearingDeg = std::fmod(m_geo->bearingDeg(axis.p1(), axis.p2()), 180.0);
+
+    const int deciDeg = qRound(m_bearingDeg * 10.0) % 1800;
+    if (deciDeg == m_shownDeciDeg && m_snapped == m_shownSnapped) {
+        return;
+    }
+    m_shownDeciDeg = deciDeg;
+    m_shownSnapped = m_snapped;
+    m_readout = QStringLiteral("%1° / %2°")
+                    .arg(deciDeg / 10.0, 5, 'f', 1, QLatin1Char('0'))
+                    .arg(deciDeg / 10.0 + 180.0, 5, 'f', 1, QLatin1Char('0'));
+    update();
+}
+
+void ProtractorTool::paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget)
+{
+    Tool::paint(painter, option, widget);
+
+    const QRectF br = boundingRect();
+    if (br.height() != m_readoutFontHeight) {
+        m_readoutFontHeight = br.height();
+        m_readoutFont = painter->font();
+        m_readoutFont.setPixelSize(std::max(1, qRound(br.height() * 0.045)));
+        m_readoutFont.setBold(true);
+    }
+    painter->setFont(m_readoutFont);
+    painter->setPen(m_snapped ? kSnappedColor : kFreeColor);
+    painter->setBrush(Qt::NoBrush);
+    const QRectF textRect(br.left(), br.center().y() - br.height() * 0.16, br.width(), br.height() * 0.08);
+    painter->drawText(textRect, Qt::AlignCenter, m_readout);
+}
@@ -0,0 +1,62 @@
+#ifndef PROTRACTORTOOL_H
+#define PROTRACTORTOOL_H
+
+#include "tool.h"
+
+#include <QFont>
+#include <QLineF>
+#include <QString>
+
+#include <functional>
+
+class GeoReference;
+
+// Transportador que, mientras se arrastra, se engancha a la linea dibujada mas cercana: centra
+// su eje sobre ella y gira hasta quedar paralelo. Muestra el rumbo verdadero de la linea (o de
+// su propio eje si no esta enganchado) respecto al meridiano.
+class ProtractorTool : public Tool
+{
+public:
+    // Busca la linea mas cercana a un punto de la escena dentro de un radio (en unidades de escena)
+    using LineFinder = std::function<bool(const QPointF &scenePos, double radius, QLineF *line)>;
+
+    explicit ProtractorTool(const QString &svgResourcePath, QGraphicsItem *parent = nullptr);
+
+    void setLineFinder(LineFinder finder) { m_lineFinder = std::move(finder); }
+    // Georreferencia de la carta de su pizarra; debe vivir mientras el transportador
+    void setGeoReference(const GeoReference *geo);
+    void viewTransformChanged() override;
+
+    bool isSnapped() const { return m_snapped; }
+    double bearingDeg() const { return m_bearingDeg; }
+
+    void paint(QPainter *painter,
+               const QStyleOptionGraphicsItem *option,
+               QWidget *widget = nullptr) override;
+
+protected:
+    QVariant itemChange(GraphicsItemChange change, const QVariant &value) override;
+    void mousePressEvent(QGraphicsSceneMouseEvent *event) override;
+    void mouseReleaseEvent(QGraphicsSceneMouseEvent *event) override;
+
+private:
+    QPointF snapPosition(const QPointF &newPos);
+    void updateReadout();
+
+    LineFinder m_lineFinder;
+    const GeoReference *m_geo = nullptr;
+    bool m_dragging = false;
+    bool m_applyingSnap = false;
+    bool m_snapped = false;
+    QLineF m_snapLine;
+
+    double m_bearingDeg = 0.0;
+    int m_shownDeciDeg = -1;
+    bool m_shownSnapped = false;
+    QString m_readout;
+    // Fuente de la lectura, rehecha solo cuando cambia el alto del item
+    QFont m_readoutFont;
+    double m_readoutFontHeight = -1.0;
+};
+
+#endif // PROTRACTORTOOL_H
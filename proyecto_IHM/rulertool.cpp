@@ -0,0 +1,165 @@
+#include "rulertool.h"
+#include "georeference.h"
+
+#include <QFont>
+#include <QGraphicsSceneMouseEvent>
+#include <QPainter>
+#include <QPen>
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+// ruler.svg: viewBox de 310 unidades de ancho con graduaciones de 5 a 305
+constexpr double kViewBoxWidth = 310.0;
+constexpr double kFirstGraduation = 5.0;
+constexpr double kLastGraduation = 305.0;
+constexpr double kMarkPickPx = 10.0;
+const QColor kMarkColor(200, 30, 30);
+}
+
+RulerTool::RulerTool(const QString &svgResourcePath, QGraphicsItem *parent)
+    : Tool(svgResourcePath, parent)
+{
+    m_markX[0] = edgeStart();
+    m_markX[1] = edgeEnd();
+    updateReadout();
+}
+
+double RulerTool::edgeStart() const
+{
+    const QRectF br = boundingRect();
+    return br.left() + br.width() * (kFirstGraduation / kViewBoxWidth);
+}
+
+double RulerTool::edgeEnd() const
+{
+    const QRectF br = boundingRect();
+    return br.left() + br.width() * (kLastGraduation / kViewBoxWidth);
+}
+
+void RulerTool::setGeoReference(const GeoReference *geo)
+{
+    m_geo = geo;
+    updateReadout();
+}
+
+void RulerTool::viewTransformChanged()
+{
+    updateReadout();
+}
+
+void RulerTool::updateReadout()
+{
+    if (!m_geo) {
+        return;
+    }
+    const QTransform toScene = itemToSceneTransform();
+    const QPointF a = toScene.map(QPointF(m_markX[0], 0.0));
+    const QPointF b = toScene.map(QPointF(m_markX[1], 0.0));
+
+    m_distanceNm = m_geo->distanceNm(a, b);
+    m_bearingDeg = m_geo->bearingDeg(a, b);
+
+    const int centiNm = qRound(m_distanceNm * 100.0);
+    const int deciDeg = qRound(m_bearingDeg * 10.0) % 3600;
+    if (centiNm == m_shownCentiNm && deciDeg == m_shownDeciDeg) {
+        return;
+    }
+    m_shownCentiNm = centiNm;
+    m_shownDeciDeg = deciDeg;
+    m_readout = QStringLiteral("%1 M   %2°")
+                    .arg(centiNm / 100.0, 0, 'f', 2)
+                    .arg(deciDeg / 10.0, 5, 'f', 1, QLatin1Char('0'));
+    update();
+}
+
+QVariant RulerTool::itemChange(GraphicsItemChange change, const QVariant &value)
+{
+    const QVariant result = Tool::itemChange(change, value);
+    switch (change) {
+    case ItemPositionHasChanged:
+    case ItemRotationHasChanged:
+    case ItemScaleHasChanged:
+        updateReadout();
+        break;
+    default:
+        break;
+    }
+    return result;
+}
+
+int RulerTool::markAt(const QPointF &itemPos) const
+{
+    const double tolerance = kMarkPickPx / std::max(scale(), 0.01);
+    int best = -1;
+    double bestDist = tolerance;
+    for (int i = 0; i < 2; ++i) {
+        const double dist = std::fabs(itemPos.x() - m_markX[i]);
+        if (dist <= bestDist) {
+            best = i;
+            bestDist = dist;
+        }
+    }
+    return best;
+}
+
+void RulerTool::mousePressEvent(QGraphicsSceneMouseEvent *event)
+{
+    if (event && event->button() == Qt::LeftButton) {
+        m_draggedMark = markAt(event->pos());
+        if (m_draggedMark >= 0) {
+            event->accept();
+            return;
+        }
+    }
+    Tool::mousePressEvent(event);
+}
+
+void RulerTool::mouseMoveEvent(QGraphicsSceneMouseEvent *event)
+{
+    if (m_draggedMark < 0 || !event) {
+        Tool::mouseMoveEvent(event);
+        return;
+    }
+
+    m_markX[m_draggedMark] = std::clamp(event->pos().x(), edgeStart(), edgeEnd());
+    updateReadout();
+    update();
+    event->accept();
+}
+
+void RulerTool::mouseReleaseEvent(QGraphicsSceneMouseEvent *event)
+{
+    if (m_draggedMark >= 0 && event && event->button() == Qt::LeftButton) {
+        m_draggedMark = -1;
+        event->accept();
+        return;
+    }
+    Tool::mouseReleaseEvent(event);
+}
+
+void RulerTool::paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget)
+{
+    Tool::paint(painter, option, widget);
+
+    const QRectF br = boundingRect();
+    QPen markPen(kMarkColor, 2.0);
+    markPen.setCosmetic(true);
+    painter->setPen(markPen);
+    painter->setBrush(Qt::NoBrush);
+    for (double x : m_markX) {
+        painter->drawLine(QPointF(x, br.top()), QPointF(x, br.bottom()));
+    }
+
+    if (br.height() != m_readoutFontHeight) {
+        m_readoutFontHeight = br.height();
+        m_readoutFont = painter->font();
+        m_readoutFont.setPixelSize(std::max(1, qRound(br.height() * 0.28)));
+        m_readoutFont.setBold(true);
+    }
+    painter->setFont(m_readoutFont);
+    const QRectF textRect(edgeStart(), br.top() + br.height() * 0.55,
+                          edgeEnd() - edgeStart(), br.height() * 0.45);
+    painter->drawText(textRect, Qt::AlignCenter, m_readout);
+}
@@ -0,0 +1,58 @@
+#ifndef RULERTOOL_H
+#define RULERTOOL_H
+
+#include "tool.h"
+
+#include <QFont>
+#include <QString>
+
+class GeoReference;
+
+// Regla con dos marcas deslizantes sobre su borde graduado. Mientras se arrastra, gira o se
+// mueve una marca, muestra la distancia en millas y el rumbo verdadero de la marca A a la B,
+// calculados sobre la georreferencia de la carta de su pizarra.
+class RulerTool : public Tool
+{
+public:
+    explicit RulerTool(const QString &svgResourcePath, QGraphicsItem *parent = nullptr);
+
+    // geo debe vivir mientras la regla; sin ella no hay lectura
+    void setGeoReference(const GeoReference *geo);
+    void viewTransformChanged() override;
+
+    double distanceNm() const { return m_distanceNm; }
+    double bearingDeg() const { return m_bearingDeg; }
+
+    void paint(QPainter *painter,
+               const QStyleOptionGraphicsItem *option,
+               QWidget *widget = nullptr) override;
+
+protected:
+    QVariant itemChange(GraphicsItemChange change, const QVariant &value) override;
+    void mousePressEvent(QGraphicsSceneMouseEvent *event) override;
+    void mouseMoveEvent(QGraphicsSceneMouseEvent *event) override;
+    void mouseReleaseEvent(QGraphicsSceneMouseEvent *event) override;
+
+private:
+    void updateReadout();
+    double edgeStart() const;
+    double edgeEnd() const;
+    int markAt(const QPointF &itemPos) const;
+
+    // Posicion de las marcas a lo largo del borde superior (y = 0), en coordenadas del item
+    double m_markX[2] = {0.0, 0.0};
+    int m_draggedMark = -1;
+
+    const GeoReference *m_geo = nullptr;
+    double m_distanceNm = 0.0;
+    double m_bearingDeg = 0.0;
+    // El texto solo se rehace cuando cambia el valor redondeado que se muestra
+    int m_shownCentiNm = -1;
+    int m_shownDeciDeg = -1;
+    QString m_readout;
+    // Fuente de la lectura, rehecha solo cuando cambia el alto del item
+    QFont m_readoutFont;
+    double m_readoutFontHeight = -1.0;
+};
+
+#endif // RULERTOOL_H
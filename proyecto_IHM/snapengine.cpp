@@ -0,0 +1,326 @@
+#include "snapengine.h"
+
+#include <QtMath>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+constexpr int kMaxBoxCells = 256;   // por encima, un arco se indexa muestreando su trazo
+constexpr int kCompactMinDead = 1024;
+
+QRectF arcBounds(const ArcPrimitive &arc)
+{
+    return QRectF(arc.center.x() - arc.radius, arc.center.y() - arc.radius, arc.radius * 2.0, arc.radius * 2.0);
+}
+}
+
+SnapEngine::SnapEngine(double cellSize)
+    : m_cellSize(cellSize)
+{
+}
+
+quint64 SnapEngine::cellKey(const QPointF &p) const
+{
+    const auto cx = static_cast<qint32>(std::floor(p.x() / m_cellSize));
+    const auto cy = static_cast<qint32>(std::floor(p.y() / m_cellSize));
+    return (static_cast<quint64>(static_cast<quint32>(cx)) << 32) | static_cast<quint32>(cy);
+}
+
+template <typename Fn>
+void SnapEngine::forEachCell(const QRectF &rect, Fn fn) const
+{
+    const auto x0 = static_cast<qint32>(std::floor(rect.left() / m_cellSize));
+    const auto x1 = static_cast<qint32>(std::floor(rect.right() / m_cellSize));
+    const auto y0 = static_cast<qint32>(std::floor(rect.top() / m_cellSize));
+    const auto y1 = static_cast<qint32>(std::floor(rect.bottom() / m_cellSize));
+    for (qint32 x = x0; x <= x1; ++x) {
+        for (qint32 y = y0; y <= y1; ++y) {
+            fn((static_cast<quint64>(static_cast<quint32>(x)) << 32) | static_cast<quint32>(y));
+        }
+    }
+}
+
+SnapEngine::PrimitiveId SnapEngine::addPoint(const QPointF &point)
+{
+    Primitive p;
+    p.type = Type::Point;
+    p.segment = QLineF(point, point);
+    p.bounds = QRectF(point, QSizeF(0.0, 0.0));
+    const PrimitiveId id = insert(std::move(p));
+    addCandidate(id, kInvalidId, point, Kind::Point);
+    return id;
+}
+
+SnapEngine::PrimitiveId SnapEngine::addSegment(const QLineF &segment)
+{
+    Primitive p;
+    p.type = Type::Segment;
+    p.segment = segment;
+    p.bounds = QRectF(segment.p1(), segment.p2()).normalized();
+    const PrimitiveId id = insert(std::move(p));
+    addCandidate(id, kInvalidId, segment.p1(), Kind::Endpoint);
+    addCandidate(id, kInvalidId, segment.p2(), Kind::Endpoint);
+    intersect(id);
+    return id;
+}
+
+SnapEngine::PrimitiveId SnapEngine::addArc(const ArcPrimitive &arc)
+{
+    Primitive p;
+    p.type = Type::Arc;
+    p.arc = arc;
+    p.bounds = arcBounds(arc);
+    const PrimitiveId id = insert(std::move(p));
+    addCandidate(id, kInvalidId, arcPointAt(arc, arc.startDeg), Kind::Endpoint);
+    addCandidate(id, kInvalidId, arcPointAt(arc, arc.startDeg + arc.spanDeg), Kind::Endpoint);
+    intersect(id);
+    return id;
+}
+
+SnapEngine::PrimitiveId SnapEngine::insert(Primitive primitive)
+{
+    primitive.alive = true;
+
+    // Celdas que toca la primitiva (para buscar vecinas con las que se corta)
+    QVector<quint64> &cells = primitive.cells;
+    if (primitive.type == Type::Segment) {
+        // Recorrido de rejilla (Amanatides-Woo): exactamente las celdas que atraviesa el segmento
+        const QPointF a = primitive.segment.p1() / m_cellSize;
+        const QPointF b = primitive.segment.p2() / m_cellSize;
+        auto x = static_cast<qint32>(std::floor(a.x()));
+        auto y = static_cast<qint32>(std::floor(a.y()));
+        const auto xEnd = static_cast<qint32>(std::floor(b.x()));
+        const auto yEnd = static_cast<qint32>(std::floor(b.y()));
+        const double dx = b.x() - a.x();
+        const double dy = b.y() - a.y();
+        const int stepX = dx > 0 ? 1 : -1;
+        const int stepY = dy > 0 ? 1 : -1;
+        const double inf = std::numeric_limits<double>::infinity();
+        const double tDeltaX = dx != 0.0 ? std::fabs(1.0 / dx) : inf;
+        const double tDeltaY = dy != 0.0 ? std::fabs(1.0 / dy) : inf;
+        double tMaxX = dx != 0.0 ? ((stepX > 0 ? x + 1 - a.x() : a.x() - x) * tDeltaX) : inf;
+        double tMaxY = dy != 0.0 ? ((stepY > 0 ? y + 1 - a.y() : a.y() - y) * tDeltaY) : inf;
+        const int maxSteps = std::abs(xEnd - x) + std::abs(yEnd - y) + 1;
+        for (int i = 0; i < maxSteps; ++i) {
+            cells.append((static_cast<quint64>(static_cast<quint32>(x)) << 32) | static_cast<quint32>(y));
+            if (x == xEnd && y == yEnd) {
+                break;
+            }
+            if (tMaxX < tMaxY) {
+                tMaxX += tDeltaX;
+                x += stepX;
+            } else {
+                tMaxY += tDeltaY;
+                y += stepY;
+            }
+        }
+    } else if (primitive.type == Type::Arc) {
+        const QRectF box = primitive.bounds;
+        const double cellsAcross = (box.width() / m_cellSize + 1.0) * (box.height() / m_cellSize + 1.0);
+        if (cellsAcross <= kMaxBoxCells) {
+            forEachCell(box, [&cells](quint64 key) { cells.append(key); });
+        } else {
+            // Arco grande: muestras a cuarto de celda, con sus celdas vecinas
+            const double span = std::clamp(primitive.arc.spanDeg, -360.0, 360.0);
+            const double arcLength = qDegreesToRadians(std::fabs(span)) * primitive.arc.radius;
+            const int samples = std::max(2, static_cast<int>(std::ceil(arcLength / (m_cellSize * 0.25))) + 1);
+            for (int i = 0; i < samples; ++i) {
+                const QPointF p = arcPointAt(primitive.arc, primitive.arc.startDeg + span * i / (samples - 1));
+                forEachCell(QRectF(p.x() - m_cellSize, p.y() - m_cellSize, m_cellSize * 2.0, m_cellSize * 2.0),
+                            [&cells](quint64 key) { cells.append(key); });
+            }
+            std::sort(cells.begin(), cells.end());
+            cells.erase(std::unique(cells.begin(), cells.end()), cells.end());
+        }
+    } else {
+        cells.append(cellKey(primitive.segment.p1()));
+    }
+
+    m_primitives.append(std::move(primitive));
+    m_visited.append(0);
+    const auto id = static_cast<PrimitiveId>(m_primitives.size());
+    for (quint64 key : m_primitives.last().cells) {
+        m_primitiveGrid[key].append(id);
+    }
+    return id;
+}
+
+void SnapEngine::addCandidate(PrimitiveId owner, PrimitiveId other, const QPointF &pos, Kind kind)
+{
+    Candidate c;
+    c.pos = pos;
+    c.kind = kind;
+    c.cell = cellKey(pos);
+    c.alive = true;
+
+    const int index = m_candidates.size();
+    m_candidates.append(c);
+    m_candidateGrid[c.cell].append(index);
+    m_primitives[owner - 1].candidates.append(index);
+    if (other != kInvalidId) {
+        m_primitives[other - 1].candidates.append(index);
+    }
+    ++m_liveCandidates;
+}
+
+void SnapEngine::intersect(PrimitiveId id)
+{
+    // Copia: addCandidate puede reubicar m_primitives
+    const Primitive self = m_primitives[id - 1];
+    const quint32 stamp = ++m_queryStamp;
+    m_visited[id - 1] = stamp;
+
+    for (quint64 key : self.cells) {
+        const auto it = m_primitiveGrid.constFind(key);
+        if (it == m_primitiveGrid.constEnd()) {
+            continue;
+        }
+        for (PrimitiveId otherId : it.value()) {
+            if (m_visited[otherId - 1] == stamp) {
+                continue;
+            }
+            m_visited[otherId - 1] = stamp;
+            const Primitive &other = m_primitives[otherId - 1];
+            if (!other.alive || other.type == Type::Point || !self.bounds.intersects(other.bounds.adjusted(-1, -1, 1, 1))) {
+                continue;
+            }
+
+            QPointF hits[2];
+            int count = 0;
+            if (self.type == Type::Segment && other.type == Type::Segment) {
+                count = self.segment.intersects(other.segment, &hits[0]) == QLineF::BoundedIntersection ? 1 : 0;
+            } else if (self.type == Type::Segment && other.type == Type::Arc) {
+                count = intersectSegmentArc(self.segment, other.arc, hits);
+            } else if (self.type == Type::Arc && other.type == Type::Segment) {
+                count = intersectSegmentArc(other.segment, self.arc, hits);
+            } else {
+                count = intersectArcs(self.arc, other.arc, hits);
+            }
+            for (int i = 0; i < count; ++i) {
+                addCandidate(id, otherId, hits[i], Kind::Intersection);
+            }
+        }
+    }
+}
+
+void SnapEngine::remove(PrimitiveId id)
+{
+    if (id == kInvalidId || id > static_cast<PrimitiveId>(m_primitives.size())) {
+        return;
+    }
+    Primitive &p = m_primitives[id - 1];
+    if (!p.alive) {
+        return;
+    }
+
+    for (quint64 key : p.cells) {
+        auto it = m_primitiveGrid.find(key);
+        if (it != m_primitiveGrid.end()) {
+            it->removeOne(id);
+            if (it->isEmpty()) {
+                m_primitiveGrid.erase(it);
+            }
+        }
+    }
+    for (int index : p.candidates) {
+        Candidate &c = m_candidates[index];
+        if (!c.alive) {
+            continue;
+        }
+        c.alive = false;
+        --m_liveCandidates;
+        auto it = m_candidateGrid.find(c.cell);
+        if (it != m_candidateGrid.end()) {
+            it->removeOne(index);
+            if (it->isEmpty()) {
+                m_candidateGrid.erase(it);
+            }
+        }
+    }
+    p.alive = false;
+    p.cells.clear();
+    p.candidates.clear();
+
+    const int dead = m_candidates.size() - m_liveCandidates;
+    if (dead > kCompactMinDead && dead > m_liveCandidates) {
+        compact();
+    }
+}
+
+void SnapEngine::compact()
+{
+    QVector<int> remap(m_candidates.size(), -1);
+    QVector<Candidate> live;
+    live.reserve(m_liveCandidates);
+    for (int i = 0; i < m_candidates.size(); ++i) {
+        if (m_candidates[i].alive) {
+            remap[i] = live.size();
+            live.append(m_candidates[i]);
+        }
+    }
+    m_candidates = std::move(live);
+
+    for (Primitive &p : m_primitives) {
+        QVector<int> kept;
+        kept.reserve(p.candidates.size());
+        for (int index : p.candidates) {
+            if (remap[index] >= 0) {
+                kept.append(remap[index]);
+            }
+        }
+        p.candidates = std::move(kept);
+    }
+
+    m_candidateGrid.clear();
+    for (int i = 0; i < m_candidates.size(); ++i) {
+        m_candidateGrid[m_candidates[i].cell].append(i);
+    }
+}
+
+void SnapEngine::clear()
+{
+    // En Qt 6 clear() conserva la capacidad: se sustituyen por contenedores vacios para que
+    // una pizarra grande borrada no deje su memoria reservada hasta cerrar la aplicacion
+    m_primitives = {};
+    m_candidates = {};
+    m_candidateGrid = {};
+    m_primitiveGrid = {};
+    m_visited = {};
+    m_liveCandidates = 0;
+    m_queryStamp = 0;
+}
+
+bool SnapEngine::nearest(const QPointF &scenePos, double radius, QPointF *snapped, Kind *kind) const
+{
+    double bestDist2 = radius * radius;
+    const Candidate *best = nullptr;
+    forEachCell(QRectF(scenePos.x() - radius, scenePos.y() - radius, radius * 2.0, radius * 2.0),
+                [&](quint64 key) {
+        const auto it = m_candidateGrid.constFind(key);
+        if (it == m_candidateGrid.constEnd()) {
+            return;
+        }
+        for (int index : it.value()) {
+            const Candidate &c = m_candidates[index];
+            const QPointF d = c.pos - scenePos;
+            const double dist2 = QPointF::dotProduct(d, d);
+            if (dist2 <= bestDist2) {
+                bestDist2 = dist2;
+                best = &c;
+            }
+        }
+    });
+
+    if (!best) {
+        return false;
+    }
+    if (snapped) {
+        *snapped = best->pos;
+    }
+    if (kind) {
+        *kind = best->kind;
+    }
+    return true;
+}
@@ -0,0 +1,74 @@
+#ifndef SNAPENGINE_H
+#define SNAPENGINE_H
+
+#include "arcitem.h"
+
+#include <QHash>
+#include <QLineF>
+#include <QPointF>
+#include <QVector>
+
+// Indice de puntos de enganche (puntos, extremos de linea e intersecciones entre lineas y
+// arcos) sobre una rejilla uniforme en coordenadas de escena. Las primitivas se anaden y
+// se borran de una en una; solo se recalculan las intersecciones con sus vecinas de rejilla.
+class SnapEngine
+{
+public:
+    using PrimitiveId = quint32;
+    static constexpr PrimitiveId kInvalidId = 0;
+
+    enum class Kind : quint8 { Point, Endpoint, Intersection };
+
+    explicit SnapEngine(double cellSize = 128.0);
+
+    PrimitiveId addPoint(const QPointF &point);
+    PrimitiveId addSegment(const QLineF &segment);
+    PrimitiveId addArc(const ArcPrimitive &arc);
+    void remove(PrimitiveId id);
+    void clear();
+
+    // Candidato mas cercano a scenePos a distancia <= radius
+    bool nearest(const QPointF &scenePos, double radius, QPointF *snapped, Kind *kind = nullptr) const;
+
+    int candidateCount() const { return m_liveCandidates; }
+
+private:
+    enum class Type : quint8 { Point, Segment, Arc };
+
+    struct Primitive {
+        Type type = Type::Point;
+        QLineF segment;       // Point usa p1
+        ArcPrimitive arc;
+        QRectF bounds;
+        QVector<quint64> cells;
+        QVector<int> candidates;
+        bool alive = false;
+    };
+
+    struct Candidate {
+        QPointF pos;
+        Kind kind = Kind::Point;
+        quint64 cell = 0;
+        bool alive = false;
+    };
+
+    quint64 cellKey(const QPointF &p) const;
+    template <typename Fn>
+    void forEachCell(const QRectF &rect, Fn fn) const;
+
+    PrimitiveId insert(Primitive primitive);
+    void addCandidate(PrimitiveId owner, PrimitiveId other, const QPointF &pos, Kind kind);
+    void intersect(PrimitiveId id);
+    void compact();
+
+    double m_cellSize;
+    QVector<Primitive> m_primitives;            // indice = id - 1
+    QVector<Candidate> m_candidates;
+    QHash<quint64, QVector<int>> m_candidateGrid;
+    QHash<quint64, QVector<PrimitiveId>> m_primitiveGrid;
+    int m_liveCandidates = 0;
+    quint32 m_queryStamp = 0;
+    QVector<quint32> m_visited;                 // marca por primitiva para no repetir vecinas
+};
+
+#endif // SNAPENGINE_H
@@ -0,0 +1,151 @@
+#include "tilecache.h"
+#include "charttiles.h"
+
+#include <QMetaObject>
+#include <QThread>
+
+#include <algorithm>
+
+namespace {
+constexpr qint64 kDefaultBudgetMb = 128;
+}
+
+TileCache::TileCache(QObject *parent)
+    : QObject(parent)
+{
+    const int budgetMb = qEnvironmentVariableIntValue("PROYECTO_IHM_TILE_CACHE_MB");
+    setBudget((budgetMb > 0 ? budgetMb : kDefaultBudgetMb) * 1024 * 1024);
+    // Un hilo queda para la interfaz
+    m_pool.setMaxThreadCount(std::max(2, QThread::idealThreadCount() - 1));
+}
+
+TileCache::~TileCache()
+{
+    cancelAll();
+    m_pool.waitForDone();
+}
+
+void TileCache::setBudget(qint64 bytes)
+{
+    m_tiles.setMaxCost(std::max<qint64>(bytes, 1));
+}
+
+quint64 TileCache::key(int level, int column, int row) const
+{
+    const quint64 serial = m_chart ? m_chart->serial() : 0;
+    return ((serial & 0xffff) << 48) | (quint64(level & 0xff) << 40)
+           | (quint64(column & 0xfffff) << 20) | quint64(row & 0xfffff);
+}
+
+void TileCache::setChart(std::shared_ptr<ChartTiles> chart)
+{
+    if (chart == m_chart) {
+        return;
+    }
+    cancelAll();
+    m_chart = std::move(chart);
+    m_overview = QPixmap();
+
+    // Fuera las teselas de las cartas que ya no usa ninguna pizarra
+    for (auto it = m_charts.begin(); it != m_charts.end();) {
+        if (!it->expired()) {
+            ++it;
+            continue;
+        }
+        const quint64 serial = it.key() & 0xffff;
+        const QList<quint64> keys = m_tiles.keys();
+        for (quint64 tileKey : keys) {
+            if ((tileKey >> 48) == serial) {
+                m_tiles.remove(tileKey);
+            }
+        }
+        it = m_charts.erase(it);
+    }
+
+    if (m_chart && !m_chart->isNull()) {
+        m_charts.insert(m_chart->serial(), m_chart);
+        m_overview = QPixmap::fromImage(m_chart->decodeTile(m_chart->levelCount() - 1, 0, 0));
+    }
+}
+
+QPixmap TileCache::find(int level, int column, int row)
+{
+    if (!m_chart) {
+        return QPixmap();
+    }
+    const QPixmap *tile = m_tiles.object(key(level, column, row));
+    return tile ? *tile : QPixmap();
+}
+
+void TileCache::beginPass()
+{
+    ++m_pass;
+}
+
+void TileCache::request(int level, int column, int row, bool visible)
+{
+    if (!m_chart) {
+        return;
+    }
+    const quint64 tileKey = key(level, column, row);
+    if (m_tiles.contains(tileKey)) {
+        return;
+    }
+    auto pending = m_pending.find(tileKey);
+    if (pending != m_pending.end()) {
+        pending->pass = m_pass;
+        return;
+    }
+
+    auto cancelled = std::make_shared<std::atomic_bool>(false);
+    m_pending.insert(tileKey, Job{cancelled, m_pass});
+    m_pool.start([this, chart = m_chart, cancelled, tileKey, level, column, row] {
+        if (*cancelled) {
+            return;
+        }
+        const QImage image = chart->decodeTile(level, column, row);
+        if (*cancelled) {
+            return;
+        }
+        QMetaObject::invokeMethod(this, [this, cancelled, tileKey, level, column, row, image] {
+            tileDecoded(tileKey, cancelled, level, column, row, image);
+        }, Qt::QueuedConnection);
+    }, visible ? 1 : 0);
+}
+
+void TileCache::endPass()
+{
+    for (auto it = m_pending.begin(); it != m_pending.end();) {
+        if (it->pass == m_pass) {
+            ++it;
+            continue;
+        }
+        *it->cancelled = true;
+        it = m_pending.erase(it);
+    }
+}
+
+void TileCache::tileDecoded(quint64 tileKey, const std::shared_ptr<std::atomic_bool> &cancelled,
+                            int level, int column, int row, const QImage &image)
+{
+    // Puede llegar tarde: cancelada despues de decodificar, o ya pedida otra vez
+    auto pending = m_pending.find(tileKey);
+    if (pending == m_pending.end() || pending->cancelled != cancelled) {
+        return;
+    }
+    m_pending.erase(pending);
+    if (image.isNull()) {
+        return;
+    }
+    if (m_tiles.insert(tileKey, new QPixmap(QPixmap::fromImage(image)), image.sizeInBytes())) {
+        emit tileReady(level, column, row);
+    }
+}
+
+void TileCache::cancelAll()
+{
+    for (const Job &job : std::as_const(m_pending)) {
+        *job.cancelled = true;
+    }
+    m_pending.clear();
+}
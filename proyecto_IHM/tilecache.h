@@ -0,0 +1,73 @@
+#ifndef TILECACHE_H
+#define TILECACHE_H
+
+#include <QCache>
+#include <QHash>
+#include <QImage>
+#include <QObject>
+#include <QPixmap>
+#include <QThreadPool>
+
+#include <atomic>
+#include <memory>
+
+class ChartTiles;
+
+// Teselas decodificadas de las cartas, con un presupuesto en bytes y expulsion de la menos usada
+// (QCache con coste en bytes). Nunca decodifica en el hilo de la interfaz, salvo el nivel mas
+// reducido de la carta, que cabe en una tesela y sirve de fondo mientras llegan las demas. Las
+// peticiones se decodifican en paralelo en un QThreadPool propio; lo que deja de hacer falta antes
+// de empezar se cancela, asi un barrido rapido no deja la cola llena de teselas que ya no se ven.
+//
+// Uso por fotograma: beginPass(), request() de lo visible y de lo que se quiera adelantar, endPass().
+class TileCache : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit TileCache(QObject *parent = nullptr);
+    ~TileCache() override;
+
+    // Por defecto 128 MB o PROYECTO_IHM_TILE_CACHE_MB
+    void setBudget(qint64 bytes);
+    qint64 budget() const { return m_tiles.maxCost(); }
+    qint64 usedBytes() const { return m_tiles.totalCost(); }
+    int pendingCount() const { return m_pending.size(); }
+
+    // Las teselas de otras cartas se quedan mientras alguna pizarra las use
+    void setChart(std::shared_ptr<ChartTiles> chart);
+    const QPixmap &overview() const { return m_overview; }
+
+    // Solo lo ya decodificado: nunca bloquea
+    QPixmap find(int level, int column, int row);
+
+    void beginPass();
+    // Encola la tesela si no esta ni en la cache ni en camino. visible = antes que las adelantadas.
+    void request(int level, int column, int row, bool visible);
+    // Cancela lo encolado que no se ha vuelto a pedir en esta pasada
+    void endPass();
+
+signals:
+    void tileReady(int level, int column, int row);
+
+private:
+    struct Job {
+        std::shared_ptr<std::atomic_bool> cancelled;
+        quint64 pass = 0;
+    };
+
+    quint64 key(int level, int column, int row) const;
+    void tileDecoded(quint64 tileKey, const std::shared_ptr<std::atomic_bool> &cancelled,
+                     int level, int column, int row, const QImage &image);
+    void cancelAll();
+
+    std::shared_ptr<ChartTiles> m_chart;
+    QPixmap m_overview;
+    QCache<quint64, QPixmap> m_tiles;                   // coste en bytes
+    QHash<quint32, std::weak_ptr<ChartTiles>> m_charts; // cartas con teselas en la cache
+    QHash<quint64, Job> m_pending;
+    quint64 m_pass = 0;
+    QThreadPool m_pool;
+};
+
+#endif // TILECACHE_H
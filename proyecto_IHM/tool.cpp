@@ -12,6 +12,7 @@
 
 Tool::Tool(const QString& svgResourcePath, QGraphicsItem* parent)
     : QGraphicsSvgItem(svgResourcePath, parent)
+    , m_renderCache(this, svgResourcePath)
 {
     // Flags para poder moverla, seleccionarla y que ignore las transformaciones del view
     setFlags(QGraphicsItem::ItemIsMovable
@@ -36,6 +37,7 @@ void Tool::setToolSize(const QSizeF& sizePx)
 void Tool::setView(QGraphicsView *view)
 {
     m_view = view;
+    viewTransformChanged();
 }
 
 void Tool::applyInitialScale()
@@ -48,50 +50,50 @@ void Tool::applyInitialScale()
     const double sy = m_targetSizePx.height() / br.height();
     m_uniformScale = std::min(sx, sy);
 
+    // setScale invalida por si mismo los limites antiguos y nuevos del item
     setScale(m_uniformScale);
     updateOrigin();
-
-    if (scene())
-        scene()->update();
 }
 
-void Tool::updateOrigin()
+void Tool::paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget)
 {
-    setTransformOriginPoint(boundingRect().center());
+    if (!m_renderCache.paint(painter, option)) {
+        QGraphicsSvgItem::paint(painter, option, widget);
+    }
 }
 
-Tool* Tool::toggleTool(Tool *&tool,
-                       QGraphicsScene *scene,
-                       QGraphicsView *view,
-                       const QString &resourcePath,
-                       const QSizeF &defaultSize,
-                       const QPoint &initialViewportPos,
-                       bool visible)
+QVariant Tool::itemChange(GraphicsItemChange change, const QVariant &value)
 {
-    if (!scene || !view) {
-        return tool;
+    switch (change) {
+    case ItemPositionHasChanged:
+    case ItemRotationHasChanged:
+    case ItemScaleHasChanged:
+        m_renderCache.touch();
+        break;
+    default:
+        break;
     }
+    return QGraphicsSvgItem::itemChange(change, value);
+}
 
-    if (!tool) {
-        tool = new Tool(resourcePath);
-        scene->addItem(tool);
-
-        if (defaultSize.width() > 0.0 && defaultSize.height() > 0.0) {
-            tool->setToolSize(defaultSize);
-        }
+void Tool::updateOrigin()
+{
+    setTransformOriginPoint(boundingRect().center());
+}
 
-        tool->setZValue(1000);
-        tool->setPos(view->mapToScene(initialViewportPos));
-    }
+void Tool::setToolRotation(double angleDeg)
+{
+    m_angleDeg = angleDeg;
+    setRotation(m_angleDeg);
+}
 
-    tool->setView(view);
-    tool->setVisible(visible);
-    if (visible) {
-        tool->setZValue(1000); // ensure on top si se reactiva
-        scene->update();
+QTransform Tool::itemToSceneTransform() const
+{
+    if (!m_view) {
+        return sceneTransform();
     }
-
-    return tool;
+    const QTransform viewport = m_view->viewportTransform();
+    return deviceTransform(viewport) * viewport.inverted();
 }
 
 void Tool::wheelEvent(QGraphicsSceneWheelEvent *event)
@@ -112,8 +114,6 @@ void Tool::wheelEvent(QGraphicsSceneWheelEvent *event)
         double deltaDegrees = (delta / 8.0) * 0.1; // ≈ 1.5° por "clic"
         m_angleDeg += deltaDegrees;
         setRotation(m_angleDeg);
-        if (scene())
-            scene()->update();
         event->accept();
         return;
     }
@@ -146,9 +146,6 @@ void Tool::wheelEvent(QGraphicsSceneWheelEvent *event)
     const QPointF deltaScene = invView.map(deltaViewport) - invView.map(QPointF(0.0, 0.0));
     setPos(pos() + deltaScene);
 
-    if (scene())
-        scene()->update();
-
     event->accept();
 }
 
@@ -3,12 +3,15 @@
 
 #include <QGraphicsSvgItem>
 #include <QGraphicsSceneWheelEvent>
+#include <QGraphicsScene>
+#include <QGraphicsView>
 #include <QSizeF>
 #include <QPoint>
 #include <QPointer>
+#include <QTransform>
+
+#include "toolrendercache.h"
 
-class QGraphicsScene;
-class QGraphicsView;
 class Tool : public QGraphicsSvgItem
 {
 public:
@@ -19,16 +22,35 @@ public:
     void setToolSize(const QSizeF& sizePx);
     void setView(QGraphicsView *view);
 
-    // Crea/actualiza una herramienta comun en escena y vista
-    static Tool* toggleTool(Tool *&tool,
-                            QGraphicsScene *scene,
-                            QGraphicsView *view,
-                            const QString &resourcePath,
-                            const QSizeF &defaultSize,
-                            const QPoint &initialViewportPos,
-                            bool visible);
+    // Llamar cuando cambia el zoom de la vista: al ignorar sus transformaciones, la herramienta
+    // cubre otra porcion de la carta aunque en pantalla no cambie
+    virtual void viewTransformChanged() {}
+
+    // Giro absoluto (grados, sentido horario) manteniendo la rueda sincronizada
+    void setToolRotation(double angleDeg);
+    double toolRotation() const { return m_angleDeg; }
+
+    // Crea/actualiza una herramienta comun en escena y vista (T: Tool o una subclase
+    // con el mismo constructor)
+    template <typename T>
+    static T* toggleTool(T *&tool,
+                         QGraphicsScene *scene,
+                         QGraphicsView *view,
+                         const QString &resourcePath,
+                         const QSizeF &defaultSize,
+                         const QPoint &initialViewportPos,
+                         bool visible);
+
+    void paint(QPainter *painter,
+               const QStyleOptionGraphicsItem *option,
+               QWidget *widget = nullptr) override;
 
 protected:
+    QGraphicsView *view() const { return m_view; }
+    // Con ItemIgnoresTransformations mapToScene no sirve: se pasa por la transformacion de la vista
+    QTransform itemToSceneTransform() const;
+
+    QVariant itemChange(GraphicsItemChange change, const QVariant &value) override;
     void wheelEvent(QGraphicsSceneWheelEvent *event) override;
     void mousePressEvent(QGraphicsSceneMouseEvent *event) override;
     void mouseReleaseEvent(QGraphicsSceneMouseEvent *event) override;
@@ -42,6 +64,41 @@ private:
     double m_angleDeg     = 0.0;
     bool m_dragCursorActive = false;
     QPointer<QGraphicsView> m_view;
+    ToolRenderCache m_renderCache;
 };
 
+template <typename T>
+T* Tool::toggleTool(T *&tool,
+                    QGraphicsScene *scene,
+                    QGraphicsView *view,
+                    const QString &resourcePath,
+                    const QSizeF &defaultSize,
+                    const QPoint &initialViewportPos,
+                    bool visible)
+{
+    if (!scene || !view) {
+        return tool;
+    }
+
+    if (!tool) {
+        tool = new T(resourcePath);
+        scene->addItem(tool);
+
+        if (defaultSize.width() > 0.0 && defaultSize.height() > 0.0) {
+            tool->setToolSize(defaultSize);
+        }
+
+        tool->setZValue(1000);
+        tool->setPos(view->mapToScene(initialViewportPos));
+    }
+
+    tool->setView(view);
+    tool->setVisible(visible);
+    if (visible) {
+        tool->setZValue(1000); // ensure on top si se reactiva
+    }
+
+    return tool;
+}
+
 #endif // TOOL_H
@@ -0,0 +1,96 @@
+#include "toolrendercache.h"
+
+#include <QGraphicsSvgItem>
+#include <QPaintDevice>
+#include <QPainter>
+#include <QPen>
+#include <QPixmap>
+#include <QPixmapCache>
+#include <QStyle>
+#include <QStyleOptionGraphicsItem>
+#include <QSvgRenderer>
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+// Escala efectiva redondeada hacia arriba a potencias de raiz de 2: nunca se amplia el pixmap
+// mas de un ~41 % y un mismo SVG tiene pocas variantes en cache
+double bucketScale(double scale)
+{
+    const double steps = std::ceil(std::log2(std::max(scale, 1.0 / 64.0)) * 2.0);
+    return std::pow(2.0, steps / 2.0);
+}
+}
+
+ToolRenderCache::ToolRenderCache(QGraphicsSvgItem *item, const QString &resourcePath)
+    : m_item(item)
+    , m_resourcePath(resourcePath)
+{
+    m_item->setCacheMode(QGraphicsItem::DeviceCoordinateCache);
+    m_settleTimer.setSingleShot(true);
+    m_settleTimer.setInterval(kSettleMs);
+    QObject::connect(&m_settleTimer, &QTimer::timeout, [this]() { settle(); });
+}
+
+void ToolRenderCache::touch()
+{
+    if (!m_interacting) {
+        m_interacting = true;
+        // La cache de dispositivo se invalidaria en cada giro: durante la interaccion pinta paint()
+        m_item->setCacheMode(QGraphicsItem::NoCache);
+    }
+    m_settleTimer.start();
+}
+
+void ToolRenderCache::settle()
+{
+    m_interacting = false;
+    m_item->setCacheMode(QGraphicsItem::DeviceCoordinateCache);
+    m_item->update();
+}
+
+bool ToolRenderCache::paint(QPainter *painter, const QStyleOptionGraphicsItem *option)
+{
+    if (!m_interacting) {
+        return false;
+    }
+
+    const QRectF bounds = m_item->boundingRect();
+    if (bounds.isEmpty() || !m_item->renderer() || !m_item->renderer()->isValid()) {
+        return false;
+    }
+
+    const double dpr = painter->device() ? painter->device()->devicePixelRatioF() : 1.0;
+    const double worldScale = std::sqrt(std::abs(painter->worldTransform().determinant()));
+    const double bucket = bucketScale(worldScale * dpr);
+
+    if (bucket != m_keyBucket) {
+        m_keyBucket = bucket;
+        m_key = QStringLiteral("toolrender:%1@%2").arg(m_resourcePath).arg(bucket, 0, 'g', 6);
+    }
+    QPixmap pixmap;
+    if (!QPixmapCache::find(m_key, &pixmap)) {
+        const QSize pixelSize = (bounds.size() * bucket).toSize().expandedTo(QSize(1, 1));
+        pixmap = QPixmap(pixelSize);
+        pixmap.fill(Qt::transparent);
+        QPainter p(&pixmap);
+        p.setRenderHint(QPainter::Antialiasing, true);
+        m_item->renderer()->render(&p, QRectF(QPointF(0.0, 0.0), QSizeF(pixelSize)));
+        p.end();
+        QPixmapCache::insert(m_key, pixmap);
+    }
+
+    const bool smooth = painter->testRenderHint(QPainter::SmoothPixmapTransform);
+    painter->setRenderHint(QPainter::SmoothPixmapTransform, true);
+    painter->drawPixmap(bounds, pixmap, QRectF(pixmap.rect()));
+    painter->setRenderHint(QPainter::SmoothPixmapTransform, smooth);
+
+    // Mismo aviso de seleccion que QGraphicsSvgItem (contorno discontinuo)
+    if (option && (option->state & QStyle::State_Selected)) {
+        painter->setPen(QPen(option->palette.windowText(), 0, Qt::DashLine));
+        painter->setBrush(Qt::NoBrush);
+        painter->drawRect(bounds);
+    }
+    return true;
+}
@@ -0,0 +1,44 @@
+#ifndef TOOLRENDERCACHE_H
+#define TOOLRENDERCACHE_H
+
+#include <QString>
+#include <QTimer>
+
+class QGraphicsSvgItem;
+class QPainter;
+class QStyleOptionGraphicsItem;
+
+// Cache de rasterizado para las herramientas SVG (regla, transportador, patas del compas).
+//
+// En reposo el item usa DeviceCoordinateCache: se rasteriza una vez a la resolucion exacta y
+// moverlo sin girarlo reutiliza ese pixmap. Mientras se mueve, gira o escala, pinta un pixmap
+// compartido rasterizado una sola vez por escala efectiva (redondeada a saltos de raiz de 2) y
+// devicePixelRatio; al quedarse quieto kSettleMs vuelve a la cache de dispositivo, nitida.
+class ToolRenderCache
+{
+public:
+    ToolRenderCache(QGraphicsSvgItem *item, const QString &resourcePath);
+
+    // Llamar en cada cambio de posicion, rotacion o escala del item (o de su padre)
+    void touch();
+    bool interacting() const { return m_interacting; }
+
+    // Pinta desde el pixmap compartido si hay una interaccion en curso. Devuelve false en reposo,
+    // y entonces el item debe pintar el SVG normalmente.
+    bool paint(QPainter *painter, const QStyleOptionGraphicsItem *option);
+
+private:
+    void settle();
+
+    static constexpr int kSettleMs = 150;
+
+    QGraphicsSvgItem *m_item = nullptr;
+    QString m_resourcePath;
+    // Clave del pixmap compartido para la ultima escala: solo se rehace al cambiar de salto
+    double m_keyBucket = 0.0;
+    QString m_key;
+    QTimer m_settleTimer;
+    bool m_interacting = false;
+};
+
+#endif // TOOLRENDERCACHE_H
@@ -0,0 +1,82 @@
+// Corta la piramide de teselas de una carta para el catalogo (campo "tiles"): un directorio por
+// nivel con una JPEG por tesela, <nivel>/<columna>_<fila>.jpg. Con la piramide cortada la
+// aplicacion lee cada tesela de su fichero en vez de recortarla de la imagen original.
+//
+//   proyecto_IHM_charttiler --image carta.jpg --out carta_tiles --quality 85
+
+#include "charttiles.h"
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QImage>
+#include <QTextStream>
+
+#include <algorithm>
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName(QStringLiteral("proyecto_IHM_charttiler"));
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(
+        QStringLiteral("Corta la piramide de teselas de una carta para el catalogo de cartas."));
+    parser.addHelpOption();
+    const QCommandLineOption imageOpt(QStringList{QStringLiteral("i"), QStringLiteral("image")},
+                                      QStringLiteral("Imagen de la carta."), QStringLiteral("fichero"));
+    const QCommandLineOption outOpt(QStringList{QStringLiteral("o"), QStringLiteral("out")},
+                                    QStringLiteral("Directorio de la piramide."), QStringLiteral("directorio"));
+    const QCommandLineOption qualityOpt(QStringLiteral("quality"),
+                                        QStringLiteral("Calidad JPEG de las teselas [1-100]."),
+                                        QStringLiteral("Q"), QStringLiteral("85"));
+    parser.addOptions({imageOpt, outOpt, qualityOpt});
+    parser.process(app);
+
+    QTextStream err(stderr);
+    if (!parser.isSet(imageOpt) || !parser.isSet(outOpt)) {
+        err << "faltan --image y --out\n";
+        return 1;
+    }
+    const int quality = std::clamp(parser.value(qualityOpt).toInt(), 1, 100);
+
+    ChartInfo info;
+    info.imagePath = parser.value(imageOpt);
+    const ChartTiles chart(info);
+    if (chart.isNull()) {
+        err << "no se pudo leer " << info.imagePath << '\n';
+        return 1;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+
+    // Cada nivel se reduce del anterior: la imagen original se decodifica una sola vez
+    QImage level = QImage(info.imagePath).convertToFormat(QImage::Format_RGB32);
+    const QDir out(parser.value(outOpt));
+    int written = 0;
+    for (int l = 0; l < chart.levelCount(); ++l) {
+        if (l > 0) {
+            level = level.scaled(chart.levelSize(l), Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+        }
+        const QString levelDir = QString::number(l);
+        if (!out.mkpath(levelDir)) {
+            err << "no se pudo crear " << out.filePath(levelDir) << '\n';
+            return 1;
+        }
+        for (int row = 0; row < chart.rows(l); ++row) {
+            for (int column = 0; column < chart.columns(l); ++column) {
+                const QString path = out.filePath(QStringLiteral("%1/%2_%3.jpg").arg(l).arg(column).arg(row));
+                if (!level.copy(chart.tilePixels(l, column, row)).save(path, "JPG", quality)) {
+                    err << "no se pudo escribir " << path << '\n';
+                    return 1;
+                }
+                ++written;
+            }
+        }
+    }
+
+    err << written << " teselas en " << chart.levelCount() << " niveles (" << timer.elapsed() << " ms)\n";
+    return 0;
+}
@@ -0,0 +1,174 @@
+// Reproduce un registro de entrada grabado con PROYECTO_IHM_RECORD contra una MainWindow real.
+//
+//   PROYECTO_IHM_RECORD=/tmp/sesion.pihmrec ./proyecto_IHM        (grabar)
+//   ./proyecto_IHM_replay /tmp/sesion.pihmrec [--realtime] [--repeat N] [--latency-json ruta]
+//
+// Por defecto usa la plataforma offscreen y envia los eventos tan rapido como se procesan,
+// dejando que cada uno se pinte antes del siguiente. Con --realtime respeta los tiempos grabados.
+
+#include "chartview.h"
+#include "inputrecorder.h"
+#include "mainwindow.h"
+
+#include <QApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QFile>
+#include <QFont>
+#include <QFontDatabase>
+#include <QScrollBar>
+#include <QTextStream>
+#include <QTimer>
+
+#include <algorithm>
+#include <memory>
+
+namespace {
+void applyResources(QApplication &app)
+{
+    QFontDatabase::addApplicationFont(QStringLiteral(":/fonts/Inter-Regular.ttf"));
+    QFontDatabase::addApplicationFont(QStringLiteral(":/fonts/Inter-SemiBold.ttf"));
+    QFontDatabase::addApplicationFont(QStringLiteral(":/fonts/Inter-Bold.ttf"));
+    app.setFont(QFont(QStringLiteral("Inter")));
+
+    QFile file(QStringLiteral(":/stylesheet.qss"));
+    if (file.open(QFile::ReadOnly | QFile::Text)) {
+        app.setStyleSheet(QTextStream(&file).readAll());
+    }
+}
+
+void waitUntil(const QElapsedTimer &clock, qint64 timestampUs)
+{
+    const qint64 waitMs = (timestampUs - clock.nsecsElapsed() / 1000) / 1000;
+    if (waitMs <= 0) {
+        QCoreApplication::processEvents();
+        return;
+    }
+    QEventLoop loop;
+    QTimer::singleShot(static_cast<int>(waitMs), Qt::PreciseTimer, &loop, &QEventLoop::quit);
+    loop.exec();
+}
+
+void resizeViewport(MainWindow &w, QWidget *viewport, const QSize &target)
+{
+    if (!target.isValid() || viewport->size() == target) {
+        return;
+    }
+    w.resize(w.size() + (target - viewport->size()));
+    QCoreApplication::processEvents();
+}
+}
+
+int main(int argc, char *argv[])
+{
+    if (!qEnvironmentVariableIsSet("QT_QPA_PLATFORM")) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+    // La grabacion no debe reactivarse al reproducir
+    qunsetenv("PROYECTO_IHM_RECORD");
+
+    QApplication app(argc, argv);
+    QCoreApplication::setApplicationName(QStringLiteral("proyecto_IHM_replay"));
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(QStringLiteral("Reproduce un registro de entrada de proyecto_IHM"));
+    parser.addHelpOption();
+    parser.addPositionalArgument(QStringLiteral("registro"), QStringLiteral("Fichero grabado con PROYECTO_IHM_RECORD"));
+    const QCommandLineOption realtimeOpt(QStringLiteral("realtime"),
+                                         QStringLiteral("Respeta los tiempos grabados entre eventos"));
+    const QCommandLineOption repeatOpt(QStringLiteral("repeat"),
+                                       QStringLiteral("Numero de pasadas (por defecto 1)"),
+                                       QStringLiteral("n"), QStringLiteral("1"));
+    const QCommandLineOption latencyOpt(QStringLiteral("latency-json"),
+                                        QStringLiteral("Guarda los percentiles de latencia al terminar"),
+                                        QStringLiteral("ruta"));
+    parser.addOptions({realtimeOpt, repeatOpt, latencyOpt});
+    parser.process(app);
+
+    if (parser.positionalArguments().size() != 1) {
+        parser.showHelp(1);
+    }
+
+    InputLog log;
+    QString error;
+    if (!log.load(parser.positionalArguments().constFirst(), &error)) {
+        QTextStream(stderr) << "No se pudo leer el registro: " << error << '\n';
+        return 1;
+    }
+    if (parser.isSet(latencyOpt)) {
+        // MainWindow escribe el JSON de latencias en su destructor
+        qputenv("PROYECTO_IHM_LATENCY_JSON", parser.value(latencyOpt).toLocal8Bit());
+    }
+
+    applyResources(app);
+
+    const bool realtime = parser.isSet(realtimeOpt);
+    const int repeat = std::max(1, parser.value(repeatOpt).toInt());
+
+    qint64 totalNs = 0;
+    qint64 totalEvents = 0;
+    {
+        MainWindow w;
+        w.suppressStartupLoginPrompt();
+        w.show();
+        QCoreApplication::processEvents();
+
+        auto *view = w.findChild<ChartView *>();
+        if (!view) {
+            QTextStream(stderr) << "MainWindow sin ChartView\n";
+            return 1;
+        }
+        QWidget *viewport = view->viewport();
+
+        for (int pass = 0; pass < repeat; ++pass) {
+            QElapsedTimer clock;
+            clock.start();
+            for (const RecordedEvent &ev : log.events()) {
+                if (realtime) {
+                    waitUntil(clock, ev.timestampUs);
+                }
+                w.setInteractionMode(ev.mode);
+
+                switch (ev.type) {
+                case RecordedEvent::Type::Resize:
+                    resizeViewport(w, viewport, ev.size);
+                    break;
+                case RecordedEvent::Type::ViewState:
+                    w.setZoom(ev.zoom);
+                    view->horizontalScrollBar()->setValue(ev.scroll.x());
+                    view->verticalScrollBar()->setValue(ev.scroll.y());
+                    break;
+                case RecordedEvent::Type::KeyPress:
+                case RecordedEvent::Type::KeyRelease:
+                    // Las teclas se grabaron en la vista, que es quien tiene el foco
+                    if (const std::unique_ptr<QEvent> qev = ev.toEvent(viewport)) {
+                        QCoreApplication::sendEvent(view, qev.get());
+                        ++totalEvents;
+                    }
+                    break;
+                default:
+                    if (const std::unique_ptr<QEvent> qev = ev.toEvent(viewport)) {
+                        QCoreApplication::sendEvent(viewport, qev.get());
+                        ++totalEvents;
+                    }
+                    break;
+                }
+                if (!realtime) {
+                    // Deja que se pinte el resultado antes del siguiente evento
+                    QCoreApplication::processEvents();
+                }
+            }
+            QCoreApplication::processEvents();
+            totalNs += clock.nsecsElapsed();
+        }
+    }
+
+    const double seconds = totalNs / 1.0e9;
+    QTextStream(stdout) << "eventos: " << totalEvents
+                        << "  pasadas: " << repeat
+                        << "  tiempo: " << QString::number(seconds, 'f', 3) << " s"
+                        << "  eventos/s: "
+                        << QString::number(seconds > 0 ? totalEvents / seconds : 0.0, 'f', 0) << '\n';
+    return 0;
+}
@@ -0,0 +1,295 @@
+// Administracion por lotes de navdb sin interfaz grafica.
+// Solo usa QCoreApplication: no se cargan estilos, fuentes ni la carta, asi que arranca al instante.
+//
+//   proyecto_IHM_admin [--db navdb.sqlite] import-problems [--replace] problemas.csv
+//   proyecto_IHM_admin create-users alumnos.csv
+//   proyecto_IHM_admin export-results - > resultados.csv
+//
+// Los CSV usan ';' como separador (como Excel en espanol) y admiten campos entre comillas.
+// '-' como fichero significa entrada o salida estandar; las filas se procesan en streaming.
+
+#include "navdaoexception.h"
+#include "navigationdao.h"
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QFile>
+#include <QImage>
+#include <QStringList>
+#include <QTextStream>
+
+#include <algorithm>
+#include <memory>
+
+namespace {
+constexpr int kDefaultBatch = 500;
+
+struct Stats {
+    qint64 ok = 0;
+    qint64 skipped = 0;
+};
+
+// Divide una fila CSV respetando comillas dobles ("" dentro de un campo entrecomillado es una comilla)
+QStringList splitCsvLine(const QString &line, QChar sep)
+{
+    QStringList fields;
+    QString field;
+    bool quoted = false;
+    for (qsizetype i = 0; i < line.size(); ++i) {
+        const QChar c = line.at(i);
+        if (quoted) {
+            if (c == QLatin1Char('"')) {
+                if (i + 1 < line.size() && line.at(i + 1) == QLatin1Char('"')) {
+                    field.append(c);
+                    ++i;
+                } else {
+                    quoted = false;
+                }
+            } else {
+                field.append(c);
+            }
+        } else if (c == QLatin1Char('"')) {
+            quoted = true;
+        } else if (c == sep) {
+            fields.append(field);
+            field.clear();
+        } else {
+            field.append(c);
+        }
+    }
+    fields.append(field);
+    return fields;
+}
+
+QString csvField(const QString &value, QChar sep)
+{
+    if (!value.contains(sep) && !value.contains(QLatin1Char('"')) && !value.contains(QLatin1Char('\n'))) {
+        return value;
+    }
+    QString escaped = value;
+    escaped.replace(QLatin1String("\""), QLatin1String("\"\""));
+    return QLatin1Char('"') + escaped + QLatin1Char('"');
+}
+
+bool parseBool(const QString &s)
+{
+    const QString v = s.trimmed().toLower();
+    return v == QLatin1String("1") || v == QLatin1String("true")
+           || v == QLatin1String("si") || v == QStringLiteral("sí") || v == QLatin1String("x");
+}
+
+std::unique_ptr<QFile> openStream(const QString &path, QIODevice::OpenMode mode)
+{
+    auto file = std::make_unique<QFile>();
+    bool ok = false;
+    if (path == QLatin1String("-")) {
+        ok = file->open((mode & QIODevice::WriteOnly) ? stdout : stdin, mode);
+    } else {
+        file->setFileName(path);
+        ok = file->open(mode);
+    }
+    if (!ok) {
+        return nullptr;
+    }
+    return file;
+}
+
+// Ejecuta fn sobre cada fila no vacia que no sea un comentario
+template <typename RowFn>
+void forEachRow(QTextStream &in, QChar sep, RowFn fn)
+{
+    QString line;
+    while (in.readLineInto(&line)) {
+        if (line.trimmed().isEmpty() || line.startsWith(QLatin1Char('#'))) {
+            continue;
+        }
+        fn(splitCsvLine(line, sep));
+    }
+}
+
+// Ejecuta fn sobre cada fila no vacia, agrupando batch filas por transaccion
+template <typename RowFn>
+void forEachRowInBatches(QTextStream &in, NavigationDAO &dao, int batch, QChar sep, RowFn fn)
+{
+    int inBatch = 0;
+    dao.beginTransaction();
+    try {
+        forEachRow(in, sep, [&](const QStringList &fields) {
+            fn(fields);
+            if (++inBatch >= batch) {
+                dao.commitTransaction();
+                dao.beginTransaction();
+                inBatch = 0;
+            }
+        });
+        dao.commitTransaction();
+    } catch (...) {
+        dao.rollbackTransaction();
+        throw;
+    }
+}
+
+Stats importProblems(NavigationDAO &dao, QTextStream &in, bool replace, int batch, QChar sep,
+                     QTextStream &err)
+{
+    Stats stats;
+    QVector<Problem> pending;
+    pending.reserve(batch);
+    const auto flush = [&] {
+        dao.addProblems(pending);
+        stats.ok += pending.size();
+        pending.clear();
+    };
+
+    // Con replace el borrado y todas las altas van en una sola transaccion: si la importacion
+    // falla, la tabla se queda como estaba. Sin replace se confirma cada lote.
+    dao.beginTransaction();
+    try {
+        if (replace) {
+            dao.replaceAllProblems({});
+        }
+        forEachRow(in, sep, [&](const QStringList &f) {
+            if (f.size() < 9) {
+                ++stats.skipped;
+                err << "Fila de problema incompleta (" << f.size() << " campos), se omite" << Qt::endl;
+                return;
+            }
+            QVector<Answer> answers;
+            answers.reserve(4);
+            for (int a = 0; a < 4; ++a) {
+                answers.push_back(Answer(f.at(1 + a * 2).trimmed(), parseBool(f.at(2 + a * 2))));
+            }
+            pending.push_back(Problem(f.at(0).trimmed(), answers));
+            if (pending.size() >= batch) {
+                flush();
+                if (!replace) {
+                    dao.commitTransaction();
+                    dao.beginTransaction();
+                }
+            }
+        });
+        if (!pending.isEmpty()) {
+            flush();
+        }
+        dao.commitTransaction();
+    } catch (...) {
+        dao.rollbackTransaction();
+        throw;
+    }
+    return stats;
+}
+
+Stats createUsers(NavigationDAO &dao, QTextStream &in, int batch, QChar sep, QTextStream &err)
+{
+    Stats stats;
+    forEachRowInBatches(in, dao, batch, sep, [&](const QStringList &f) {
+        if (f.size() < 4 || f.at(0).trimmed().isEmpty()) {
+            ++stats.skipped;
+            err << "Fila de usuario incompleta, se omite" << Qt::endl;
+            return;
+        }
+        const QDate birth = QDate::fromString(f.at(3).trimmed(), Qt::ISODate);
+        QImage avatar;
+        if (f.size() > 4 && !f.at(4).trimmed().isEmpty()) {
+            avatar.load(f.at(4).trimmed());
+        }
+        User user(f.at(0).trimmed(), f.at(1).trimmed(), f.at(2), avatar, birth);
+        try {
+            dao.saveUser(user);
+            ++stats.ok;
+        } catch (const NavDAOException &ex) {
+            // Un nick duplicado no aborta la transaccion en SQLite: seguimos con el resto
+            ++stats.skipped;
+            err << "No se pudo crear " << user.nickName() << ": " << ex.what() << Qt::endl;
+        }
+    });
+    return stats;
+}
+
+Stats exportResults(NavigationDAO &dao, QTextStream &out, QChar sep)
+{
+    Stats stats;
+    out << "nick" << sep << "fecha" << sep << "aciertos" << sep << "fallos" << '\n';
+    dao.forEachSession([&](const QString &nick, const Session &s) {
+        out << csvField(nick, sep) << sep
+            << s.timeStamp().toString(Qt::ISODate) << sep
+            << s.hits() << sep
+            << s.faults() << '\n';
+        ++stats.ok;
+    });
+    out.flush();
+    return stats;
+}
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName(QStringLiteral("proyecto_IHM_admin"));
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(QStringLiteral(
+        "Operaciones por lotes sobre navdb sin interfaz grafica.\n\n"
+        "Comandos:\n"
+        "  import-problems <csv>  texto;resp1;ok1;resp2;ok2;resp3;ok3;resp4;ok4\n"
+        "  create-users <csv>     nick;email;password;aaaa-mm-dd[;avatar.png]\n"
+        "  export-results <csv>   escribe nick;fecha;aciertos;fallos"));
+    parser.addHelpOption();
+    const QCommandLineOption dbOpt(QStringList{QStringLiteral("d"), QStringLiteral("db")},
+                                   QStringLiteral("Base de datos (por defecto, la de la aplicacion)."),
+                                   QStringLiteral("fichero"),
+                                   QCoreApplication::applicationDirPath() + QStringLiteral("/navdb.sqlite"));
+    const QCommandLineOption replaceOpt(QStringLiteral("replace"),
+                                        QStringLiteral("import-problems: borra antes los problemas existentes."));
+    const QCommandLineOption batchOpt(QStringLiteral("batch"),
+                                      QStringLiteral("Filas por transaccion."), QStringLiteral("N"),
+                                      QString::number(kDefaultBatch));
+    const QCommandLineOption sepOpt(QStringLiteral("sep"),
+                                    QStringLiteral("Separador CSV."), QStringLiteral("caracter"),
+                                    QStringLiteral(";"));
+    parser.addOptions({dbOpt, replaceOpt, batchOpt, sepOpt});
+    parser.addPositionalArgument(QStringLiteral("comando"), QStringLiteral("Operacion a realizar."));
+    parser.addPositionalArgument(QStringLiteral("fichero"), QStringLiteral("CSV de entrada/salida ('-' = stdin/stdout)."));
+    parser.process(app);
+
+    const QStringList positional = parser.positionalArguments();
+    if (positional.size() != 2) {
+        parser.showHelp(2);
+    }
+    const QString command = positional.at(0);
+    const QString path = positional.at(1);
+    const int batch = std::max(1, parser.value(batchOpt).toInt());
+    const QString sepValue = parser.value(sepOpt);
+    const QChar sep = sepValue.isEmpty() ? QLatin1Char(';') : sepValue.at(0);
+
+    QTextStream err(stderr);
+    const bool writes = (command == QLatin1String("export-results"));
+    const auto stream = openStream(path, writes ? (QIODevice::WriteOnly | QIODevice::Text)
+                                                : (QIODevice::ReadOnly | QIODevice::Text));
+    if (!stream) {
+        err << "No se pudo abrir " << path << Qt::endl;
+        return 1;
+    }
+    QTextStream io(stream.get());
+
+    try {
+        NavigationDAO dao(parser.value(dbOpt));
+        Stats stats;
+        if (command == QLatin1String("import-problems")) {
+            stats = importProblems(dao, io, parser.isSet(replaceOpt), batch, sep, err);
+        } else if (command == QLatin1String("create-users")) {
+            stats = createUsers(dao, io, batch, sep, err);
+        } else if (command == QLatin1String("export-results")) {
+            stats = exportResults(dao, io, sep);
+        } else {
+            err << "Comando desconocido: " << command << Qt::endl;
+            return 2;
+        }
+        err << command << ": " << stats.ok << " filas procesadas, "
+            << stats.skipped << " omitidas" << Qt::endl;
+    } catch (const NavDAOException &ex) {
+        err << "Error de base de datos: " << ex.what() << Qt::endl;
+        return 1;
+    }
+    return 0;
+}
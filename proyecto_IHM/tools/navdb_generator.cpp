@@ -0,0 +1,238 @@
+// Rellena una base de datos navdb con datos sinteticos a traves de NavigationDAO.
+// Pensado para reproducir los arranques lentos de escuelas con muchos alumnos.
+//
+//   proyecto_IHM_navdbgen --db grande.sqlite --users 5000 --sessions 80 --years 4 --problems 300
+
+#include "navdaoexception.h"
+#include "navigationdao.h"
+
+#include <QAtomicInt>
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QImage>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QRandomGenerator>
+#include <QTextStream>
+#include <QThread>
+#include <QThreadPool>
+
+#include <algorithm>
+#include <utility>
+
+namespace {
+struct GeneratorConfig {
+    QString dbPath;
+    int users = 500;
+    double avatarRatio = 0.5;
+    int sessionsPerUser = 40;
+    int years = 3;
+    int problems = 200;
+    int batchSize = 100;
+    quint32 seed = 1;
+};
+
+QString nickFor(int index)
+{
+    return QStringLiteral("alumno%1").arg(index, 6, 10, QLatin1Char('0'));
+}
+
+// Avatar de 128x128 distinto por usuario (degradado + ruido) para que el PNG tenga un tamano realista
+QImage makeAvatar(QRandomGenerator &rng)
+{
+    constexpr int kSize = 128;
+    QImage img(kSize, kSize, QImage::Format_RGB32);
+    const int r0 = rng.bounded(256);
+    const int g0 = rng.bounded(256);
+    const int b0 = rng.bounded(256);
+    for (int y = 0; y < kSize; ++y) {
+        auto *line = reinterpret_cast<QRgb*>(img.scanLine(y));
+        for (int x = 0; x < kSize; ++x) {
+            const int noise = rng.bounded(24);
+            line[x] = qRgb((r0 + x + noise) & 0xff,
+                           (g0 + y + noise) & 0xff,
+                           (b0 + x + y) & 0xff);
+        }
+    }
+    return img;
+}
+
+Problem makeProblem(int index, QRandomGenerator &rng)
+{
+    const int valid = rng.bounded(4);
+    QVector<Answer> answers;
+    answers.reserve(4);
+    for (int a = 0; a < 4; ++a) {
+        answers.push_back(Answer(QStringLiteral("Respuesta %1 del problema %2").arg(a + 1).arg(index + 1),
+                                 a == valid));
+    }
+    return Problem(QStringLiteral("Problema sintetico %1: calcula el rumbo verdadero entre los puntos A y B.")
+                       .arg(index + 1),
+                   answers);
+}
+
+// Espera maxima al bloqueo de escritura de otro lote
+constexpr int kBusyTimeoutMs = 10000;
+
+struct GeneratedUser {
+    User user;
+    QByteArray avatarPng;
+    QVector<Session> sessions;
+};
+
+// Cada lote genera sus usuarios y codifica los avatares antes de abrir la transaccion: esa parte
+// va en paralelo entre lotes y el bloqueo de escritura de SQLite solo cubre los INSERT
+void writeUserBatch(const GeneratorConfig &cfg, int first, int count)
+{
+    QRandomGenerator rng(cfg.seed * 7919u + static_cast<quint32>(first));
+    const QDateTime now = QDateTime::currentDateTime();
+    const qint64 spanSecs = qint64(cfg.years) * 365 * 24 * 3600;
+
+    QVector<GeneratedUser> batch;
+    batch.reserve(count);
+    for (int i = first; i < first + count; ++i) {
+        const bool withAvatar = rng.generateDouble() < cfg.avatarRatio;
+        GeneratedUser generated{User(nickFor(i),
+                                     QStringLiteral("%1@escuela.es").arg(nickFor(i)),
+                                     QStringLiteral("Passw0rd!%1").arg(i % 10),
+                                     QImage(),
+                                     QDate(1970 + rng.bounded(35), 1 + rng.bounded(12), 1 + rng.bounded(28))),
+                                withAvatar ? NavigationDAO::imageToPng(makeAvatar(rng)) : QByteArray(),
+                                {}};
+        generated.sessions.reserve(cfg.sessionsPerUser);
+        for (int s = 0; s < cfg.sessionsPerUser; ++s) {
+            const qint64 back = spanSecs > 0 ? rng.bounded(spanSecs) : 0;
+            const int hits = rng.bounded(21);
+            generated.sessions.append(Session(now.addSecs(-back), hits, 20 - hits));
+        }
+        batch.append(std::move(generated));
+    }
+
+    // Cada lote abre su propia conexion (NavigationDAO usa un nombre unico)
+    NavigationDAO dao(cfg.dbPath, kBusyTimeoutMs);
+    dao.beginTransaction();
+    try {
+        for (GeneratedUser &generated : batch) {
+            dao.saveUser(generated.user, generated.avatarPng);
+            for (const Session &session : std::as_const(generated.sessions)) {
+                dao.addSession(generated.user.nickName(), session);
+            }
+        }
+        dao.commitTransaction();
+    } catch (...) {
+        dao.rollbackTransaction();
+        throw;
+    }
+}
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName(QStringLiteral("proyecto_IHM_navdbgen"));
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(
+        QStringLiteral("Genera una base de datos navdb sintetica con usuarios, sesiones y problemas."));
+    parser.addHelpOption();
+    const QCommandLineOption dbOpt(QStringList{QStringLiteral("d"), QStringLiteral("db")},
+                                   QStringLiteral("Fichero SQLite de destino."), QStringLiteral("fichero"),
+                                   QStringLiteral("navdb.sqlite"));
+    const QCommandLineOption usersOpt(QStringList{QStringLiteral("u"), QStringLiteral("users")},
+                                      QStringLiteral("Numero de usuarios (N)."), QStringLiteral("N"),
+                                      QStringLiteral("500"));
+    const QCommandLineOption avatarOpt(QStringLiteral("avatar-ratio"),
+                                       QStringLiteral("Fraccion de usuarios con avatar [0-1]."),
+                                       QStringLiteral("ratio"), QStringLiteral("0.5"));
+    const QCommandLineOption sessionsOpt(QStringList{QStringLiteral("s"), QStringLiteral("sessions")},
+                                         QStringLiteral("Sesiones por usuario (M)."), QStringLiteral("M"),
+                                         QStringLiteral("40"));
+    const QCommandLineOption yearsOpt(QStringLiteral("years"),
+                                      QStringLiteral("Anos sobre los que se reparten las sesiones."),
+                                      QStringLiteral("anos"), QStringLiteral("3"));
+    const QCommandLineOption problemsOpt(QStringList{QStringLiteral("p"), QStringLiteral("problems")},
+                                         QStringLiteral("Numero de problemas (K); sustituye los existentes."),
+                                         QStringLiteral("K"), QStringLiteral("200"));
+    const QCommandLineOption batchOpt(QStringLiteral("batch"),
+                                      QStringLiteral("Usuarios por transaccion."), QStringLiteral("B"),
+                                      QStringLiteral("100"));
+    const QCommandLineOption threadsOpt(QStringLiteral("threads"),
+                                        QStringLiteral("Hilos de escritura."), QStringLiteral("T"),
+                                        QString::number(QThread::idealThreadCount()));
+    const QCommandLineOption seedOpt(QStringLiteral("seed"),
+                                     QStringLiteral("Semilla para datos reproducibles."),
+                                     QStringLiteral("semilla"), QStringLiteral("1"));
+    parser.addOptions({dbOpt, usersOpt, avatarOpt, sessionsOpt, yearsOpt, problemsOpt,
+                       batchOpt, threadsOpt, seedOpt});
+    parser.process(app);
+
+    GeneratorConfig cfg;
+    cfg.dbPath = QFileInfo(parser.value(dbOpt)).absoluteFilePath();
+    cfg.users = std::max(0, parser.value(usersOpt).toInt());
+    cfg.avatarRatio = std::clamp(parser.value(avatarOpt).toDouble(), 0.0, 1.0);
+    cfg.sessionsPerUser = std::max(0, parser.value(sessionsOpt).toInt());
+    cfg.years = std::max(0, parser.value(yearsOpt).toInt());
+    cfg.problems = std::max(0, parser.value(problemsOpt).toInt());
+    cfg.batchSize = std::max(1, parser.value(batchOpt).toInt());
+    cfg.seed = parser.value(seedOpt).toUInt();
+
+    QTextStream err(stderr);
+    QElapsedTimer timer;
+    timer.start();
+
+    try {
+        // Crea el esquema antes de lanzar los lotes y escribe los problemas
+        NavigationDAO dao(cfg.dbPath, kBusyTimeoutMs);
+        if (cfg.problems > 0) {
+            QRandomGenerator rng(cfg.seed);
+            QVector<Problem> problems;
+            problems.reserve(cfg.problems);
+            for (int i = 0; i < cfg.problems; ++i) {
+                problems.push_back(makeProblem(i, rng));
+            }
+            dao.beginTransaction();
+            dao.replaceAllProblems(problems);
+            dao.commitTransaction();
+        }
+    } catch (const NavDAOException &ex) {
+        err << "Error preparando la base de datos: " << ex.what() << Qt::endl;
+        return 1;
+    }
+
+    QThreadPool pool;
+    pool.setMaxThreadCount(std::max(1, parser.value(threadsOpt).toInt()));
+
+    QAtomicInt doneUsers = 0;
+    QMutex errorMutex;
+    QString firstError;
+    for (int first = 0; first < cfg.users; first += cfg.batchSize) {
+        const int count = std::min(cfg.batchSize, cfg.users - first);
+        pool.start([&, first, count]() {
+            try {
+                writeUserBatch(cfg, first, count);
+                const int done = doneUsers.fetchAndAddRelaxed(count) + count;
+                QMutexLocker locker(&errorMutex);
+                err << "\r" << done << "/" << cfg.users << " usuarios" << Qt::flush;
+            } catch (const NavDAOException &ex) {
+                QMutexLocker locker(&errorMutex);
+                if (firstError.isEmpty()) {
+                    firstError = QString::fromUtf8(ex.what());
+                }
+            }
+        });
+    }
+    pool.waitForDone();
+    err << Qt::endl;
+
+    if (!firstError.isEmpty()) {
+        err << "Error escribiendo usuarios: " << firstError << Qt::endl;
+        return 1;
+    }
+
+    err << "Generados " << cfg.users << " usuarios, "
+        << qint64(cfg.users) * cfg.sessionsPerUser << " sesiones y "
+        << cfg.problems << " problemas en " << timer.elapsed() << " ms -> " << cfg.dbPath << Qt::endl;
+    return 0;
+}
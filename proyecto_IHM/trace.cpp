@@ -0,0 +1,139 @@
+#include "trace.h"
+
+#include <QByteArray>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QString>
+#include <QThread>
+#include <QVector>
+
+namespace {
+struct TraceEvent {
+    const char *name;
+    long long startNs;
+    long long durationNs; // -1 para eventos instantaneos
+    quintptr threadId;
+};
+
+QElapsedTimer &traceClock()
+{
+    static QElapsedTimer timer;
+    return timer;
+}
+
+QMutex &eventsMutex()
+{
+    static QMutex mutex;
+    return mutex;
+}
+
+QVector<TraceEvent> &events()
+{
+    static QVector<TraceEvent> list;
+    return list;
+}
+
+QString &outputPath()
+{
+    static QString path;
+    return path;
+}
+
+void append(const TraceEvent &ev)
+{
+    QMutexLocker locker(&eventsMutex());
+    events().append(ev);
+}
+
+void appendJsonString(QByteArray &out, const char *s)
+{
+    out.append('"');
+    for (; *s; ++s) {
+        if (*s == '"' || *s == '\\') {
+            out.append('\\');
+        }
+        out.append(*s);
+    }
+    out.append('"');
+}
+}
+
+namespace Trace {
+namespace detail {
+bool g_enabled = false;
+
+long long nowNs()
+{
+    return traceClock().nsecsElapsed();
+}
+
+void record(const char *name, long long startNs, long long endNs)
+{
+    append({name, startNs, endNs - startNs, reinterpret_cast<quintptr>(QThread::currentThreadId())});
+}
+}
+
+void initFromEnvironment()
+{
+    const QString path = qEnvironmentVariable("PROYECTO_IHM_TRACE");
+    if (path.isEmpty()) {
+        return;
+    }
+    outputPath() = path;
+    events().reserve(256);
+    traceClock().start();
+    detail::g_enabled = true;
+}
+
+void instant(const char *name)
+{
+    if (!isEnabled()) {
+        return;
+    }
+    append({name, detail::nowNs(), -1, reinterpret_cast<quintptr>(QThread::currentThreadId())});
+}
+
+void flush()
+{
+    if (!isEnabled()) {
+        return;
+    }
+
+    QVector<TraceEvent> snapshot;
+    {
+        QMutexLocker locker(&eventsMutex());
+        snapshot = events();
+    }
+
+    QByteArray json;
+    json.reserve(128 + snapshot.size() * 112);
+    json.append("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    const qint64 pid = QCoreApplication::applicationPid();
+    for (qsizetype i = 0; i < snapshot.size(); ++i) {
+        const TraceEvent &ev = snapshot.at(i);
+        json.append("{\"name\":");
+        appendJsonString(json, ev.name);
+        json.append(",\"cat\":\"proyecto_IHM\",\"pid\":").append(QByteArray::number(pid));
+        json.append(",\"tid\":").append(QByteArray::number(static_cast<qulonglong>(ev.threadId)));
+        json.append(",\"ts\":").append(QByteArray::number(ev.startNs / 1000.0, 'f', 3));
+        if (ev.durationNs < 0) {
+            json.append(",\"ph\":\"i\",\"s\":\"p\"}");
+        } else {
+            json.append(",\"ph\":\"X\",\"dur\":").append(QByteArray::number(ev.durationNs / 1000.0, 'f', 3));
+            json.append('}');
+        }
+        json.append(i + 1 < snapshot.size() ? ",\n" : "\n");
+    }
+    json.append("]}\n");
+
+    QFile file(outputPath());
+    if (file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        file.write(json);
+    } else {
+        qWarning("No se pudo escribir la traza en %s", qPrintable(outputPath()));
+    }
+}
+}
@@ -0,0 +1,59 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+// Trazas de fases (arranque, carga de datos...) en formato chrome://tracing.
+//
+// Se activan definiendo PROYECTO_IHM_TRACE con la ruta del JSON de salida:
+//   PROYECTO_IHM_TRACE=/tmp/arranque.json ./proyecto_IHM
+// Desactivadas, cada TRACE_SCOPE cuesta una lectura de un bool: no se consulta el reloj ni se reserva memoria.
+
+namespace Trace {
+namespace detail {
+extern bool g_enabled;
+void record(const char *name, long long startNs, long long endNs);
+long long nowNs();
+}
+
+// Lee PROYECTO_IHM_TRACE; llamar al principio de main, antes de crear hilos
+void initFromEnvironment();
+inline bool isEnabled() { return detail::g_enabled; }
+
+// Evento puntual (p.ej. "primer ciclo del bucle de eventos")
+void instant(const char *name);
+
+// Escribe (o reescribe) el fichero JSON con todos los eventos registrados hasta ahora
+void flush();
+}
+
+class ScopedTrace
+{
+public:
+    // name debe ser un literal: solo se guarda el puntero
+    explicit ScopedTrace(const char *name)
+        : m_name(Trace::isEnabled() ? name : nullptr)
+    {
+        if (m_name) {
+            m_startNs = Trace::detail::nowNs();
+        }
+    }
+
+    ~ScopedTrace()
+    {
+        if (m_name) {
+            Trace::detail::record(m_name, m_startNs, Trace::detail::nowNs());
+        }
+    }
+
+    ScopedTrace(const ScopedTrace &) = delete;
+    ScopedTrace &operator=(const ScopedTrace &) = delete;
+
+private:
+    const char *m_name;
+    long long m_startNs = 0;
+};
+
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+#define TRACE_SCOPE(name) ScopedTrace TRACE_CONCAT(traceScope_, __LINE__)(name)
+
+#endif // TRACE_H
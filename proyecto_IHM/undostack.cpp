@@ -0,0 +1,192 @@
+#include "undostack.h"
+
+#include <QtEndian>
+
+#include <algorithm>
+
+namespace {
+constexpr int kChunkHeaderSize = 4;
+
+// Los inversos de cada cambio forman un bloque con su longitud delante: al deshacer se recorren
+// los bloques de atras hacia delante, pero dentro de cada bloque se aplican en orden
+QByteArray undoChunk(const QVector<BoardOp> &inverse)
+{
+    QByteArray body;
+    for (const BoardOp &op : inverse) {
+        body += BoardFile::encodeOp(op);
+    }
+    QByteArray chunk(kChunkHeaderSize, Qt::Uninitialized);
+    qToLittleEndian(static_cast<quint32>(body.size()), chunk.data());
+    chunk += body;
+    return chunk;
+}
+}
+
+void UndoStack::record(const BoardOp &op, const QVector<BoardOp> &inverse)
+{
+    const QByteArray redo = BoardFile::encodeOp(op);
+    const QByteArray undo = undoChunk(inverse);
+    if (m_groupDepth > 0) {
+        m_groupRedo += redo;
+        m_groupUndo += undo;
+        return;
+    }
+    pushStep(redo, undo);
+}
+
+void UndoStack::beginGroup()
+{
+    ++m_groupDepth;
+}
+
+void UndoStack::endGroup()
+{
+    if (m_groupDepth == 0 || --m_groupDepth > 0) {
+        return;
+    }
+    if (!m_groupRedo.isEmpty()) {
+        pushStep(m_groupRedo, m_groupUndo);
+    }
+    m_groupRedo.clear();
+    m_groupUndo.clear();
+}
+
+void UndoStack::pushStep(const QByteArray &redo, const QByteArray &undo)
+{
+    // Un cambio nuevo descarta lo que se podia rehacer
+    if (m_position < m_steps.size()) {
+        const qint64 end = m_position > 0
+                ? m_steps[m_position - 1].offset + m_steps[m_position - 1].redoBytes + m_steps[m_position - 1].undoBytes
+                : 0;
+        m_arena.truncate(end);
+        m_steps.resize(m_position);
+    }
+
+    Step step;
+    step.offset = m_arena.size();
+    step.redoBytes = static_cast<quint32>(redo.size());
+    step.undoBytes = static_cast<quint32>(undo.size());
+    m_arena += redo;
+    m_arena += undo;
+    m_steps.append(step);
+    m_position = m_steps.size();
+    trim();
+}
+
+void UndoStack::trim()
+{
+    if (m_steps.size() <= kMaxSteps && m_arena.size() <= kMaxArenaBytes) {
+        return;
+    }
+
+    // Se baja a 3/4 del limite para no repetir el desplazamiento del buffer en cada paso
+    int drop = std::max<int>(0, m_steps.size() - kMaxSteps * 3 / 4);
+    while (drop < m_steps.size() - 1 && m_arena.size() - m_steps[drop].offset > kMaxArenaBytes * 3 / 4) {
+        ++drop;
+    }
+    drop = std::min(drop, m_position);
+    if (drop == 0) {
+        return;
+    }
+
+    const qint64 cut = drop < m_steps.size() ? m_steps[drop].offset : m_arena.size();
+    m_arena.remove(0, cut);
+    m_steps.remove(0, drop);
+    for (Step &step : m_steps) {
+        step.offset -= cut;
+    }
+    m_position -= drop;
+}
+
+QVector<BoardOp> UndoStack::undo()
+{
+    if (!canUndo()) {
+        return {};
+    }
+    const Step &step = m_steps[--m_position];
+    const char *data = m_arena.constData() + step.offset + step.redoBytes;
+
+    QVector<QPair<const char*, qint64>> chunks;
+    qint64 offset = 0;
+    while (step.undoBytes - offset >= kChunkHeaderSize) {
+        const quint32 length = qFromLittleEndian<quint32>(data + offset);
+        chunks.append({data + offset + kChunkHeaderSize, length});
+        offset += kChunkHeaderSize + length;
+    }
+
+    QVector<BoardOp> ops;
+    for (auto it = chunks.crbegin(); it != chunks.crend(); ++it) {
+        ops += decode(it->first, it->second);
+    }
+    return ops;
+}
+
+QVector<BoardOp> UndoStack::redo()
+{
+    if (!canRedo()) {
+        return {};
+    }
+    const Step &step = m_steps[m_position++];
+    return decode(m_arena.constData() + step.offset, step.redoBytes);
+}
+
+void UndoStack::clear()
+{
+    m_arena.clear();
+    m_steps.clear();
+    m_position = 0;
+    m_groupRedo.clear();
+    m_groupUndo.clear();
+}
+
+QVector<BoardOp> UndoStack::decode(const char *data, qint64 size)
+{
+    QVector<BoardOp> ops;
+    const auto *bytes = reinterpret_cast<const uchar*>(data);
+    qint64 offset = 0;
+    while (offset < size) {
+        BoardOp op;
+        const qint64 used = BoardFile::decodeOp(bytes + offset, size - offset, &op);
+        if (used == 0) {
+            break;
+        }
+        ops.append(op);
+        offset += used;
+    }
+    return ops;
+}
+
+BoardOp UndoStack::inverseOf(const BoardOp &op)
+{
+    BoardOp inverse = op;
+    switch (op.type) {
+    case BoardOp::Type::AddPoint:
+        inverse.type = BoardOp::Type::ErasePoint;
+        break;
+    case BoardOp::Type::AddLine:
+        inverse.type = BoardOp::Type::EraseLine;
+        break;
+    case BoardOp::Type::AddArc:
+        inverse.type = BoardOp::Type::EraseArc;
+        break;
+    case BoardOp::Type::ErasePoint:
+        inverse.type = BoardOp::Type::AddPoint;
+        break;
+    case BoardOp::Type::EraseLine:
+        inverse.type = BoardOp::Type::AddLine;
+        break;
+    case BoardOp::Type::EraseArc:
+        inverse.type = BoardOp::Type::AddArc;
+        break;
+    case BoardOp::Type::AddText:
+        inverse.type = BoardOp::Type::EraseText;
+        break;
+    case BoardOp::Type::EraseText:
+        inverse.type = BoardOp::Type::AddText;
+        break;
+    case BoardOp::Type::UpdateText:
+    case BoardOp::Type::Clear:
+        break; // dependen del estado anterior: los aporta quien registra
+    }
+    return inverse;
+}
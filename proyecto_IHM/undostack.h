@@ -0,0 +1,54 @@
+#ifndef UNDOSTACK_H
+#define UNDOSTACK_H
+
+#include "boardfile.h"
+
+#include <QByteArray>
+#include <QVector>
+
+// Historial de deshacer/rehacer de la pizarra. Cada paso guarda los cambios codificados (mismos
+// registros que el diario: ids mas parametros) y su inverso, todo en un unico buffer contiguo;
+// no hay copias de la escena. Al superar el limite se descarta de golpe la parte mas antigua.
+class UndoStack
+{
+public:
+    // Registra op, que ya se ha aplicado; inverse lo deshace (aplicado en orden)
+    void record(const BoardOp &op, const QVector<BoardOp> &inverse);
+    // Todo lo registrado entre begin y end es un unico paso (p. ej. un trazo del borrador)
+    void beginGroup();
+    void endGroup();
+
+    bool canUndo() const { return m_position > 0; }
+    bool canRedo() const { return m_position < m_steps.size(); }
+    // Cambios a aplicar para deshacer/rehacer el paso actual (vacio si no hay)
+    QVector<BoardOp> undo();
+    QVector<BoardOp> redo();
+    void clear();
+
+    // Inverso de un alta o un borrado: el mismo registro con el tipo contrario
+    static BoardOp inverseOf(const BoardOp &op);
+
+private:
+    struct Step {
+        qint64 offset = 0;       // en m_arena: [cambios][inversos]
+        quint32 redoBytes = 0;
+        quint32 undoBytes = 0;
+    };
+
+    static constexpr int kMaxSteps = 5000;
+    static constexpr qint64 kMaxArenaBytes = 16 * 1024 * 1024;
+
+    void pushStep(const QByteArray &redo, const QByteArray &undo);
+    void trim();
+    static QVector<BoardOp> decode(const char *data, qint64 size);
+
+    QByteArray m_arena;
+    QVector<Step> m_steps;
+    int m_position = 0;         // pasos aplicados; los siguientes son rehacibles
+
+    int m_groupDepth = 0;
+    QByteArray m_groupRedo;
+    QByteArray m_groupUndo;
+};
+
+#endif // UNDOSTACK_H
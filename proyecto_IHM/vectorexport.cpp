@@ -0,0 +1,322 @@
+#include "vectorexport.h"
+#include "chartexporter.h"
+#include "dibujos.h"
+#include "exportcommon.h"
+
+#include <QBuffer>
+#include <QImageWriter>
+#include <QPageLayout>
+#include <QPageSize>
+#include <QPainter>
+#include <QPdfWriter>
+#include <QSaveFile>
+#include <QStringList>
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+using ExportCommon::fail;
+using ExportCommon::kTextInset;
+constexpr double kPointRadius = Dibujos::kPointRadius;
+constexpr qsizetype kFlushBytes = 64 * 1024;
+
+QRectF exportRegion(const QRectF &chartRect, const VectorExport::Options &options)
+{
+    return ExportCommon::exportRegion(chartRect, options.region);
+}
+
+// Una sola lectura de la carta bajo region, con el lado mayor limitado a maxSide
+QImage chartPiece(const QString &chartPath, const QRectF &chartRect, const QRectF &region, int maxSide,
+                  QRectF *pieceRect)
+{
+    const QRectF source = region.intersected(chartRect);
+    if (source.isEmpty()) {
+        return QImage();
+    }
+    const double factor = std::min(1.0, double(maxSide) / std::max(source.width(), source.height()));
+    return ExportCommon::chartPiece(chartPath, chartRect, source, factor, pieceRect);
+}
+
+// Salida SVG en un buffer que se vuelca al fichero cada kFlushBytes
+class SvgStream
+{
+public:
+    explicit SvgStream(QSaveFile *file) : m_file(file) { m_out.reserve(kFlushBytes * 2); }
+
+    SvgStream &operator<<(const char *text)
+    {
+        m_out += text;
+        return *this;
+    }
+    SvgStream &operator<<(const QByteArray &text)
+    {
+        m_out += text;
+        return *this;
+    }
+    SvgStream &operator<<(double value)
+    {
+        m_out += QByteArray::number(value, 'f', 2);
+        return *this;
+    }
+    SvgStream &operator<<(const QString &text)
+    {
+        m_out += text.toHtmlEscaped().toUtf8();
+        return *this;
+    }
+
+    // Atributo de color (fill o stroke) y su opacidad si no es opaco
+    void color(const char *attribute, QRgb rgba)
+    {
+        m_out += ' ';
+        m_out += attribute;
+        m_out += "=\"#";
+        m_out += QByteArray::number(rgba & 0xFFFFFF, 16).rightJustified(6, '0');
+        m_out += '"';
+        if (qAlpha(rgba) != 255) {
+            m_out += ' ';
+            m_out += attribute;
+            m_out += "-opacity=\"";
+            m_out += QByteArray::number(qAlpha(rgba) / 255.0, 'f', 3);
+            m_out += '"';
+        }
+    }
+
+    void flushIfFull()
+    {
+        if (m_out.size() >= kFlushBytes) {
+            flush();
+        }
+    }
+    bool flush()
+    {
+        const bool ok = m_file->write(m_out) == m_out.size();
+        m_out.clear();
+        return ok;
+    }
+
+private:
+    QSaveFile *m_file;
+    QByteArray m_out;
+};
+
+// Las primitivas consecutivas con el mismo estilo comparten un <g>, asi que cada una solo lleva
+// su geometria
+struct StrokeStyle {
+    QRgb color = 0;
+    float width = 0.0f;
+    bool operator==(const StrokeStyle &other) const { return color == other.color && width == other.width; }
+};
+
+void openStrokeGroup(SvgStream &svg, const StrokeStyle &style)
+{
+    svg << "<g";
+    svg.color("stroke", style.color);
+    svg << " stroke-width=\"" << double(style.width) << "\">\n";
+}
+}
+
+namespace VectorExport {
+
+bool writeSvg(const QString &path, const QString &chartPath, const QRectF &chartRect,
+              const BoardData &board, const Options &options, QString *error)
+{
+    const QRectF region = exportRegion(chartRect, options);
+    if (region.isEmpty()) {
+        return fail(error, QStringLiteral("la zona a exportar esta vacia"));
+    }
+
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return fail(error, file.errorString());
+    }
+    SvgStream svg(&file);
+
+    // Tamano fisico como en la exportacion de imagen: la carta a ChartExporter::kChartDpi
+    const double mmPerUnit = 25.4 / ChartExporter::kChartDpi;
+    svg << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+        << "<svg xmlns=\"http://www.w3.org/2000/svg\" xmlns:xlink=\"http://www.w3.org/1999/xlink\""
+        << " width=\"" << region.width() * mmPerUnit << "mm\" height=\"" << region.height() * mmPerUnit << "mm\""
+        << " viewBox=\"" << region.x() << " " << region.y() << " " << region.width() << " " << region.height()
+        << "\">\n";
+
+    // Carta: una sola imagen JPEG incrustada
+    QRectF pieceRect;
+    const QImage piece = chartPiece(chartPath, chartRect, region, options.chartMaxSide, &pieceRect);
+    if (!piece.isNull()) {
+        QBuffer jpeg;
+        jpeg.open(QIODevice::WriteOnly);
+        QImageWriter writer(&jpeg, "jpg");
+        writer.setQuality(85);
+        writer.write(piece.convertToFormat(QImage::Format_RGB32));
+        svg << "<g id=\"carta\"><image x=\"" << pieceRect.x() << "\" y=\"" << pieceRect.y()
+            << "\" width=\"" << pieceRect.width() << "\" height=\"" << pieceRect.height()
+            << "\" preserveAspectRatio=\"none\" xlink:href=\"data:image/jpeg;base64,";
+        svg.flush();
+        file.write(jpeg.data().toBase64());
+        svg << "\"/></g>\n";
+    }
+
+    const auto shown = [&region](const QRectF &bounds) { return region.intersects(bounds); };
+
+    svg << "<g id=\"lineas\" fill=\"none\" stroke-linecap=\"square\">\n";
+    bool groupOpen = false;
+    StrokeStyle style;
+    for (const BoardLine &line : board.lines) {
+        const double pad = line.width;
+        if (!shown(QRectF(line.line.p1(), line.line.p2()).normalized().adjusted(-pad, -pad, pad, pad))) {
+            continue;
+        }
+        const StrokeStyle lineStyle{line.color, line.width};
+        if (!groupOpen || !(lineStyle == style)) {
+            if (groupOpen) {
+                svg << "</g>\n";
+            }
+            openStrokeGroup(svg, lineStyle);
+            style = lineStyle;
+            groupOpen = true;
+        }
+        svg << "<path d=\"M" << line.line.x1() << " " << line.line.y1()
+            << "L" << line.line.x2() << " " << line.line.y2() << "\"/>\n";
+        svg.flushIfFull();
+    }
+    if (groupOpen) {
+        svg << "</g>\n";
+    }
+    svg << "</g>\n";
+
+    svg << "<g id=\"arcos\" fill=\"none\" stroke-linecap=\"round\" stroke-linejoin=\"round\">\n";
+    groupOpen = false;
+    for (const BoardArc &arc : board.arcs) {
+        const ArcPrimitive &a = arc.arc;
+        const double pad = arc.width;
+        if (a.radius <= 0.0
+            || !shown(QRectF(a.center.x() - a.radius - pad, a.center.y() - a.radius - pad,
+                             (a.radius + pad) * 2.0, (a.radius + pad) * 2.0))) {
+            continue;
+        }
+        const StrokeStyle arcStyle{arc.color, arc.width};
+        if (!groupOpen || !(arcStyle == style)) {
+            if (groupOpen) {
+                svg << "</g>\n";
+            }
+            openStrokeGroup(svg, arcStyle);
+            style = arcStyle;
+            groupOpen = true;
+        }
+
+        // Angulos de Qt (antihorario en pantalla) -> sweep-flag 0. Una vuelta completa va en dos mitades.
+        const double span = std::clamp(a.spanDeg, -360.0, 360.0);
+        const int pieces = std::abs(span) > 359.9 ? 2 : 1;
+        const char *sweep = span > 0.0 ? "0" : "1";
+        const QPointF start = arcPointAt(a, a.startDeg);
+        svg << "<path d=\"M" << start.x() << " " << start.y();
+        for (int i = 1; i <= pieces; ++i) {
+            const QPointF end = arcPointAt(a, a.startDeg + span * i / pieces);
+            svg << "A" << a.radius << " " << a.radius << " 0 "
+                << (std::abs(span) / pieces > 180.0 ? "1 " : "0 ") << sweep << " "
+                << end.x() << " " << end.y();
+        }
+        svg << "\"/>\n";
+        svg.flushIfFull();
+    }
+    if (groupOpen) {
+        svg << "</g>\n";
+    }
+    svg << "</g>\n";
+
+    svg << "<g id=\"puntos\" stroke-width=\"2\">\n";
+    groupOpen = false;
+    QRgb pointColor = 0;
+    for (const BoardPoint &point : board.points) {
+        const double r = kPointRadius + 1.0;
+        if (!shown(QRectF(point.pos.x() - r, point.pos.y() - r, r * 2.0, r * 2.0))) {
+            continue;
+        }
+        if (!groupOpen || point.color != pointColor) {
+            if (groupOpen) {
+                svg << "</g>\n";
+            }
+            svg << "<g";
+            svg.color("fill", point.color);
+            svg.color("stroke", point.color);
+            svg << ">\n";
+            pointColor = point.color;
+            groupOpen = true;
+        }
+        svg << "<circle cx=\"" << point.pos.x() << "\" cy=\"" << point.pos.y()
+            << "\" r=\"" << kPointRadius << "\"/>\n";
+        svg.flushIfFull();
+    }
+    if (groupOpen) {
+        svg << "</g>\n";
+    }
+    svg << "</g>\n";
+
+    // Textos: una linea por parrafo (SVG 1.1 no reparte el texto en el ancho del cuadro)
+    svg << "<g id=\"textos\" font-family=\"sans-serif\">\n";
+    for (const BoardText &text : board.texts) {
+        if (text.text.isEmpty() || !shown(QRectF(text.pos, text.size))) {
+            continue;
+        }
+        const double px = (text.fontSize > 0.0f ? text.fontSize : 64.0) * 96.0 / 72.0;
+        svg << "<text font-size=\"" << px << "\"";
+        svg.color("fill", text.color);
+        svg << ">";
+        const QStringList lines = text.text.split(QLatin1Char('\n'));
+        for (int i = 0; i < lines.size(); ++i) {
+            svg << "<tspan x=\"" << text.pos.x() + kTextInset << "\" y=\""
+                << text.pos.y() + kTextInset + px * (0.9 + 1.2 * i) << "\">" << lines.at(i) << "</tspan>";
+        }
+        svg << "</text>\n";
+        svg.flushIfFull();
+    }
+    svg << "</g>\n</svg>\n";
+
+    if (!svg.flush() || !file.commit()) {
+        return fail(error, file.errorString());
+    }
+    return true;
+}
+
+bool writePdf(const QString &path, const QString &chartPath, const QRectF &chartRect,
+              const BoardData &board, const Options &options, QString *error)
+{
+    const QRectF region = exportRegion(chartRect, options);
+    if (region.isEmpty()) {
+        return fail(error, QStringLiteral("la zona a exportar esta vacia"));
+    }
+
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return fail(error, file.errorString());
+    }
+    {
+        // A kChartDpi una unidad de la escena es un punto del dispositivo: se pinta en coordenadas de la carta
+        QPdfWriter writer(&file);
+        writer.setResolution(qRound(ChartExporter::kChartDpi));
+        writer.setPageLayout(QPageLayout(QPageSize(region.size() / ChartExporter::kChartDpi, QPageSize::Inch,
+                                                   QString(), QPageSize::ExactMatch),
+                                         QPageLayout::Portrait, QMarginsF()));
+        QPainter painter;
+        if (!painter.begin(&writer)) {
+            return fail(error, QStringLiteral("no se pudo crear el PDF"));
+        }
+        painter.setRenderHint(QPainter::Antialiasing);
+        painter.translate(-region.topLeft());
+        painter.setClipRect(region);
+
+        QRectF pieceRect;
+        const QImage piece = chartPiece(chartPath, chartRect, region, options.chartMaxSide, &pieceRect);
+        if (!piece.isNull()) {
+            painter.drawImage(pieceRect, piece);
+        }
+        ChartExporter::paintBoard(&painter, board, region);
+    }
+    if (!file.commit()) {
+        return fail(error, file.errorString());
+    }
+    return true;
+}
+
+} // namespace VectorExport
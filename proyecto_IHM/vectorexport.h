@@ -0,0 +1,27 @@
+#ifndef VECTOREXPORT_H
+#define VECTOREXPORT_H
+
+#include "boardfile.h"
+
+#include <QRectF>
+#include <QString>
+
+// Exportacion vectorial de la pizarra: lineas, arcos, puntos y textos como trazados en coordenadas
+// de la carta, por encima de una unica copia reducida de la carta. El SVG se escribe directamente
+// desde los arrays de BoardData (sin QSvgGenerator ni un item por primitiva); el PDF pinta las
+// mismas primitivas con QPdfWriter, que las guarda como trazados.
+namespace VectorExport {
+
+struct Options {
+    QRectF region;              // zona de la carta; vacia = toda
+    int chartMaxSide = 2048;    // lado mayor, en pixeles, de la carta incrustada
+};
+
+bool writeSvg(const QString &path, const QString &chartPath, const QRectF &chartRect,
+              const BoardData &board, const Options &options, QString *error = nullptr);
+bool writePdf(const QString &path, const QString &chartPath, const QRectF &chartRect,
+              const BoardData &board, const Options &options, QString *error = nullptr);
+
+} // namespace VectorExport
+
+#endif // VECTOREXPORT_H